@@ -0,0 +1,264 @@
+/**
+ * @file synthetic_data_generator.cxx Command line front end to SyntheticGenerator
+ *
+ * Generates one stream per link, in memory or into one file per link, on a
+ * pool of threads, and reports the aggregate throughput and injected faults.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/SyntheticGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <getopt.h>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+void
+usage(const char* name)
+{
+  std::cerr
+    << "Usage: " << name << " [options]\n"
+    << "  --format fwtp|wib|hsi|daq|eth  Frame format (default fwtp)\n"
+    << "  --links N                      Number of streams (default 1)\n"
+    << "  --threads N                    Worker threads (default: hardware concurrency)\n"
+    << "  --bytes N[K|M|G]               Bytes per link (default 1G)\n"
+    << "  --output PREFIX                Write PREFIX_<link>.bin; without it data is only generated in memory\n"
+    << "  --chunk N[K|M|G]               Buffer size per generate() call (default 4M)\n"
+    << "  --seed N                       Random seed (default 1)\n"
+    << "  --channels N                   TP: wires per link (default 256)\n"
+    << "  --hit-rate HZ                  TP: hits per second per wire (default 1000)\n"
+    << "  --periodic                     TP: evenly spaced instead of Poisson arrivals\n"
+    << "  --nhits-mean X                 TP: nhits is 1 + Poisson(X - 1) (default 1)\n"
+    << "  --payload N                    daq/eth: payload bytes per frame (default 7200)\n"
+    << "  --period N                     hsi/daq/eth: ticks between frames (default 2048)\n"
+    << "  --gap P --corrupt P --reorder P  Fault probabilities per frame (default 0)\n";
+}
+
+uint64_t // NOLINT(build/unsigned)
+parse_size(const std::string& s)
+{
+  std::size_t digits = 0;
+  uint64_t value = std::stoull(s, &digits); // NOLINT(build/unsigned)
+  const char* end = s.c_str() + digits;
+  if (*end != '\0' && end[1] != '\0')
+    throw std::invalid_argument("bad size " + s);
+  switch (*end) {
+    case 'G':
+    case 'g':
+      value <<= 10;
+      [[fallthrough]];
+    case 'M':
+    case 'm':
+      value <<= 10;
+      [[fallthrough]];
+    case 'K':
+    case 'k':
+      value <<= 10;
+      break;
+    case '\0':
+      break;
+    default:
+      throw std::invalid_argument("bad size " + s);
+  }
+  return value;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  SyntheticConfig base;
+  unsigned n_links = 1;
+  unsigned n_threads = std::max(1u, std::thread::hardware_concurrency());
+  uint64_t bytes_per_link = 1ULL << 30; // NOLINT(build/unsigned)
+  std::size_t chunk_bytes = 4 << 20;
+  std::string output;
+
+  const option options[] = { { "format", required_argument, nullptr, 'f' },
+                             { "links", required_argument, nullptr, 'l' },
+                             { "threads", required_argument, nullptr, 't' },
+                             { "bytes", required_argument, nullptr, 'b' },
+                             { "output", required_argument, nullptr, 'o' },
+                             { "chunk", required_argument, nullptr, 'c' },
+                             { "seed", required_argument, nullptr, 's' },
+                             { "channels", required_argument, nullptr, 'n' },
+                             { "hit-rate", required_argument, nullptr, 'r' },
+                             { "periodic", no_argument, nullptr, 'P' },
+                             { "nhits-mean", required_argument, nullptr, 'N' },
+                             { "payload", required_argument, nullptr, 'p' },
+                             { "period", required_argument, nullptr, 'T' },
+                             { "gap", required_argument, nullptr, 'g' },
+                             { "corrupt", required_argument, nullptr, 'C' },
+                             { "reorder", required_argument, nullptr, 'R' },
+                             { "help", no_argument, nullptr, 'h' },
+                             { nullptr, 0, nullptr, 0 } };
+
+  int opt;
+  int index = -1;
+  try {
+    while ((opt = getopt_long(argc, argv, "h", options, &index)) != -1) {
+      const std::string arg = optarg ? optarg : "";
+      switch (opt) {
+        case 'f':
+          if (arg == "fwtp")
+            base.format = SyntheticFormat::kFwtp;
+          else if (arg == "wib")
+            base.format = SyntheticFormat::kWIBTp;
+          else if (arg == "hsi")
+            base.format = SyntheticFormat::kHSI;
+          else if (arg == "daq")
+            base.format = SyntheticFormat::kDAQHeader;
+          else if (arg == "eth")
+            base.format = SyntheticFormat::kDAQEthHeader;
+          else {
+            usage(argv[0]);
+            return 1;
+          }
+          break;
+        case 'l':
+          n_links = std::stoul(arg);
+          if (n_links == 0)
+            throw std::invalid_argument("no links");
+          break;
+        case 't':
+          n_threads = std::max(1ul, std::stoul(arg));
+          break;
+        case 'b':
+          bytes_per_link = parse_size(arg);
+          break;
+        case 'o':
+          output = arg;
+          break;
+        case 'c':
+          chunk_bytes = parse_size(arg);
+          break;
+        case 's':
+          base.seed = std::stoull(arg);
+          break;
+        case 'n':
+          base.n_channels = std::stoul(arg);
+          break;
+        case 'r':
+          base.hit_rate_hz = std::stod(arg);
+          break;
+        case 'P':
+          base.poisson_arrivals = false;
+          break;
+        case 'N':
+          base.nhits = std::stod(arg) > 1 ? SyntheticDistribution::poisson(std::stod(arg) - 1, 1)
+                                          : SyntheticDistribution::fixed(1);
+          break;
+        case 'p':
+          base.payload_bytes = parse_size(arg);
+          break;
+        case 'T':
+          base.frame_period = std::stoull(arg);
+          break;
+        case 'g':
+          base.faults.gap = std::stod(arg);
+          break;
+        case 'C':
+          base.faults.corruption = std::stod(arg);
+          break;
+        case 'R':
+          base.faults.reorder = std::stod(arg);
+          break;
+        default:
+          usage(argv[0]);
+          return opt == 'h' ? 0 : 1;
+      }
+    }
+  } catch (const std::logic_error&) {
+    // std::invalid_argument or std::out_of_range from a number conversion
+    std::cerr << "Bad value for --" << (index >= 0 ? options[index].name : "?") << '\n';
+    usage(argv[0]);
+    return 1;
+  }
+
+  // Spread the links over the link, slot and crate fields of the format's header
+  unsigned link_range = 64, slot_range = 16;
+  if (base.format == SyntheticFormat::kWIBTp)
+    link_range = slot_range = 8;
+  else if (base.format == SyntheticFormat::kDAQEthHeader)
+    link_range = 256;
+
+  std::vector<SyntheticGenerator> generators;
+  try {
+    for (unsigned i = 0; i < n_links; ++i) {
+      SyntheticConfig config = base;
+      config.link = i % link_range;
+      config.slot = (i / link_range) % slot_range;
+      config.crate = i / (link_range * slot_range);
+      generators.emplace_back(config);
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
+  const unsigned n_used = std::min(n_threads, n_links);
+  const auto start = std::chrono::steady_clock::now();
+  try {
+    if (!output.empty()) {
+      std::vector<std::string> paths;
+      for (unsigned i = 0; i < n_links; ++i)
+        paths.push_back(output + "_" + std::to_string(i) + ".bin");
+      write_files_parallel(generators, paths, bytes_per_link, chunk_bytes, n_threads);
+    } else {
+      // One chunk per link and round, sized so that a round holds about n_threads chunks in total
+      std::size_t link_chunk = std::max<std::size_t>(chunk_bytes / std::max(1u, n_links / n_used), 1);
+      for (auto const& gen : generators)
+        link_chunk = std::max(link_chunk, 2 * gen.max_frame_size());
+      std::vector<unsigned char> memory(link_chunk * n_links);
+      std::vector<uint64_t> done(n_links, 0); // NOLINT(build/unsigned)
+      std::vector<std::pair<void*, std::size_t>> buffers(n_links);
+      for (bool more = true; more;) {
+        for (unsigned i = 0; i < n_links; ++i)
+          buffers[i] = { memory.data() + i * link_chunk, std::min<uint64_t>(link_chunk, bytes_per_link - done[i]) };
+        const auto written = generate_parallel(generators, buffers, n_threads);
+        more = false;
+        for (unsigned i = 0; i < n_links; ++i) {
+          done[i] += written[i];
+          more |= written[i] > 0 && done[i] < bytes_per_link;
+        }
+      }
+    }
+  } catch (const std::exception& e) {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+  const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  SyntheticGenerator::Counters total;
+  for (auto const& gen : generators) {
+    const auto c = gen.counters();
+    total.frames += c.frames;
+    total.bytes += c.bytes;
+    total.hits += c.hits;
+    total.gaps += c.gaps;
+    total.corrupted += c.corrupted;
+    total.reordered += c.reordered;
+  }
+  std::cout << "Links:     " << n_links << " on " << n_used << " threads\n"
+            << "Frames:    " << total.frames << " (" << total.hits << " hits)\n"
+            << "Bytes:     " << total.bytes / 1e9 << " GB in " << seconds << " s, " << total.bytes / seconds / 1e9
+            << " GB/s\n"
+            << "Faults:    " << total.gaps << " gaps, " << total.corrupted << " corrupted, " << total.reordered
+            << " reordered\n";
+  return 0;
+}
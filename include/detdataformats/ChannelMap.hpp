@@ -0,0 +1,188 @@
+/**
+ * @file ChannelMap.hpp Dense lookup table from TpHeader geometry fields to offline channel numbers
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_CHANNELMAP_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_CHANNELMAP_HPP_
+
+#include "detdataformats/fwtp/RawTp.hpp"
+#include "detdataformats/wib/RawWIBTp.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief Bit layout of the geometry fields in the first word of a fwtp::TpHeader
+ * (wire:8, slot:4, flags:4, crate:10, fiber:6).
+ *
+ * The link key packs slot, crate and fiber in header bit order, dropping the wire and flags bits.
+ */
+struct FwtpChannelLayout
+{
+  using header_t = fwtp::TpHeader;
+  using data_t = fwtp::TpData;
+
+  static constexpr unsigned s_crate_bits = 10;
+  static constexpr unsigned s_slot_bits = 4;
+  static constexpr unsigned s_fiber_bits = 6;
+  static constexpr unsigned s_wire_bits = 8;
+  static constexpr unsigned s_link_key_bits = s_slot_bits + s_crate_bits + s_fiber_bits;
+
+  static constexpr uint32_t link_key(uint32_t word) noexcept // NOLINT(build/unsigned)
+  {
+    return ((word >> 8) & 0xF) | ((word >> 16) << 4);
+  }
+  static constexpr uint32_t wire(uint32_t word) noexcept { return word & 0xFF; } // NOLINT(build/unsigned)
+
+  static constexpr uint32_t pack_link(uint32_t crate, uint32_t slot, uint32_t fiber) noexcept // NOLINT(build/unsigned)
+  {
+    return slot | (crate << s_slot_bits) | (fiber << (s_slot_bits + s_crate_bits));
+  }
+};
+
+/**
+ * @brief Bit layout of the geometry fields in the first word of a wib::TpHeader
+ * (flags:13, slot:3, wire:8, fiber:3, crate:5).
+ */
+struct WIBChannelLayout
+{
+  using header_t = wib::TpHeader;
+  using data_t = wib::TpData;
+
+  static constexpr unsigned s_crate_bits = 5;
+  static constexpr unsigned s_slot_bits = 3;
+  static constexpr unsigned s_fiber_bits = 3;
+  static constexpr unsigned s_wire_bits = 8;
+  static constexpr unsigned s_link_key_bits = s_slot_bits + s_fiber_bits + s_crate_bits;
+
+  static constexpr uint32_t link_key(uint32_t word) noexcept // NOLINT(build/unsigned)
+  {
+    return ((word >> 13) & 0x7) | ((word >> 24) << 3);
+  }
+  static constexpr uint32_t wire(uint32_t word) noexcept { return (word >> 16) & 0xFF; } // NOLINT(build/unsigned)
+
+  static constexpr uint32_t pack_link(uint32_t crate, uint32_t slot, uint32_t fiber) noexcept // NOLINT(build/unsigned)
+  {
+    return slot | (fiber << s_slot_bits) | (crate << (s_slot_bits + s_fiber_bits));
+  }
+};
+
+/**
+ * @brief ChannelMap compiles a (crate, slot, fiber, wire) -> offline channel mapping into flat tables.
+ *
+ * Lookups are two array reads: the packed link bits of the header word select a dense link index
+ * (the table only spans the range of link keys actually mapped), and the wire number selects the
+ * channel inside that link's 256-entry block.
+ */
+template<class Layout>
+class ChannelMap
+{
+public:
+  using layout_t = Layout;
+  using header_t = typename Layout::header_t;
+  using channel_t = uint32_t; // NOLINT(build/unsigned)
+
+  static constexpr channel_t s_invalid_channel = std::numeric_limits<channel_t>::max();
+  static constexpr std::size_t s_wires_per_link = std::size_t(1) << Layout::s_wire_bits;
+
+  struct Entry
+  {
+    uint32_t crate; // NOLINT(build/unsigned)
+    uint32_t slot;  // NOLINT(build/unsigned)
+    uint32_t fiber; // NOLINT(build/unsigned)
+    uint32_t wire;  // NOLINT(build/unsigned)
+    channel_t channel;
+  };
+
+  ChannelMap() = default;
+  explicit ChannelMap(const std::vector<Entry>& entries);
+
+  /**
+   * @brief Add one mapping. Fields wider than the layout allows throw std::out_of_range.
+   * The tables are rebuilt lazily by compile().
+   */
+  void add(uint32_t crate, uint32_t slot, uint32_t fiber, uint32_t wire, channel_t channel); // NOLINT(build/unsigned)
+
+  /**
+   * @brief Build the lookup tables from the entries added so far.
+   */
+  void compile();
+
+  bool is_compiled() const noexcept { return m_compiled; }
+  std::size_t size() const noexcept { return m_entries.size(); }
+  const std::vector<Entry>& entries() const noexcept { return m_entries; }
+  std::size_t n_links() const noexcept { return m_wire_table.size() / s_wires_per_link; }
+
+  /**
+   * @brief Largest channel number in the compiled map, so that channel-indexed tables can be sized
+   * to max_channel() + 1. Returns s_invalid_channel for an empty map.
+   */
+  channel_t max_channel() const noexcept { return m_max_channel; }
+
+  channel_t lookup(uint32_t crate, uint32_t slot, uint32_t fiber, uint32_t wire) const noexcept; // NOLINT
+  channel_t lookup(const header_t& header) const noexcept { return lookup_word(first_word(header)); }
+
+  /**
+   * @brief Look up the channel for each of @p n headers; unmapped headers yield s_invalid_channel.
+   */
+  void lookup(const header_t* const* headers, std::size_t n, channel_t* out) const noexcept;
+
+  /**
+   * @brief Look up @p n headers laid out every @p stride bytes starting at @p first.
+   */
+  void lookup(const void* first, std::size_t n, std::size_t stride, channel_t* out) const noexcept;
+
+  /**
+   * @brief Read "crate slot fiber wire channel" lines; '#' starts a comment. Throws std::runtime_error.
+   */
+  static ChannelMap load(std::istream& is);
+  static ChannelMap load_from_file(const std::string& path);
+
+  static uint32_t first_word(const header_t& header) noexcept // NOLINT(build/unsigned)
+  {
+    uint32_t word; // NOLINT(build/unsigned)
+    std::memcpy(&word, &header, sizeof(word));
+    return word;
+  }
+
+  channel_t lookup_word(uint32_t word) const noexcept // NOLINT(build/unsigned)
+  {
+    const uint32_t key = Layout::link_key(word) - m_link_key_offset; // NOLINT(build/unsigned)
+    if (key >= m_link_table.size())
+      return s_invalid_channel;
+    const uint32_t link = m_link_table[key]; // NOLINT(build/unsigned)
+    if (link == s_no_link)
+      return s_invalid_channel;
+    return m_wire_table[link * s_wires_per_link + Layout::wire(word)];
+  }
+
+private:
+  static constexpr uint32_t s_no_link = std::numeric_limits<uint32_t>::max(); // NOLINT(build/unsigned)
+
+  std::vector<Entry> m_entries;
+  std::vector<uint32_t> m_link_table; // NOLINT(build/unsigned)
+  std::vector<channel_t> m_wire_table;
+  uint32_t m_link_key_offset{ 0 }; // NOLINT(build/unsigned)
+  channel_t m_max_channel{ s_invalid_channel };
+  bool m_compiled{ false };
+};
+
+using FwtpChannelMap = ChannelMap<FwtpChannelLayout>;
+using WIBChannelMap = ChannelMap<WIBChannelLayout>;
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/ChannelMap.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_CHANNELMAP_HPP_
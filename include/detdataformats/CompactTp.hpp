@@ -0,0 +1,103 @@
+/**
+ * @file CompactTp.hpp 16-byte in-memory record of one TP hit, and its conversion from/to raw TP frames
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_COMPACTTP_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_COMPACTTP_HPP_
+
+#include "detdataformats/ChannelMap.hpp"
+#include "detdataformats/TpFrame.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief One hit in 16 bytes: absolute start time, dense offline channel, time over threshold
+ * and ADC values.
+ *
+ * A single-hit raw frame takes 36 bytes. CompactTp keeps what latency buffers and trigger
+ * algorithms select on; it does not keep the peak time, tp_flags, m_hit_continue or the header
+ * pedestal fields, and time_over_threshold saturates at s_max_time_over_threshold ticks.
+ * Continued hits should be merged with TpStitcher first if their full extent matters.
+ */
+struct CompactTp
+{
+  static constexpr uint32_t s_max_channel = (1u << 20) - 1;             // NOLINT(build/unsigned)
+  static constexpr uint32_t s_max_time_over_threshold = (1u << 12) - 1; // NOLINT(build/unsigned)
+
+  uint64_t timestamp; ///< Header timestamp plus m_start_time // NOLINT(build/unsigned)
+  uint32_t channel : 20, time_over_threshold : 12; // NOLINT(build/unsigned)
+  uint16_t peak_adc; // NOLINT(build/unsigned)
+  uint16_t sum_adc;  // NOLINT(build/unsigned)
+
+  uint64_t end_time() const noexcept { return timestamp + time_over_threshold; } // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief CompactTpCodec packs raw TP frames into CompactTp records and unpacks records back into
+ * single-hit raw frames.
+ */
+template<class Layout>
+class CompactTpCodec
+{
+public:
+  using channel_map_t = ChannelMap<Layout>;
+  using header_t = typename Layout::header_t;
+  using data_t = typename Layout::data_t;
+
+  /// Size of the raw frame unpack() writes for each record
+  static constexpr std::size_t s_unpacked_size = sizeof(header_t) + sizeof(data_t);
+
+  struct Counters
+  {
+    uint64_t n_frames{ 0 };    // NOLINT(build/unsigned)
+    uint64_t n_hits{ 0 };      ///< Records produced // NOLINT(build/unsigned)
+    uint64_t n_unmapped{ 0 };  ///< Hits dropped because their frame's geometry is not mapped // NOLINT
+    uint64_t n_saturated{ 0 }; ///< Hits whose time over threshold was clamped // NOLINT(build/unsigned)
+  };
+
+  /**
+   * @brief The channel map must be compiled, must outlive the codec and its channels must fit
+   * in CompactTp::channel; std::invalid_argument otherwise.
+   */
+  explicit CompactTpCodec(const channel_map_t& channel_map);
+
+  /**
+   * @brief Append one record per hit of the complete raw TP frames in a buffer to @p out.
+   * @return Number of bytes consumed (a trailing truncated frame is left for the caller)
+   */
+  std::size_t pack(const void* buffer, std::size_t size, std::vector<CompactTp>& out);
+
+  /**
+   * @brief Write one single-hit raw frame per record, with the hit starting at the header
+   * timestamp, until @p capacity bytes are used. Throws std::out_of_range for a channel that
+   * the map does not know.
+   * @return Number of records unpacked
+   */
+  std::size_t unpack(const CompactTp* tps, std::size_t n, void* buffer, std::size_t capacity) const;
+
+  const Counters& counters() const noexcept { return m_counters; }
+
+private:
+  const channel_map_t& m_channel_map;
+  /// First header word carrying the geometry of each channel; 0 for unmapped channels
+  std::vector<uint32_t> m_geometry_word; // NOLINT(build/unsigned)
+  std::vector<bool> m_mapped;
+  Counters m_counters;
+};
+
+using FwtpCompactTpCodec = CompactTpCodec<FwtpChannelLayout>;
+using WIBCompactTpCodec = CompactTpCodec<WIBChannelLayout>;
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/CompactTp.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_COMPACTTP_HPP_
@@ -0,0 +1,160 @@
+/**
+ * @file DetIdDemux.hpp Parallel routing of DAQHeader/DAQEthHeader blocks by det_id
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_DETIDDEMUX_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_DETIDDEMUX_HPP_
+
+#include "detdataformats/DAQEthHeader.hpp"
+#include "detdataformats/DAQHeader.hpp"
+#include "detdataformats/DetID.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief A header-prefixed block, as a byte range of the demultiplexed buffer.
+ */
+struct BlockRef
+{
+  uint64_t offset; // NOLINT(build/unsigned)
+  uint64_t size;   // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief The blocks routed to one output, in buffer order.
+ */
+struct BlockRange
+{
+  const BlockRef* first;
+  const BlockRef* last;
+
+  const BlockRef* begin() const noexcept { return first; }
+  const BlockRef* end() const noexcept { return last; }
+  std::size_t size() const noexcept { return last - first; }
+  bool empty() const noexcept { return first == last; }
+};
+
+/**
+ * @brief DetIdDemux splits a buffer of @p Header-prefixed blocks into one output per
+ * DetID::Subdetector, without copying the blocks.
+ *
+ * Blocks are either all block_size bytes long or, for DAQEthHeader with a block_size of 0, a
+ * header followed by block_length 64-bit words. The blocks are cut into one contiguous range per
+ * thread; each thread counts the det_ids of its range, the counts are prefix-summed into a
+ * disjoint slice of one output array per (det_id, thread), and each thread then writes its block
+ * references into its slices. No locks are taken and every output keeps buffer order. det_ids
+ * that name no DetID::Subdetector, and kUnknown, go to the quarantine output.
+ */
+template<class Header>
+class DetIdDemux
+{
+public:
+  static constexpr std::size_t s_n_det_ids = 64;             ///< 6-bit det_id
+  static constexpr std::size_t s_quarantine = s_n_det_ids;  ///< Output index of unknown det_ids
+  static constexpr std::size_t s_n_outputs = s_n_det_ids + 1;
+
+  struct Config
+  {
+    std::size_t block_size{ 0 };          ///< Bytes per block; 0 frames DAQEthHeader blocks by block_length
+    std::size_t min_blocks_per_thread{ 4096 }; ///< Smaller buffers use fewer threads
+  };
+
+  /**
+   * @brief Throws std::invalid_argument for a block_size smaller than a header, or of 0 with
+   * DAQHeader, which carries no length.
+   */
+  explicit DetIdDemux(const Config& config);
+
+  /**
+   * @brief Route the complete blocks of @p buffer, replacing the previous outputs. Offsets are
+   * relative to @p buffer.
+   * @return Number of bytes consumed; a trailing truncated block must be passed again
+   */
+  std::size_t demux(const void* buffer,
+                    std::size_t size,
+                    unsigned n_threads = std::thread::hardware_concurrency());
+
+  /// Blocks of @p subdetector; empty for one routed to quarantine
+  BlockRange output(DetID::Subdetector subdetector) const noexcept;
+  /// Blocks whose det_id is not a known DetID::Subdetector
+  BlockRange quarantine() const noexcept { return range(s_quarantine); }
+
+  /// Whether blocks with @p det_id have their own output
+  bool is_known(unsigned det_id) const noexcept { return det_id < s_n_det_ids && m_route[det_id] != s_quarantine; }
+
+  std::size_t n_blocks() const noexcept { return m_blocks.size(); }
+  /// Threads used by the last demux()
+  unsigned n_threads_used() const noexcept { return m_n_threads_used; }
+
+private:
+  using count_t = std::array<std::size_t, s_n_outputs>;
+
+  BlockRange range(std::size_t output) const noexcept
+  {
+    return { m_blocks.data() + m_begin[output], m_blocks.data() + m_begin[output + 1] };
+  }
+
+  // Offsets of the variable-length blocks, plus the end of the last one; returns bytes consumed
+  std::size_t frame_blocks(const unsigned char* buffer, std::size_t size);
+
+  BlockRef block(std::size_t i) const noexcept;
+
+  /**
+   * @brief Threads kept across demux() calls. Worker t runs part t of each job of more than t
+   * parts; the destructor stops and joins them.
+   */
+  struct Workers
+  {
+    ~Workers();
+    void loop(unsigned t, uint64_t seen); // NOLINT(build/unsigned)
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::thread> threads; ///< threads[i] is worker i + 1
+    void (*call)(const void*, unsigned){ nullptr };
+    const void* context{ nullptr };
+    unsigned n_parts{ 0 };
+    unsigned n_busy{ 0 };
+    uint64_t generation{ 0 }; // NOLINT(build/unsigned)
+    bool stop{ false };
+  };
+
+  // Runs f(t, first, last) on n_threads parts of the input, part 0 on the calling thread; f must not throw
+  template<class F>
+  void run(unsigned n_threads, F&& f);
+
+  Config m_config;
+  std::array<uint8_t, s_n_det_ids> m_route; ///< det_id -> output // NOLINT(build/unsigned)
+  std::vector<BlockRef> m_blocks;            ///< Grouped by output
+  std::array<std::size_t, s_n_outputs + 1> m_begin{};
+
+  const unsigned char* m_buffer{ nullptr };
+  std::size_t m_n_input{ 0 };
+  unsigned m_n_threads_used{ 0 };
+  std::vector<uint64_t> m_offsets;    ///< Block starts when framing by block_length // NOLINT(build/unsigned)
+  std::vector<uint8_t> m_destination; ///< Output of each input block // NOLINT(build/unsigned)
+  std::vector<count_t> m_counts;      ///< Per thread, then per thread write cursors
+  std::unique_ptr<Workers> m_workers;  ///< Started on the first multi-threaded demux()
+};
+
+using DAQHeaderDemux = DetIdDemux<DAQHeader>;
+using DAQEthHeaderDemux = DetIdDemux<DAQEthHeader>;
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/DetIdDemux.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_DETIDDEMUX_HPP_
@@ -0,0 +1,131 @@
+/**
+ * @file EthReorderBuffer.hpp Per-stream sequence-id reordering of DAQEthHeader packets
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_ETHREORDERBUFFER_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_ETHREORDERBUFFER_HPP_
+
+#include "detdataformats/DAQEthHeader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief EthReorderBuffer restores the seq_id order of DAQEthHeader packets, per (crate_id, slot_id, stream_id).
+ *
+ * Each stream owns a window of window_size slots indexed by seq_id modulo the window size. A packet
+ * is parked in its slot and the run of consecutive packets starting at the next expected seq_id is
+ * released, so each packet costs O(1). A hole in the sequence is given up on (and counted as lost)
+ * when it has been pending for more than the timeout, or when a packet arrives too far ahead to fit
+ * in the window. Packets are not copied: the caller keeps them alive until they are released.
+ *
+ * Time is whatever monotonic clock the caller passes in (e.g. nanoseconds or timestamp ticks); the
+ * timeout is expressed in the same unit. Streams are allocated the first time they are seen; after
+ * that no allocation takes place.
+ */
+class EthReorderBuffer
+{
+public:
+  static constexpr unsigned s_seq_id_bits = 12;
+  static constexpr uint32_t s_seq_id_modulo = 1u << s_seq_id_bits; // NOLINT(build/unsigned)
+
+  struct Config
+  {
+    /// Power of two, at most half the seq_id range so that late packets can be told from early ones
+    uint32_t window_size{ 64 }; // NOLINT(build/unsigned)
+    /// How long a hole may stay pending; 0 disables the timeout
+    uint64_t timeout{ 0 }; // NOLINT(build/unsigned)
+  };
+
+  struct Counters
+  {
+    uint64_t n_released{ 0 };   ///< Packets handed back in order // NOLINT(build/unsigned)
+    uint64_t n_reordered{ 0 };  ///< Packets that had to wait for an earlier one // NOLINT(build/unsigned)
+    uint64_t n_lost{ 0 };       ///< seq_ids skipped over because of a timeout or window overflow // NOLINT
+    uint64_t n_late{ 0 };       ///< Packets dropped because their seq_id was already skipped // NOLINT
+    uint64_t n_duplicates{ 0 }; ///< Packets dropped because their slot was already filled // NOLINT
+  };
+
+  static uint32_t stream_key(const DAQEthHeader& header) noexcept // NOLINT(build/unsigned)
+  {
+    return header.crate_id | (header.slot_id << 10) | (header.stream_id << 14);
+  }
+
+  explicit EthReorderBuffer(const Config& config);
+
+  /**
+   * @brief Insert a packet received at time @p now; @p emit is called with every packet
+   * (as const DAQEthHeader*) that becomes releasable, in seq_id order per stream.
+   */
+  template<class Emit>
+  void push(const DAQEthHeader* packet, uint64_t now, Emit&& emit); // NOLINT(build/unsigned)
+
+  /**
+   * @brief Skip the holes that have been pending for more than the timeout at time @p now.
+   */
+  template<class Emit>
+  void expire(uint64_t now, Emit&& emit); // NOLINT(build/unsigned)
+
+  /**
+   * @brief Release everything that is buffered, skipping all holes.
+   */
+  template<class Emit>
+  void flush(Emit&& emit);
+
+  const Config& config() const noexcept { return m_config; }
+  const Counters& counters() const noexcept { return m_counters; }
+  std::size_t n_streams() const noexcept { return m_streams.size(); }
+  std::size_t n_buffered() const noexcept { return m_n_buffered; }
+
+private:
+  static constexpr uint32_t s_not_pending = std::numeric_limits<uint32_t>::max(); // NOLINT(build/unsigned)
+
+  struct Stream
+  {
+    uint32_t expected_seq_id{ 0 }; // NOLINT(build/unsigned)
+    uint32_t n_buffered{ 0 };      // NOLINT(build/unsigned)
+    uint32_t pending_index{ s_not_pending }; // NOLINT(build/unsigned)
+    uint64_t hole_since{ 0 };      ///< When the stream started waiting on expected_seq_id // NOLINT
+    std::size_t slot_base{ 0 };    ///< First slot of the stream's window in m_slots
+  };
+
+  uint32_t find_stream(uint32_t key, uint32_t first_seq_id); // NOLINT(build/unsigned)
+  const DAQEthHeader*& slot(const Stream& stream, uint32_t seq_id) noexcept // NOLINT(build/unsigned)
+  {
+    return m_slots[stream.slot_base + (seq_id & m_mask)];
+  }
+  template<class Emit>
+  void release_run(Stream& stream, uint64_t now, Emit& emit); // NOLINT(build/unsigned)
+  template<class Emit>
+  void skip_hole(Stream& stream, uint64_t now, Emit& emit); // NOLINT(build/unsigned)
+  template<class Emit>
+  void skip_to(Stream& stream, uint32_t seq_id, uint64_t now, Emit& emit); // NOLINT(build/unsigned)
+  void set_pending(Stream& stream, bool pending);
+
+  Config m_config;
+  uint32_t m_mask; // NOLINT(build/unsigned)
+  Counters m_counters;
+  std::size_t m_n_buffered{ 0 };
+
+  std::unordered_map<uint32_t, uint32_t> m_stream_index; // NOLINT(build/unsigned)
+  std::vector<Stream> m_streams;
+  std::vector<const DAQEthHeader*> m_slots;
+  std::vector<uint32_t> m_pending_streams; ///< Streams with buffered packets // NOLINT(build/unsigned)
+  uint32_t m_last_key{ std::numeric_limits<uint32_t>::max() }; // NOLINT(build/unsigned)
+  uint32_t m_last_index{ 0 };                                  // NOLINT(build/unsigned)
+};
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/EthReorderBuffer.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_ETHREORDERBUFFER_HPP_
@@ -0,0 +1,107 @@
+/**
+ * @file FrameFileReader.hpp Chunked reader for files of raw frames with background prefetch
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_FRAMEFILEREADER_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_FRAMEFILEREADER_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief A run of complete frames read from a file. Chunks are independent allocations, so
+ * holding on to one does not stall the reader.
+ */
+struct FrameChunk
+{
+  std::unique_ptr<unsigned char[]> data;
+  std::size_t size{ 0 };
+  std::size_t n_frames{ 0 };
+  uint64_t file_offset{ 0 }; // NOLINT(build/unsigned)
+  /// Byte offset of every frame in data; only filled for variable-size frames
+  std::vector<uint64_t> frame_offsets; // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief FrameFileReader iterates over a file of frames chunk by chunk.
+ *
+ * A dedicated thread reads up to prefetch_depth chunks ahead of the consumer, so
+ * memory stays bounded by the chunk size times the prefetch depth while the file
+ * reads overlap with the processing of the current chunk. A trailing partial frame
+ * at the end of the file is ignored.
+ */
+class FrameFileReader
+{
+public:
+  enum class FrameKind
+  {
+    kFixedSize, ///< Every frame has the same size (e.g. HSIFrame, fixed DAQEthHeader-prefixed blocks)
+    kRawTp      ///< fwtp/wib TpHeader followed by m_nhits TpData blocks
+  };
+
+  /**
+   * @brief Open @p path; throws std::runtime_error if the file can't be opened and
+   * std::invalid_argument for inconsistent sizes. @p frame_size is ignored for kRawTp.
+   */
+  FrameFileReader(const std::string& path,
+                  FrameKind kind,
+                  std::size_t chunk_bytes,
+                  std::size_t frame_size = 0,
+                  std::size_t prefetch_depth = 2);
+  ~FrameFileReader();
+
+  FrameFileReader(const FrameFileReader&) = delete;
+  FrameFileReader& operator=(const FrameFileReader&) = delete;
+  FrameFileReader(FrameFileReader&&) = delete;
+  FrameFileReader& operator=(FrameFileReader&&) = delete;
+
+  /**
+   * @brief Block until the next chunk is available. Returns nullptr once the file is exhausted
+   * and rethrows any error raised by the prefetch thread.
+   */
+  std::shared_ptr<FrameChunk> next();
+
+  FrameKind kind() const noexcept { return m_kind; }
+  std::size_t frame_size() const noexcept { return m_frame_size; }
+  std::size_t chunk_bytes() const noexcept { return m_chunk_bytes; }
+  uint64_t file_size() const noexcept { return m_file_size; } // NOLINT(build/unsigned)
+
+private:
+  void prefetch();
+  std::shared_ptr<FrameChunk> read_chunk(uint64_t& offset); // NOLINT(build/unsigned)
+
+  FrameKind m_kind;
+  std::size_t m_chunk_bytes;
+  std::size_t m_frame_size;
+  std::size_t m_prefetch_depth;
+  int m_fd{ -1 };
+  uint64_t m_file_size{ 0 }; // NOLINT(build/unsigned)
+
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::shared_ptr<FrameChunk>> m_ready;
+  bool m_eof{ false };
+  bool m_stop{ false };
+  std::exception_ptr m_error;
+  std::thread m_thread;
+};
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/FrameFileReader.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_FRAMEFILEREADER_HPP_
@@ -0,0 +1,153 @@
+/**
+ * @file FrameRecorder.hpp Asynchronous batched writer of raw frames to local disk
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_FRAMERECORDER_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_FRAMERECORDER_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief FrameRecorder copies spans of frames into aligned buffers and writes full buffers
+ * to a file from a dedicated thread.
+ *
+ * The file is opened with O_DIRECT when the filesystem supports it, so writes bypass the page
+ * cache; otherwise plain buffered pwrite() is used. When every buffer is queued for writing,
+ * record() either blocks until one is free or, if configured not to, drops the whole span. A
+ * span is never split between the file and the floor.
+ *
+ * record(), flush() and close() must be called from one thread; stats() may be called from any.
+ * Errors raised by the writer thread are rethrown by the next of those calls.
+ */
+class FrameRecorder
+{
+public:
+  struct Config
+  {
+    std::size_t buffer_bytes{ 4 << 20 }; ///< Multiple of alignment
+    std::size_t n_buffers{ 4 };
+    std::size_t alignment{ 4096 }; ///< O_DIRECT offset/size/address alignment
+    bool direct_io{ true };        ///< Try O_DIRECT
+    bool block_when_full{ true };  ///< Otherwise record() drops spans that don't fit
+  };
+
+  struct Stats
+  {
+    uint64_t batches{ 0 };       ///< Buffers written // NOLINT(build/unsigned)
+    uint64_t bytes_written{ 0 }; ///< Including O_DIRECT padding and rewritten tail blocks // NOLINT
+    uint64_t spans{ 0 };         ///< Spans accepted // NOLINT(build/unsigned)
+    uint64_t dropped_spans{ 0 }; // NOLINT(build/unsigned)
+    uint64_t dropped_bytes{ 0 }; // NOLINT(build/unsigned)
+    double blocked_seconds{ 0 }; ///< Time record() spent waiting for a free buffer
+    double write_seconds{ 0 };   ///< Time the writer thread spent in pwrite()
+    double total_latency{ 0 };   ///< Sum over batches of seconds from hand-off to write completion
+    double max_latency{ 0 };
+    /// Batch latency histogram: bin i counts latencies in [2^i, 2^(i+1)) microseconds
+    std::array<uint64_t, 32> latency_histogram{}; // NOLINT(build/unsigned)
+
+    double mean_latency() const noexcept { return batches ? total_latency / batches : 0; }
+  };
+
+  /**
+   * @brief Create or truncate @p path. Throws std::runtime_error if it can't be opened and
+   * std::invalid_argument for an inconsistent configuration.
+   */
+  FrameRecorder(const std::string& path, const Config& config);
+  ~FrameRecorder();
+
+  FrameRecorder(const FrameRecorder&) = delete;
+  FrameRecorder& operator=(const FrameRecorder&) = delete;
+  FrameRecorder(FrameRecorder&&) = delete;
+  FrameRecorder& operator=(FrameRecorder&&) = delete;
+
+  /**
+   * @brief Append @p size bytes of frames to the file.
+   * @return false if the span was dropped because all buffers were busy (block_when_full == false)
+   */
+  bool record(const void* data, std::size_t size);
+
+  /**
+   * @brief Hand the partly filled buffer to the writer and wait until everything recorded so far
+   * is on disk.
+   */
+  void flush();
+
+  /**
+   * @brief Flush, trim the O_DIRECT padding and close the file. Called by the destructor.
+   */
+  void close();
+
+  /// Whether the file is written with O_DIRECT
+  bool direct_io() const noexcept { return m_direct_io; }
+  /// Bytes accepted so far, i.e. the final file size
+  uint64_t size() const noexcept { return m_size; } // NOLINT(build/unsigned)
+  Stats stats() const;
+
+private:
+  using clock_t = std::chrono::steady_clock;
+
+  struct FreeDeleter
+  {
+    void operator()(unsigned char* p) const noexcept { std::free(p); }
+  };
+
+  struct Batch
+  {
+    std::size_t buffer;
+    uint64_t file_offset; // NOLINT(build/unsigned)
+    std::size_t size;
+    clock_t::time_point submitted;
+  };
+
+  void acquire_buffer();
+  void submit();
+  void check_error();
+  void write_loop();
+
+  Config m_config;
+  int m_fd{ -1 };
+  std::atomic<bool> m_direct_io{ false }; ///< Cleared by the writer if O_DIRECT writes fail
+  std::vector<std::unique_ptr<unsigned char, FreeDeleter>> m_buffers;
+
+  // Producer state
+  static constexpr std::size_t s_no_buffer = static_cast<std::size_t>(-1);
+  std::size_t m_current{ s_no_buffer };
+  std::size_t m_fill{ 0 };
+  uint64_t m_current_offset{ 0 }; ///< File offset of the current buffer, always aligned // NOLINT
+  uint64_t m_size{ 0 };           // NOLINT(build/unsigned)
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::deque<std::size_t> m_free;
+  std::deque<Batch> m_queue;
+  std::size_t m_in_flight{ 0 };
+  bool m_stop{ false };
+  std::exception_ptr m_error;
+  Stats m_stats;
+  std::thread m_thread;
+};
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/FrameRecorder.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_FRAMERECORDER_HPP_
@@ -0,0 +1,109 @@
+/**
+ * @file HeaderArrayView.hpp Column extraction and selection over arrays of DAQHeader/DAQEthHeader
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_HEADERARRAYVIEW_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_HEADERARRAYVIEW_HPP_
+
+#include "detdataformats/DAQEthHeader.hpp"
+#include "detdataformats/DAQHeader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief Header fields that can be extracted as a column. kLinkId is DAQEthHeader::stream_id for
+ * Ethernet headers, as in DecodedHeader; kSeqId and kBlockLength exist only in DAQEthHeader.
+ */
+enum class HeaderField
+{
+  kVersion,
+  kDetId,
+  kCrateId,
+  kSlotId,
+  kLinkId,
+  kSeqId,
+  kBlockLength,
+  kTimestamp
+};
+
+/**
+ * @brief Criteria for HeaderArrayView::select(). Fields left at s_any match every header; the
+ * time window is [t0, t1).
+ */
+struct HeaderSelection
+{
+  static constexpr uint32_t s_any = ~uint32_t(0); // NOLINT(build/unsigned)
+
+  uint32_t det_id = s_any;   // NOLINT(build/unsigned)
+  uint32_t crate_id = s_any; // NOLINT(build/unsigned)
+  uint32_t slot_id = s_any;  // NOLINT(build/unsigned)
+  uint32_t link_id = s_any;  // NOLINT(build/unsigned)
+  uint64_t t0 = 0;           // NOLINT(build/unsigned)
+  uint64_t t1 = ~uint64_t(0); // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief HeaderArrayView is a read-only view of @p Header records laid out every @p stride bytes,
+ * with no alignment requirement.
+ *
+ * The stride lets the same view walk the headers at the start of fixed-size frames. Columns and
+ * selections are computed in one pass without branching on the header contents.
+ */
+template<class Header>
+class HeaderArrayView
+{
+public:
+  /**
+   * @brief View @p n headers starting at @p data. A stride of 0 means sizeof(Header); throws
+   * std::invalid_argument if it is smaller than a header.
+   */
+  HeaderArrayView(const void* data, std::size_t n, std::size_t stride = 0);
+
+  std::size_t size() const noexcept { return m_size; }
+  std::size_t stride() const noexcept { return m_stride; }
+  const unsigned char* data() const noexcept { return m_data; }
+
+  /// Copy of header @p i
+  Header operator[](std::size_t i) const noexcept;
+  /// Copy of header @p i; throws std::out_of_range
+  Header at(std::size_t i) const;
+
+  /**
+   * @brief Write @p field of every header to @p out, which must hold size() values. Throws
+   * std::invalid_argument for a field @p Header doesn't have.
+   */
+  template<class T>
+  void column(HeaderField field, T* out) const;
+
+  /**
+   * @brief Write the indices of the headers matching @p selection to @p out, which must hold
+   * size() values.
+   * @return Number of indices written
+   */
+  std::size_t select(const HeaderSelection& selection, uint64_t* out) const noexcept; // NOLINT(build/unsigned)
+  std::vector<uint64_t> select(const HeaderSelection& selection) const;                // NOLINT(build/unsigned)
+
+  static bool has_field(HeaderField field) noexcept;
+
+private:
+  const unsigned char* m_data;
+  std::size_t m_size;
+  std::size_t m_stride;
+};
+
+using DAQHeaderArrayView = HeaderArrayView<DAQHeader>;
+using DAQEthHeaderArrayView = HeaderArrayView<DAQEthHeader>;
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/HeaderArrayView.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_HEADERARRAYVIEW_HPP_
@@ -0,0 +1,95 @@
+/**
+ * @file HeaderDecoder.hpp Version-specialised decoders for the common FrontEnd headers
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_HEADERDECODER_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_HEADERDECODER_HPP_
+
+#include "detdataformats/DAQEthHeader.hpp"
+#include "detdataformats/DAQHeader.hpp"
+#include "detdataformats/HSIFrame.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief Fields shared by DAQHeader, DAQEthHeader and HSIFrame, unpacked into plain integers.
+ * link_id holds DAQEthHeader::stream_id; seq_id holds HSIFrame::sequence.
+ */
+struct DecodedHeader
+{
+  uint8_t version;       // NOLINT(build/unsigned)
+  uint8_t det_id;        // NOLINT(build/unsigned)
+  uint16_t crate_id;     // NOLINT(build/unsigned)
+  uint8_t slot_id;       // NOLINT(build/unsigned)
+  uint8_t link_id;       // NOLINT(build/unsigned)
+  uint16_t block_length; // NOLINT(build/unsigned)
+  uint32_t seq_id;       // NOLINT(build/unsigned)
+  uint64_t timestamp;    // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief HeaderDecoder<Header, Version> decodes one header of a given format version.
+ *
+ * Only versions with a specialisation are supported; see detail/HeaderDecoder.hxx. Adding a firmware
+ * format means adding a specialisation and listing its version in HeaderVersions<Header>.
+ */
+template<class Header, unsigned Version>
+struct HeaderDecoder;
+
+/**
+ * @brief The list of versions of Header that decode_headers() dispatches to.
+ */
+template<class Header>
+struct HeaderVersions;
+
+enum class DecodeStatus
+{
+  kOk = 0,
+  kEmpty,
+  kUnsupportedVersion,
+  kMixedVersions
+};
+
+struct DecodeResult
+{
+  DecodeStatus status;
+  unsigned version;
+  std::size_t n_decoded;
+};
+
+/**
+ * @brief The 6-bit version field common to the first word of every header.
+ */
+inline unsigned
+header_version(const void* header) noexcept
+{
+  unsigned char byte0;
+  std::memcpy(&byte0, header, 1);
+  return byte0 & 0x3F;
+}
+
+/**
+ * @brief Decode @p n headers of type Header found every @p stride bytes from @p buffer.
+ *
+ * The version is read from the first header only and selects a fully specialised loop for the whole
+ * buffer. Headers whose version differs from the first are still decoded with that layout, but the
+ * result is flagged as kMixedVersions so the caller can fall back to smaller buffers.
+ */
+template<class Header>
+DecodeResult
+decode_headers(const void* buffer, std::size_t n, DecodedHeader* out, std::size_t stride = sizeof(Header)) noexcept;
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/HeaderDecoder.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_HEADERDECODER_HPP_
@@ -0,0 +1,181 @@
+/**
+ * @file PcapReader.hpp Zero-copy reader of DAQEthHeader UDP packets from pcap/pcapng captures
+ *
+ * Captures taken with tcpdump or Wireshark are mapped into memory; the link, IP and
+ * UDP headers of every captured packet are walked in place and the UDP payload,
+ * which starts with a DAQEthHeader, is handed out as a pointer into the mapping.
+ *
+ * Supported: classic pcap (microsecond and nanosecond, either byte order) and
+ * pcapng (enhanced and simple packet blocks, several sections and interfaces);
+ * Ethernet with 802.1Q/802.1ad tags, Linux cooked (SLL, SLL2) and raw IP link
+ * types; IPv4 and IPv6. IP fragments are counted and skipped, since reassembling
+ * them would need a copy.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_PCAPREADER_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_PCAPREADER_HPP_
+
+#include "detdataformats/DAQEthHeader.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief One UDP payload found in a capture. data points into the mapped file and is
+ * valid for the lifetime of the PcapReader; it is not necessarily aligned.
+ */
+struct PcapPacket
+{
+  const unsigned char* data;
+  uint32_t size;           // NOLINT(build/unsigned)
+  uint32_t stream_key;     ///< EthReorderBuffer::stream_key() of the header // NOLINT(build/unsigned)
+  uint64_t capture_time;   ///< Capture timestamp, ns since the epoch // NOLINT(build/unsigned)
+
+  /// Copy of the leading DAQEthHeader, safe whatever the alignment of data
+  DAQEthHeader header() const noexcept
+  {
+    DAQEthHeader h;
+    std::memcpy(&h, data, sizeof(h));
+    return h;
+  }
+};
+
+namespace pcap::detail {
+
+enum class PacketStatus
+{
+  kOk,
+  kNotUdp,   ///< Unsupported link type, not IP, or not UDP
+  kFragment, ///< IPv4 or IPv6 fragment
+  kTruncated ///< Cut short by the capture snap length
+};
+
+/**
+ * @brief Find the UDP payload of a packet captured with link type @p link_type.
+ */
+PacketStatus
+udp_payload(unsigned link_type,
+            const unsigned char* frame,
+            std::size_t captured,
+            uint16_t& dst_port, // NOLINT(build/unsigned)
+            const unsigned char*& payload,
+            std::size_t& size) noexcept;
+
+} // namespace pcap::detail
+
+/**
+ * @brief PcapReader walks the packets of a capture file mapped read-only into memory.
+ *
+ * Each pass over the file (for_each() or for_each_parallel()) restarts from the beginning
+ * and recomputes the counters. A capture cut short in the middle of a record, as left by an
+ * interrupted tcpdump, ends at the last complete record.
+ */
+class PcapReader
+{
+public:
+  enum class Format
+  {
+    kPcap,
+    kPcapNg
+  };
+
+  struct Config
+  {
+    uint16_t udp_port{ 0 };              ///< Keep only packets to this destination port; 0 keeps all // NOLINT
+    std::size_t batch_packets{ 1 << 16 }; ///< Packets indexed per for_each_parallel() round
+  };
+
+  struct Counters
+  {
+    uint64_t n_records{ 0 };   ///< Captured packets seen // NOLINT(build/unsigned)
+    uint64_t n_packets{ 0 };   ///< UDP payloads handed out // NOLINT(build/unsigned)
+    uint64_t n_not_udp{ 0 };   // NOLINT(build/unsigned)
+    uint64_t n_other_port{ 0 }; // NOLINT(build/unsigned)
+    uint64_t n_fragments{ 0 }; // NOLINT(build/unsigned)
+    uint64_t n_truncated{ 0 }; ///< Records or datagrams cut short by the snap length // NOLINT(build/unsigned)
+    uint64_t n_too_short{ 0 }; ///< UDP payloads smaller than a DAQEthHeader // NOLINT(build/unsigned)
+  };
+
+  /**
+   * @brief Map @p path; throws std::runtime_error if it can't be opened or is not a pcap or
+   * pcapng capture.
+   */
+  PcapReader(const std::string& path, const Config& config);
+  ~PcapReader();
+
+  PcapReader(const PcapReader&) = delete;
+  PcapReader& operator=(const PcapReader&) = delete;
+  PcapReader(PcapReader&&) = delete;
+  PcapReader& operator=(PcapReader&&) = delete;
+
+  /**
+   * @brief Call @p callback(const PcapPacket&) for every DAQEthHeader packet, in capture order.
+   */
+  template<class Callback>
+  void for_each(Callback&& callback);
+
+  /**
+   * @brief Spread the packets over @p n_threads threads by stream key and call
+   * @p callback(unsigned thread, const PcapPacket&) from them. All packets of a stream go to the
+   * same thread, in capture order, so per-stream state (an EthReorderBuffer, a decoder) needs no
+   * locking if it is kept per thread.
+   */
+  template<class Callback>
+  void for_each_parallel(Callback&& callback, unsigned n_threads = std::thread::hardware_concurrency());
+
+  /// The thread for_each_parallel() hands packets of @p stream_key to
+  static unsigned thread_of(uint32_t stream_key, unsigned n_threads) noexcept // NOLINT(build/unsigned)
+  {
+    return static_cast<unsigned>((static_cast<uint64_t>(stream_key * 0x9E3779B1u) * n_threads) >> 32); // NOLINT
+  }
+
+  Format format() const noexcept { return m_format; }
+  std::size_t file_size() const noexcept { return m_size; }
+  const Counters& counters() const noexcept { return m_counters; }
+
+private:
+  struct Interface
+  {
+    unsigned link_type;
+    uint64_t ticks_per_second; // NOLINT(build/unsigned)
+  };
+
+  // Call record(link_type, frame, captured, capture_time) for every captured packet
+  template<class Record>
+  void walk(Record&& record);
+  template<class Record>
+  void walk_pcap(Record& record);
+  template<class Record>
+  void walk_pcapng(Record& record);
+
+  // Classify one captured packet; fills @p packet and returns true if it is handed out
+  bool extract(unsigned link_type,
+               const unsigned char* frame,
+               std::size_t captured,
+               uint64_t capture_time, // NOLINT(build/unsigned)
+               PcapPacket& packet) noexcept;
+
+  Config m_config;
+  std::string m_path;
+  int m_fd{ -1 };
+  const unsigned char* m_data{ nullptr };
+  std::size_t m_size{ 0 };
+  Format m_format{ Format::kPcap };
+  Counters m_counters;
+};
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/PcapReader.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_PCAPREADER_HPP_
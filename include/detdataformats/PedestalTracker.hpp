@@ -0,0 +1,165 @@
+/**
+ * @file PedestalTracker.hpp Running per-channel pedestal and noise statistics from TpHeader medians
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_PEDESTALTRACKER_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_PEDESTALTRACKER_HPP_
+
+#include "detdataformats/ChannelMap.hpp"
+#include "detdataformats/TpFrame.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief Pedestal statistics of one channel. mean and rms are over every m_median sample seen;
+ * recent_mean follows the latest batches and is what drift alarms compare against the reference,
+ * the mean at the end of the warm-up period (NaN until then).
+ */
+struct ChannelPedestal
+{
+  uint64_t n_samples;        // NOLINT(build/unsigned)
+  float mean;
+  float rms;
+  float recent_mean;
+  float reference;
+  uint16_t last_median;      // NOLINT(build/unsigned)
+  uint16_t last_accumulator; // NOLINT(build/unsigned)
+  uint8_t alarm;             // NOLINT(build/unsigned)
+  uint8_t reserved[3];       // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief A consistent copy of all channels, taken by PedestalTracker::snapshot().
+ */
+struct PedestalSnapshot
+{
+  uint64_t generation{ 0 }; ///< Number of publish() calls the copy reflects // NOLINT(build/unsigned)
+  std::vector<ChannelPedestal> channels;
+};
+
+/**
+ * @brief PedestalTracker keeps running mean, variance and drift alarms of the m_median field of
+ * TpHeaders, per offline channel.
+ *
+ * State lives in dense channel-indexed arrays, one array per quantity. A batch of headers is first
+ * reduced to per-channel shifted sums, then merged into the running statistics with the parallel
+ * form of Welford's update; the merge loop is branch-free over contiguous arrays so that it
+ * vectorises when a batch touches a large fraction of the channels.
+ *
+ * All updates must come from one thread. publish() copies the statistics into a sequence-locked
+ * buffer, and any number of other threads can take snapshots without blocking the updater.
+ */
+template<class Layout>
+class PedestalTracker
+{
+public:
+  using channel_map_t = ChannelMap<Layout>;
+  using header_t = typename Layout::header_t;
+  using data_t = typename Layout::data_t;
+
+  struct Config
+  {
+    /// Samples after which a channel's mean is frozen as its reference pedestal
+    uint64_t warmup_samples = 1000; // NOLINT(build/unsigned)
+    /// Weight of each batch's mean in recent_mean
+    double recent_weight = 0.05;
+    /// Alarm when |recent_mean - reference| exceeds this many ADC counts
+    double drift_threshold = 5.0;
+  };
+
+  /**
+   * @brief The channel map must be compiled and must outlive the tracker.
+   */
+  explicit PedestalTracker(const channel_map_t& channel_map);
+  PedestalTracker(const channel_map_t& channel_map, const Config& config);
+
+  /**
+   * @brief Update from @p n headers laid out every @p stride bytes starting at @p first.
+   */
+  void process_headers(const void* first, std::size_t n, std::size_t stride = sizeof(header_t));
+
+  /**
+   * @brief Update from all complete raw TP frames in a buffer, as one batch.
+   * @return Number of bytes consumed (a trailing truncated frame is left for the caller)
+   */
+  std::size_t process(const void* buffer, std::size_t size);
+
+  /**
+   * @brief Statistics of one channel as seen by the updating thread.
+   */
+  ChannelPedestal stats(uint32_t channel) const; // NOLINT(build/unsigned)
+
+  /**
+   * @brief Make the current statistics visible to snapshot(). Call from the updating thread.
+   */
+  void publish();
+
+  /**
+   * @brief Copy the last published statistics into @p out. Safe from any thread; retries if a
+   * publish() overlaps the copy.
+   */
+  void snapshot(PedestalSnapshot& out) const;
+
+  std::size_t n_channels() const noexcept { return m_mean.size(); }
+  uint64_t n_samples() const noexcept { return m_n_samples; }   // NOLINT(build/unsigned)
+  uint64_t n_unmapped() const noexcept { return m_n_unmapped; } // NOLINT(build/unsigned)
+  uint64_t n_batches() const noexcept { return m_n_batches; }   // NOLINT(build/unsigned)
+  /// Channels currently in alarm
+  std::size_t n_alarms() const noexcept { return m_n_alarms; }
+
+private:
+  static constexpr std::size_t s_words_per_channel = sizeof(ChannelPedestal) / sizeof(uint64_t); // NOLINT
+
+  void accumulate(uint32_t channel, const header_t& header) noexcept; // NOLINT(build/unsigned)
+  void merge_batch() noexcept;
+
+  const channel_map_t& m_channel_map;
+  Config m_config;
+
+  // Running statistics, indexed by channel
+  std::vector<double> m_count;
+  std::vector<double> m_mean;
+  std::vector<double> m_m2;
+  std::vector<double> m_recent;
+  std::vector<double> m_reference;
+  std::vector<double> m_drift; ///< |recent - reference|, NaN before the warm-up ends
+  std::vector<uint16_t> m_last_median;      // NOLINT(build/unsigned)
+  std::vector<uint16_t> m_last_accumulator; // NOLINT(build/unsigned)
+
+  // Current batch: count and sums of (median - shift) per channel, and the channels touched
+  std::vector<double> m_batch_count;
+  std::vector<double> m_batch_sum;
+  std::vector<double> m_batch_sum2;
+  std::vector<double> m_shift;
+  std::vector<uint32_t> m_touched;         // NOLINT(build/unsigned)
+  std::vector<uint32_t> m_channel_scratch; // NOLINT(build/unsigned)
+  std::vector<const header_t*> m_header_scratch;
+
+  uint64_t m_n_samples{ 0 };  // NOLINT(build/unsigned)
+  uint64_t m_n_unmapped{ 0 }; // NOLINT(build/unsigned)
+  uint64_t m_n_batches{ 0 };  // NOLINT(build/unsigned)
+  std::size_t m_n_alarms{ 0 };
+
+  // Published copy, guarded by m_sequence (odd while a publish is in progress)
+  std::atomic<uint64_t> m_sequence{ 0 };                // NOLINT(build/unsigned)
+  std::unique_ptr<std::atomic<uint64_t>[]> m_published; // NOLINT(build/unsigned)
+};
+
+using FwtpPedestalTracker = PedestalTracker<FwtpChannelLayout>;
+using WIBPedestalTracker = PedestalTracker<WIBChannelLayout>;
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/PedestalTracker.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_PEDESTALTRACKER_HPP_
@@ -0,0 +1,216 @@
+/**
+ * @file SyntheticGenerator.hpp Seeded generator of synthetic raw data streams for load tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_SYNTHETICGENERATOR_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_SYNTHETICGENERATOR_HPP_
+
+#include "detdataformats/DAQEthHeader.hpp"
+#include "detdataformats/DAQHeader.hpp"
+#include "detdataformats/DetID.hpp"
+#include "detdataformats/HSIFrame.hpp"
+#include "detdataformats/fwtp/RawTp.hpp"
+#include "detdataformats/wib/RawWIBTp.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+enum class SyntheticFormat
+{
+  kFwtp,        ///< fwtp::TpHeader followed by m_nhits fwtp::TpData
+  kWIBTp,       ///< wib::TpHeader followed by m_nhits wib::TpData
+  kHSI,         ///< HSIFrame
+  kDAQHeader,   ///< DAQHeader followed by payload_bytes of ADC-like samples
+  kDAQEthHeader ///< DAQEthHeader followed by payload_bytes of ADC-like samples
+};
+
+/**
+ * @brief A random distribution of non-negative values.
+ * kFixed: always a. kUniform: uniform in [a, b]. kExponential / kPoisson: b plus an exponential /
+ * Poisson variate of mean a.
+ */
+struct SyntheticDistribution
+{
+  enum class Kind
+  {
+    kFixed,
+    kUniform,
+    kExponential,
+    kPoisson
+  };
+
+  Kind kind{ Kind::kFixed };
+  double a{ 1 };
+  double b{ 0 };
+
+  static SyntheticDistribution fixed(double value) { return { Kind::kFixed, value, 0 }; }
+  static SyntheticDistribution uniform(double lo, double hi) { return { Kind::kUniform, lo, hi }; }
+  static SyntheticDistribution exponential(double mean, double offset = 0) { return { Kind::kExponential, mean, offset }; }
+  static SyntheticDistribution poisson(double mean, double offset = 0) { return { Kind::kPoisson, mean, offset }; }
+};
+
+/**
+ * @brief Fault injection rates, each the probability per generated frame.
+ */
+struct SyntheticFaults
+{
+  double gap{ 0 };        ///< Drop the frame; timestamps and sequence numbers still advance
+  double corruption{ 0 }; ///< Flip one random bit anywhere in the frame
+  double reorder{ 0 };    ///< Emit the frame after the next one
+};
+
+/**
+ * @brief Configuration of one generated stream (one link).
+ */
+struct SyntheticConfig
+{
+  SyntheticFormat format{ SyntheticFormat::kFwtp };
+  uint64_t seed{ 1 }; // NOLINT(build/unsigned)
+
+  // Source geometry; the stream's random sequence is derived from the seed and these fields
+  uint16_t det_id{ static_cast<uint16_t>(DetID::Subdetector::kHD_TPC) }; // NOLINT(build/unsigned)
+  uint32_t crate{ 0 };                                                  // NOLINT(build/unsigned)
+  uint32_t slot{ 0 };                                                   // NOLINT(build/unsigned)
+  uint32_t link{ 0 }; ///< fiber for TPs, link_id for DAQHeader/HSI, stream_id for DAQEthHeader // NOLINT
+
+  uint64_t start_timestamp{ 0 }; // NOLINT(build/unsigned)
+  double clock_hz{ 62.5e6 };
+
+  // TP formats: hits arrive on n_channels wires at hit_rate_hz each
+  unsigned n_channels{ 256 };
+  double hit_rate_hz{ 1000 };
+  bool poisson_arrivals{ true }; ///< Otherwise frames are evenly spaced
+  SyntheticDistribution nhits{ SyntheticDistribution::fixed(1) };
+  unsigned max_nhits{ 64 };
+  SyntheticDistribution hit_width{ SyntheticDistribution::uniform(4, 40) };      ///< ticks
+  SyntheticDistribution peak_adc{ SyntheticDistribution::exponential(100, 20) }; ///< ADC counts
+  uint16_t pedestal{ 900 }; ///< m_median of TP headers and centre of payload samples // NOLINT(build/unsigned)
+
+  // Header formats: one frame every frame_period ticks
+  uint64_t frame_period{ 2048 }; // NOLINT(build/unsigned)
+  std::size_t payload_bytes{ 7200 };
+
+  SyntheticFaults faults;
+};
+
+/**
+ * @brief SyntheticGenerator produces one deterministic stream of frames.
+ *
+ * The same configuration always yields the same bytes, however the output is split between
+ * generate() calls. Header formats copy their payloads from a pseudo-random sample pattern built
+ * at construction, so they are limited by memory bandwidth rather than by the random number
+ * generator. Each generator is single-threaded; generate_parallel() runs several of them.
+ */
+class SyntheticGenerator
+{
+public:
+  struct Counters
+  {
+    uint64_t frames{ 0 };    // NOLINT(build/unsigned)
+    uint64_t bytes{ 0 };     // NOLINT(build/unsigned)
+    uint64_t hits{ 0 };      ///< TpData blocks written // NOLINT(build/unsigned)
+    uint64_t gaps{ 0 };      ///< Frames dropped // NOLINT(build/unsigned)
+    uint64_t corrupted{ 0 }; // NOLINT(build/unsigned)
+    uint64_t reordered{ 0 }; ///< Frames emitted after their successor // NOLINT(build/unsigned)
+  };
+
+  /**
+   * @brief Throws std::invalid_argument if the geometry does not fit the format's header
+   * fields or a rate or size is out of range.
+   */
+  explicit SyntheticGenerator(const SyntheticConfig& config);
+
+  /**
+   * @brief Append whole frames to @p buffer until the next one would not fit.
+   * @return Number of bytes written
+   */
+  std::size_t generate(void* buffer, std::size_t capacity);
+
+  /**
+   * @brief Write up to @p n_bytes of whole frames to @p path, @p chunk_bytes at a time.
+   * Throws std::runtime_error on I/O errors.
+   * @return Number of bytes written
+   */
+  uint64_t write_file(const std::string& path, uint64_t n_bytes, std::size_t chunk_bytes = 4 << 20); // NOLINT
+
+  /**
+   * @brief Largest size a single frame can have with this configuration.
+   */
+  std::size_t max_frame_size() const noexcept { return m_max_frame_size; }
+
+  const SyntheticConfig& config() const noexcept { return m_config; }
+  /**
+   * @brief Totals over the frames returned so far (not those held back for the next call).
+   */
+  Counters counters() const noexcept;
+  uint64_t next_timestamp() const noexcept { return m_timestamp; } // NOLINT(build/unsigned)
+
+private:
+  // xoshiro256** seeded through splitmix64
+  uint64_t next_random() noexcept; // NOLINT(build/unsigned)
+  double uniform() noexcept { return (next_random() >> 11) * 0x1.0p-53; }
+  bool happens(double probability) noexcept { return probability > 0 && uniform() < probability; }
+  double sample(const SyntheticDistribution& d) noexcept;
+
+  void advance() noexcept;
+  std::size_t write_frame(unsigned char* out) noexcept;
+  template<class Header, class Data>
+  std::size_t write_tp_frame(unsigned char* out) noexcept;
+  std::size_t write_hsi_frame(unsigned char* out) noexcept;
+  std::size_t write_daq_frame(unsigned char* out) noexcept;
+  std::size_t write_eth_frame(unsigned char* out) noexcept;
+  void write_payload(unsigned char* out) noexcept;
+
+  SyntheticConfig m_config;
+  Counters m_counters;         ///< Including m_pending
+  Counters m_pending_counters; ///< Contribution of m_pending
+  uint64_t m_state[4]; // NOLINT(build/unsigned)
+
+  uint64_t m_timestamp{ 0 };       // NOLINT(build/unsigned)
+  double m_timestamp_fraction{ 0 }; ///< Sub-tick part of the next TP arrival time
+  double m_mean_interval{ 0 };      ///< Ticks between TP frames of the link
+  uint32_t m_sequence{ 0 };         ///< seq_id / HSI sequence of the next frame // NOLINT(build/unsigned)
+
+  std::size_t m_max_frame_size{ 0 };
+  std::vector<unsigned char> m_pattern; ///< Payload sample pattern
+  std::vector<unsigned char> m_pending; ///< Frames generated but not yet returned
+};
+
+/**
+ * @brief Fill buffers[i] from generators[i] with up to @p n_threads threads. Generators are
+ * independent, so the result does not depend on the thread count.
+ * @return Bytes written into each buffer
+ */
+std::vector<std::size_t>
+generate_parallel(std::vector<SyntheticGenerator>& generators,
+                  const std::vector<std::pair<void*, std::size_t>>& buffers,
+                  unsigned n_threads = std::thread::hardware_concurrency());
+
+/**
+ * @brief Write @p n_bytes from generators[i] to paths[i] with up to @p n_threads threads. After
+ * an I/O failure no further file is started, and the first std::runtime_error is rethrown once
+ * the files in progress are done.
+ * @return Bytes written into each file
+ */
+std::vector<uint64_t> // NOLINT(build/unsigned)
+write_files_parallel(std::vector<SyntheticGenerator>& generators,
+                     const std::vector<std::string>& paths,
+                     uint64_t n_bytes, // NOLINT(build/unsigned)
+                     std::size_t chunk_bytes = 4 << 20,
+                     unsigned n_threads = std::thread::hardware_concurrency());
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/SyntheticGenerator.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_SYNTHETICGENERATOR_HPP_
@@ -0,0 +1,209 @@
+/**
+ * @file TimestampSkewMonitor.hpp Per-link timestamp offset and clock drift against a reference
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TIMESTAMPSKEWMONITOR_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TIMESTAMPSKEWMONITOR_HPP_
+
+#include "detdataformats/DAQEthHeader.hpp"
+#include "detdataformats/DAQHeader.hpp"
+#include "detdataformats/HSIFrame.hpp"
+#include "detdataformats/fwtp/RawTp.hpp"
+#include "detdataformats/wib/RawWIBTp.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief The header format a link id was made from, so that geometries of different formats
+ * don't collide.
+ */
+enum class TimestampSource : uint8_t // NOLINT(build/unsigned)
+{
+  kDAQHeader = 1,
+  kDAQEthHeader,
+  kHSIFrame,
+  kFwtp,
+  kWIBTp
+};
+
+/**
+ * @brief Straight-line fit of one link's timestamp offset (timestamp - reference) against the
+ * reference time.
+ */
+struct LinkClockFit
+{
+  uint64_t n_samples;      // NOLINT(build/unsigned)
+  uint64_t last_timestamp; // NOLINT(build/unsigned)
+  double offset;           ///< Fitted offset at the latest sample, in ticks
+  double drift;            ///< Offset ticks gained per reference tick
+  double jitter;           ///< RMS of the offsets around the fit, in ticks
+};
+
+/**
+ * @brief TimestampSkewMonitor estimates how far the timestamps of each link are from a reference
+ * clock, and how fast that distance changes.
+ *
+ * Every sample pairs a link timestamp with the reference time at which it was seen, in the same
+ * ticks: e.g. a host clock converted to timing-system ticks, or the timestamp of a reference
+ * stream at that point. The offset timestamp - reference is fitted against the reference time
+ * with exponentially weighted least squares, updated in place (weighted Welford co-moments), so
+ * a sample costs a hash lookup and a few multiplications and a link keeps a fixed-size state.
+ * Older samples are forgotten with an effective memory of memory_samples, which lets the fit
+ * follow a link that is resynchronised.
+ *
+ * Transport latency shows up in every offset; what matters is the difference between links.
+ * report() compares every link with the reference link, or with the median link when none is
+ * configured, and flags those whose offset or drift differ by more than the tolerances. Links
+ * are allocated the first time they are seen, up to max_links; samples of further links are
+ * counted and dropped. The monitor is not thread-safe.
+ */
+class TimestampSkewMonitor
+{
+public:
+  using link_t = uint64_t; // NOLINT(build/unsigned)
+
+  static constexpr link_t s_no_link = std::numeric_limits<link_t>::max();
+
+  struct Config
+  {
+    double memory_samples{ 1024 };    ///< Effective number of samples in each fit
+    uint64_t min_samples{ 16 };       ///< Links with fewer samples are reported but never flagged // NOLINT
+    double offset_tolerance{ 625 };   ///< Largest offset from the reference, in ticks (10 us at 62.5 MHz)
+    double drift_tolerance_ppm{ 10 }; ///< Largest drift from the reference, in parts per million
+    std::size_t max_links{ 4096 };
+    link_t reference_link{ s_no_link }; ///< Link the others are compared with; s_no_link uses the median
+  };
+
+  struct Counters
+  {
+    uint64_t n_samples{ 0 };       // NOLINT(build/unsigned)
+    uint64_t n_dropped{ 0 };       ///< Samples of links beyond max_links // NOLINT(build/unsigned)
+  };
+
+  struct LinkStatus
+  {
+    link_t link;
+    LinkClockFit fit;
+    double skew;      ///< fit.offset minus the reference offset, in ticks
+    double drift_ppm; ///< fit.drift minus the reference drift, in parts per million
+    bool offset_out;  ///< |skew| beyond offset_tolerance
+    bool drift_out;   ///< |drift_ppm| beyond drift_tolerance_ppm
+
+    bool flagged() const noexcept { return offset_out || drift_out; }
+  };
+
+  struct Report
+  {
+    bool has_reference{ false }; ///< False until the reference has min_samples samples
+    double reference_offset{ 0 };
+    double reference_drift{ 0 };
+    std::size_t n_flagged{ 0 };
+    std::vector<LinkStatus> links; ///< Ordered by link id
+  };
+
+  /**
+   * @brief Throws std::invalid_argument for a memory shorter than 2 samples or no links.
+   */
+  explicit TimestampSkewMonitor(const Config& config);
+
+  static link_t link_id(TimestampSource source, unsigned crate, unsigned slot, unsigned link) noexcept
+  {
+    return (link_t(source) << 40) | (link_t(crate) << 16) | (link_t(slot) << 8) | link;
+  }
+  static link_t link_of(const DAQHeader& h) noexcept
+  {
+    return link_id(TimestampSource::kDAQHeader, h.crate_id, h.slot_id, h.link_id);
+  }
+  static link_t link_of(const DAQEthHeader& h) noexcept
+  {
+    return link_id(TimestampSource::kDAQEthHeader, h.crate_id, h.slot_id, h.stream_id);
+  }
+  static link_t link_of(const HSIFrame& h) noexcept
+  {
+    return link_id(TimestampSource::kHSIFrame, h.crate, h.slot, h.link);
+  }
+  static link_t link_of(const fwtp::TpHeader& h) noexcept
+  {
+    return link_id(TimestampSource::kFwtp, h.m_crate_no, h.m_slot_no, h.m_fiber_no);
+  }
+  static link_t link_of(const wib::TpHeader& h) noexcept
+  {
+    return link_id(TimestampSource::kWIBTp, h.m_crate_no, h.m_slot_no, h.m_fiber_no);
+  }
+
+  /**
+   * @brief Add the timestamp @p timestamp of @p link, seen at reference time @p reference.
+   */
+  void sample(link_t link, uint64_t timestamp, uint64_t reference); // NOLINT(build/unsigned)
+
+  /**
+   * @brief Sample the link and get_timestamp() of any header with a link_of() overload.
+   */
+  template<class Header>
+  void sample(const Header& header, uint64_t reference) // NOLINT(build/unsigned)
+  {
+    sample(link_of(header), header.get_timestamp(), reference);
+  }
+
+  /**
+   * @brief The current fit of @p link; false if the link was never sampled.
+   */
+  bool fit(link_t link, LinkClockFit& out) const;
+
+  /**
+   * @brief Compare every link with the reference. Costs O(n log n) in the number of links, and is
+   * meant to be called periodically rather than per sample.
+   */
+  Report report() const;
+
+  /// Forget every link
+  void clear();
+
+  const Config& config() const noexcept { return m_config; }
+  const Counters& counters() const noexcept { return m_counters; }
+  std::size_t n_links() const noexcept { return m_links.size(); }
+
+private:
+  struct LinkState
+  {
+    link_t link;
+    uint64_t n_samples;      // NOLINT(build/unsigned)
+    uint64_t first_reference; ///< Origin of x, keeping it small enough for double precision // NOLINT
+    uint64_t last_timestamp; // NOLINT(build/unsigned)
+    double last_x;
+    double weight;
+    double mean_x;
+    double mean_y;
+    double cxx;
+    double cxy;
+    double cyy;
+  };
+
+  static LinkClockFit fit_of(const LinkState& state) noexcept;
+
+  Config m_config;
+  double m_decay;
+  Counters m_counters;
+
+  std::unordered_map<link_t, uint32_t> m_link_index; // NOLINT(build/unsigned)
+  std::vector<LinkState> m_links;
+  bool m_has_last{ false }; ///< m_last_link/m_last_index cache the previous lookup
+  link_t m_last_link{ 0 };
+  uint32_t m_last_index{ 0 }; // NOLINT(build/unsigned)
+};
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/TimestampSkewMonitor.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TIMESTAMPSKEWMONITOR_HPP_
@@ -0,0 +1,235 @@
+/**
+ * @file TpArchive.hpp Columnar archival file format for decoded trigger primitives
+ *
+ * A TpArchive file stores one row per hit (the TpHeader fields of its frame plus
+ * the TpData fields) in row groups. Inside a row group every column is stored
+ * separately, frame-of-reference encoded with the narrowest of 0/1/2/4/8 bytes
+ * per value, and the min/max of every column is kept in the footer as a zone
+ * map. Readers mmap the file and skip the row groups whose zone maps can't match
+ * a query.
+ *
+ *   FileHeader | row group 0 columns | row group 1 columns | ... | RowGroupMeta[] | Trailer
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPARCHIVE_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPARCHIVE_HPP_
+
+#include "detdataformats/TpFrame.hpp"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief One decoded hit, as stored in and returned from a TpArchive.
+ */
+struct TpRow
+{
+  uint64_t timestamp;    // NOLINT(build/unsigned)
+  uint16_t crate;        // NOLINT(build/unsigned)
+  uint16_t header_flags; // NOLINT(build/unsigned)
+  uint16_t median;       // NOLINT(build/unsigned)
+  uint16_t accumulator;  // NOLINT(build/unsigned)
+  uint16_t start_time;   // NOLINT(build/unsigned)
+  uint16_t end_time;     // NOLINT(build/unsigned)
+  uint16_t peak_time;    // NOLINT(build/unsigned)
+  uint16_t peak_adc;     // NOLINT(build/unsigned)
+  uint16_t sum_adc;      // NOLINT(build/unsigned)
+  uint16_t tp_flags;     // NOLINT(build/unsigned)
+  uint8_t slot;          // NOLINT(build/unsigned)
+  uint8_t fiber;         // NOLINT(build/unsigned)
+  uint8_t wire;          // NOLINT(build/unsigned)
+  uint8_t hit_continue;  // NOLINT(build/unsigned)
+};
+
+namespace tparchive {
+
+enum Column : unsigned
+{
+  kTimestamp = 0,
+  kCrate,
+  kSlot,
+  kFiber,
+  kWire,
+  kHeaderFlags,
+  kMedian,
+  kAccumulator,
+  kStartTime,
+  kEndTime,
+  kPeakTime,
+  kPeakAdc,
+  kSumAdc,
+  kTpFlags,
+  kHitContinue,
+  kNumColumns
+};
+
+constexpr uint32_t s_version = 1; // NOLINT(build/unsigned)
+constexpr char s_magic[8] = { 'D', 'U', 'N', 'E', 'T', 'P', 'A', '\0' };
+
+struct FileHeader
+{
+  char magic[8];
+  uint32_t version;   // NOLINT(build/unsigned)
+  uint32_t n_columns; // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief Location, encoding and zone map of one column in one row group.
+ * Values are stored as (value - min) in width bytes; width 0 means every value equals min.
+ */
+struct ColumnMeta
+{
+  uint64_t offset; // NOLINT(build/unsigned)
+  uint64_t min;    // NOLINT(build/unsigned)
+  uint64_t max;    // NOLINT(build/unsigned)
+  uint32_t width;  // NOLINT(build/unsigned)
+  uint32_t reserved; // NOLINT(build/unsigned)
+};
+
+struct RowGroupMeta
+{
+  uint64_t n_rows; // NOLINT(build/unsigned)
+  ColumnMeta columns[kNumColumns];
+};
+
+struct Trailer
+{
+  uint64_t meta_offset;  // NOLINT(build/unsigned)
+  uint64_t n_row_groups; // NOLINT(build/unsigned)
+  uint64_t n_rows;       // NOLINT(build/unsigned)
+  char magic[8];
+};
+
+} // namespace tparchive
+
+/**
+ * @brief Selection applied by TpArchiveReader: a half-open timestamp range and inclusive geometry ranges.
+ */
+struct TpQuery
+{
+  uint64_t timestamp_begin{ 0 };                                   // NOLINT(build/unsigned)
+  uint64_t timestamp_end{ std::numeric_limits<uint64_t>::max() };  // NOLINT(build/unsigned)
+  uint32_t crate_min{ 0 }, crate_max{ std::numeric_limits<uint32_t>::max() }; // NOLINT(build/unsigned)
+  uint32_t slot_min{ 0 }, slot_max{ std::numeric_limits<uint32_t>::max() };   // NOLINT(build/unsigned)
+  uint32_t fiber_min{ 0 }, fiber_max{ std::numeric_limits<uint32_t>::max() }; // NOLINT(build/unsigned)
+  uint32_t wire_min{ 0 }, wire_max{ std::numeric_limits<uint32_t>::max() };   // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief TpArchiveWriter appends hits to a TpArchive file, one row group at a time.
+ * Errors throw std::runtime_error.
+ */
+class TpArchiveWriter
+{
+public:
+  explicit TpArchiveWriter(const std::string& path, std::size_t rows_per_group = 65536);
+  ~TpArchiveWriter();
+
+  TpArchiveWriter(const TpArchiveWriter&) = delete;
+  TpArchiveWriter& operator=(const TpArchiveWriter&) = delete;
+
+  void append(const TpRow& row);
+
+  /**
+   * @brief Append one row per hit of a raw fwtp or wib TP frame.
+   */
+  template<class Header, class Data>
+  void append(const TpFrameRef<Header, Data>& frame);
+
+  /**
+   * @brief Append every complete raw TP frame of a buffer; returns the bytes consumed.
+   */
+  template<class Header, class Data>
+  std::size_t append_frames(const void* buffer, std::size_t size);
+
+  /**
+   * @brief Flush the last row group and write the footer. Called by the destructor if needed.
+   */
+  void close();
+
+  uint64_t n_rows() const noexcept { return m_n_rows; } // NOLINT(build/unsigned)
+
+private:
+  void write(const void* data, std::size_t size);
+  void flush_group();
+
+  std::FILE* m_file{ nullptr };
+  std::string m_path;
+  std::size_t m_rows_per_group;
+  uint64_t m_offset{ 0 };  // NOLINT(build/unsigned)
+  uint64_t m_n_rows{ 0 }; // NOLINT(build/unsigned)
+  std::array<std::vector<uint64_t>, tparchive::kNumColumns> m_columns; // NOLINT(build/unsigned)
+  std::vector<unsigned char> m_encoded;
+  std::vector<tparchive::RowGroupMeta> m_groups;
+};
+
+/**
+ * @brief TpArchiveReader maps a TpArchive file and answers TpQuery selections.
+ * Errors (missing file, bad magic or version, truncated file) throw std::runtime_error.
+ */
+class TpArchiveReader
+{
+public:
+  explicit TpArchiveReader(const std::string& path);
+  ~TpArchiveReader();
+
+  TpArchiveReader(const TpArchiveReader&) = delete;
+  TpArchiveReader& operator=(const TpArchiveReader&) = delete;
+
+  uint64_t n_rows() const noexcept { return m_trailer.n_rows; }             // NOLINT(build/unsigned)
+  std::size_t n_row_groups() const noexcept { return m_trailer.n_row_groups; }
+  const tparchive::RowGroupMeta& row_group(std::size_t i) const noexcept { return m_groups[i]; }
+
+  /**
+   * @brief Whether the zone maps of row group @p i allow rows matching @p query.
+   */
+  bool may_match(std::size_t i, const TpQuery& query) const noexcept;
+
+  /**
+   * @brief Call @p emit with every row matching @p query, in file order.
+   * @return Number of row groups that were actually decoded
+   */
+  template<class Emit>
+  std::size_t scan(const TpQuery& query, Emit&& emit) const;
+
+  /**
+   * @brief Append the rows matching @p query to @p out; returns the number of row groups decoded.
+   */
+  std::size_t query(const TpQuery& query, std::vector<TpRow>& out) const;
+
+  /**
+   * @brief Decode column @p column of row group @p group into @p out (n_rows values).
+   */
+  void decode_column(std::size_t group, tparchive::Column column, uint64_t* out) const; // NOLINT(build/unsigned)
+
+private:
+  // Decode only the @p n rows listed in @p selection, in order, into out[0..n)
+  void gather_column(std::size_t group,
+                     tparchive::Column column,
+                     const uint32_t* selection, // NOLINT(build/unsigned)
+                     std::size_t n,
+                     uint64_t* out) const; // NOLINT(build/unsigned)
+
+  int m_fd{ -1 };
+  const unsigned char* m_data{ nullptr };
+  std::size_t m_size{ 0 };
+  tparchive::Trailer m_trailer{};
+  const tparchive::RowGroupMeta* m_groups{ nullptr };
+};
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/TpArchive.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPARCHIVE_HPP_
@@ -0,0 +1,145 @@
+/**
+ * @file TpClusterer.hpp Streaming time/channel clustering of trigger primitives
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPCLUSTERER_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPCLUSTERER_HPP_
+
+#include "detdataformats/TpStitcher.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief A group of hits adjacent in channel and overlapping (within a tolerance) in time.
+ */
+struct TpCluster
+{
+  uint64_t start_time;   // NOLINT(build/unsigned)
+  uint64_t end_time;     // NOLINT(build/unsigned)
+  uint64_t peak_time;    // NOLINT(build/unsigned)
+  uint32_t channel_min;  // NOLINT(build/unsigned)
+  uint32_t channel_max;  // NOLINT(build/unsigned)
+  uint32_t peak_channel; // NOLINT(build/unsigned)
+  uint32_t sum_adc;      // NOLINT(build/unsigned)
+  uint32_t n_hits;       // NOLINT(build/unsigned)
+  uint16_t peak_adc;     // NOLINT(build/unsigned)
+  uint16_t tp_flags;     // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief TpClusterer groups time-ordered hits into TpCluster records.
+ *
+ * A hit joins every open cluster that has a hit within max_channel_gap channels whose end time
+ * is no more than max_time_gap ticks before the new hit's start; clusters it bridges are merged.
+ * Neighbours are found through a per-channel bitmap, so the cost of a hit depends on the channel
+ * gap and not on the number of open clusters. A cluster is emitted once the hit stream has moved
+ * more than max_time_gap past its end time. The expiry times of open clusters are kept in a
+ * contiguous array next to the list of open clusters, so the expiry check is a short linear
+ * scan that only runs when the earliest expiry has been passed.
+ */
+class TpClusterer
+{
+public:
+  struct Config
+  {
+    uint32_t max_channel_gap{ 1 }; // NOLINT(build/unsigned)
+    uint64_t max_time_gap{ 0 };    // NOLINT(build/unsigned)
+    uint32_t min_hits{ 1 };        // NOLINT(build/unsigned)
+  };
+
+  TpClusterer(std::size_t n_channels, const Config& config);
+
+  /**
+   * @brief Add a hit; hits are expected in non-decreasing start_time order. @p emit is called with
+   * each cluster that is closed by the progress of time.
+   */
+  template<class Emit>
+  void add(uint32_t channel,                   // NOLINT(build/unsigned)
+           uint64_t start_time,                // NOLINT(build/unsigned)
+           uint64_t end_time,                  // NOLINT(build/unsigned)
+           uint64_t peak_time,                 // NOLINT(build/unsigned)
+           uint16_t peak_adc,                  // NOLINT(build/unsigned)
+           uint32_t sum_adc,                   // NOLINT(build/unsigned)
+           uint16_t tp_flags,                  // NOLINT(build/unsigned)
+           Emit&& emit);
+
+  template<class Emit>
+  void add(const StitchedHit& hit, Emit&& emit)
+  {
+    add(hit.channel, hit.start_time, hit.end_time, hit.peak_time, hit.peak_adc, hit.sum_adc, hit.tp_flags, emit);
+  }
+
+  /**
+   * @brief Emit the clusters that can no longer grow once the stream has reached @p timestamp.
+   */
+  template<class Emit>
+  void advance(uint64_t timestamp, Emit&& emit); // NOLINT(build/unsigned)
+
+  /**
+   * @brief Emit every open cluster. Later hits start new clusters, whatever their time.
+   */
+  template<class Emit>
+  void flush(Emit&& emit);
+
+  const Config& config() const noexcept { return m_config; }
+  std::size_t n_open() const noexcept { return m_open.size(); }
+  uint64_t n_dropped_hits() const noexcept { return m_n_dropped_hits; }           // NOLINT(build/unsigned)
+  uint64_t n_out_of_order_hits() const noexcept { return m_n_out_of_order_hits; } // NOLINT(build/unsigned)
+
+private:
+  using slot_t = uint32_t; // NOLINT(build/unsigned)
+  static constexpr slot_t s_no_slot = std::numeric_limits<slot_t>::max();
+  static constexpr uint64_t s_never = std::numeric_limits<uint64_t>::max(); // NOLINT(build/unsigned)
+
+  struct ChannelState
+  {
+    uint64_t end_time; // NOLINT(build/unsigned)
+    slot_t cluster;
+  };
+
+  struct Slot
+  {
+    TpCluster cluster;
+    slot_t parent;     ///< Itself for an open cluster, the absorbing cluster for merged ones
+    slot_t next_alias; ///< Chain of slots merged into this one, released with it
+    slot_t alias_tail;
+    std::size_t open_index;
+  };
+
+  slot_t find(slot_t s) noexcept;
+  slot_t allocate();
+  void release(slot_t root);
+  slot_t merge(slot_t a, slot_t b) noexcept;
+  void remove_open(std::size_t open_index) noexcept;
+  template<class Emit>
+  void close(std::size_t open_index, Emit& emit);
+
+  Config m_config;
+  std::size_t m_n_channels;
+  std::vector<uint64_t> m_active_bits;   ///< One bit per channel holding a recent hit // NOLINT(build/unsigned)
+  std::vector<ChannelState> m_channels;  ///< Last hit of each channel
+
+  std::vector<Slot> m_slots;
+  std::vector<slot_t> m_free_slots;
+  std::vector<slot_t> m_open;
+  std::vector<uint64_t> m_open_expiry; ///< end_time + max_time_gap of each open cluster // NOLINT
+  uint64_t m_next_expiry{ s_never };   // NOLINT(build/unsigned)
+  uint64_t m_last_start{ 0 };            // NOLINT(build/unsigned)
+  uint64_t m_n_dropped_hits{ 0 };        // NOLINT(build/unsigned)
+  uint64_t m_n_out_of_order_hits{ 0 };   // NOLINT(build/unsigned)
+};
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/TpClusterer.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPCLUSTERER_HPP_
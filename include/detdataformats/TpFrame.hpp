@@ -0,0 +1,160 @@
+/**
+ * @file TpFrame.hpp Views over buffers of raw Trigger Primitive frames
+ *
+ * A raw TP frame, as it is sent by the firmware, is one TpHeader followed by
+ * TpHeader::m_nhits TpData blocks. Both the fwtp and the wib layouts keep
+ * m_nhits in the same place, so the same walker serves both.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPFRAME_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPFRAME_HPP_
+
+#include "detdataformats/fwtp/RawTp.hpp"
+#include "detdataformats/wib/RawWIBTp.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief Number of hits of the raw TP frame starting at @p frame, read from the header's m_nhits field.
+ */
+inline std::size_t
+tp_frame_nhits(const void* frame) noexcept
+{
+  uint32_t word; // NOLINT(build/unsigned)
+  std::memcpy(&word, static_cast<const unsigned char*>(frame) + 4 * sizeof(word), sizeof(word));
+  return word >> 16;
+}
+
+/**
+ * @brief Size in bytes of the raw TP frame starting at @p frame (header plus hits).
+ */
+inline std::size_t
+tp_frame_size(const void* frame) noexcept
+{
+  return sizeof(fwtp::TpHeader) + tp_frame_nhits(frame) * sizeof(fwtp::TpData);
+}
+
+/**
+ * @brief Non-owning reference to one raw TP frame inside a buffer.
+ */
+template<class Header, class Data>
+struct TpFrameRef
+{
+  const Header* header;
+  const Data* hits;
+  std::size_t nhits;
+
+  uint64_t get_timestamp() const { return header->get_timestamp(); } // NOLINT(build/unsigned)
+  std::size_t size() const { return sizeof(Header) + nhits * sizeof(Data); }
+};
+
+/**
+ * @brief Forward range over the complete raw TP frames of a buffer.
+ *
+ * Iteration stops at the first frame that does not fit entirely in the buffer;
+ * bytes_consumed() tells where that truncated frame starts.
+ */
+template<class Header, class Data>
+class TpFrameRange
+{
+public:
+  using frame_t = TpFrameRef<Header, Data>;
+
+  class iterator
+  {
+  public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = frame_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const frame_t*;
+    using reference = const frame_t&;
+
+    iterator() = default;
+    iterator(const unsigned char* pos, const unsigned char* end) noexcept
+      : m_pos(pos)
+      , m_end(end)
+    {
+      validate();
+    }
+
+    reference operator*() const noexcept { return m_frame; }
+    pointer operator->() const noexcept { return &m_frame; }
+
+    iterator& operator++() noexcept
+    {
+      m_pos += m_frame.size();
+      validate();
+      return *this;
+    }
+    iterator operator++(int) noexcept
+    {
+      auto tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    bool operator==(const iterator& other) const noexcept { return m_pos == other.m_pos; }
+    bool operator!=(const iterator& other) const noexcept { return m_pos != other.m_pos; }
+
+    const unsigned char* position() const noexcept { return m_pos; }
+
+  private:
+    void validate() noexcept
+    {
+      if (m_pos == nullptr)
+        return;
+      const std::size_t left = m_end - m_pos;
+      if (left < sizeof(Header) || left < tp_frame_size(m_pos)) {
+        m_pos = nullptr;
+        return;
+      }
+      m_frame.header = reinterpret_cast<const Header*>(m_pos);
+      m_frame.hits = reinterpret_cast<const Data*>(m_pos + sizeof(Header));
+      m_frame.nhits = tp_frame_nhits(m_pos);
+    }
+
+    const unsigned char* m_pos{ nullptr };
+    const unsigned char* m_end{ nullptr };
+    frame_t m_frame{};
+  };
+
+  TpFrameRange(const void* buffer, std::size_t size) noexcept
+    : m_begin(static_cast<const unsigned char*>(buffer))
+    , m_end(m_begin + size)
+  {}
+
+  iterator begin() const noexcept { return iterator(m_begin, m_end); }
+  iterator end() const noexcept { return iterator(); }
+
+  /**
+   * @brief Number of bytes covered by complete frames.
+   */
+  std::size_t bytes_consumed() const noexcept
+  {
+    const unsigned char* pos = m_begin;
+    while (static_cast<std::size_t>(m_end - pos) >= sizeof(Header) &&
+           static_cast<std::size_t>(m_end - pos) >= tp_frame_size(pos))
+      pos += tp_frame_size(pos);
+    return pos - m_begin;
+  }
+
+private:
+  const unsigned char* m_begin;
+  const unsigned char* m_end;
+};
+
+using FwtpFrameRange = TpFrameRange<fwtp::TpHeader, fwtp::TpData>;
+using WIBFrameRange = TpFrameRange<wib::TpHeader, wib::TpData>;
+
+} // namespace dunedaq::detdataformats
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPFRAME_HPP_
@@ -0,0 +1,219 @@
+/**
+ * @file TpSliceIndex.hpp Per-time-slice active channel bitmaps and frame offsets over raw TP frames
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPSLICEINDEX_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPSLICEINDEX_HPP_
+
+#include "detdataformats/ChannelMap.hpp"
+#include "detdataformats/TpFrame.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief ChannelBitmap is a set of channel numbers stored as 512-bit blocks, keeping only the
+ * blocks that have a bit set.
+ *
+ * Block indices are kept sorted, so union and intersection are a merge over the index lists
+ * followed by word-wise OR/AND of the matching 64-byte blocks, which the compiler turns into
+ * vector instructions.
+ */
+class ChannelBitmap
+{
+public:
+  using channel_t = uint32_t; // NOLINT(build/unsigned)
+
+  static constexpr std::size_t s_words_per_block = 8;
+  static constexpr std::size_t s_block_bits = 64 * s_words_per_block;
+
+  struct alignas(64) Block
+  {
+    uint64_t words[s_words_per_block]; // NOLINT(build/unsigned)
+  };
+
+  ChannelBitmap() = default;
+
+  /**
+   * @brief Bitmap of @p channels, given in any order and possibly repeated.
+   */
+  static ChannelBitmap from_channels(std::vector<channel_t> channels);
+  /**
+   * @brief Bitmap of the channels in [@p first, @p last).
+   */
+  static ChannelBitmap range(channel_t first, channel_t last);
+
+  bool empty() const noexcept { return m_ids.empty(); }
+  bool test(channel_t channel) const noexcept;
+  /// Number of channels set
+  std::size_t count() const noexcept;
+  std::vector<channel_t> channels() const;
+  bool intersects(const ChannelBitmap& other) const noexcept;
+
+  ChannelBitmap& operator|=(const ChannelBitmap& other);
+  ChannelBitmap& operator&=(const ChannelBitmap& other);
+
+  std::size_t n_blocks() const noexcept { return m_ids.size(); }
+  std::size_t memory_bytes() const noexcept
+  {
+    return m_ids.capacity() * sizeof(uint32_t) + m_blocks.capacity() * sizeof(Block); // NOLINT(build/unsigned)
+  }
+
+  friend bool operator==(const ChannelBitmap& a, const ChannelBitmap& b) noexcept;
+
+private:
+  std::vector<uint32_t> m_ids; ///< Sorted indices of the non-empty blocks // NOLINT(build/unsigned)
+  std::vector<Block> m_blocks;
+};
+
+inline ChannelBitmap
+operator|(ChannelBitmap a, const ChannelBitmap& b)
+{
+  return a |= b;
+}
+
+inline ChannelBitmap
+operator&(ChannelBitmap a, const ChannelBitmap& b)
+{
+  return a &= b;
+}
+
+/**
+ * @brief A run of consecutive raw TP frames, as a byte range of the indexed stream.
+ */
+struct TpFrameRun
+{
+  uint64_t offset; // NOLINT(build/unsigned)
+  uint64_t size;   // NOLINT(build/unsigned)
+};
+
+/**
+ * @brief TpSliceIndex records, for every fixed-width time slice, which offline channels had a TP
+ * and where the frames of that slice are.
+ *
+ * Frames are assigned to the slice holding their TpHeader timestamp and need not arrive in time
+ * order. Offsets count bytes across all add() calls, so the index refers to the frames in place:
+ * a caller appending to one buffer (or file) resolves offsets against its start and gets frame
+ * ranges back without copying. Region queries skip the slices whose bitmap misses the requested
+ * channels and return the frame runs of the others.
+ */
+template<class Layout>
+class TpSliceIndex
+{
+public:
+  using channel_map_t = ChannelMap<Layout>;
+  using channel_t = typename channel_map_t::channel_t;
+  using header_t = typename Layout::header_t;
+  using data_t = typename Layout::data_t;
+  using frame_t = TpFrameRef<header_t, data_t>;
+
+  struct Config
+  {
+    uint64_t slice_ticks = 62500; ///< 1 ms at 62.5 MHz // NOLINT(build/unsigned)
+  };
+
+  struct Slice
+  {
+    ChannelBitmap channels;
+    std::vector<TpFrameRun> runs; ///< In stream order
+    uint64_t n_frames{ 0 };       // NOLINT(build/unsigned)
+    uint64_t n_hits{ 0 };         // NOLINT(build/unsigned)
+  };
+
+  /**
+   * @brief The channel map must be compiled and must outlive the index. Throws
+   * std::invalid_argument for a zero slice width.
+   */
+  TpSliceIndex(const channel_map_t& channel_map, const Config& config);
+
+  /**
+   * @brief Index the complete raw TP frames of a buffer, which continues the stream where the
+   * previous add() stopped. Frames with unmapped geometry are counted but not indexed.
+   * @return Number of bytes consumed; a trailing truncated frame must be passed again
+   */
+  std::size_t add(const void* buffer, std::size_t size);
+
+  uint64_t slice_of(uint64_t timestamp) const noexcept { return timestamp / m_config.slice_ticks; } // NOLINT
+
+  /**
+   * @brief The slice with number @p slice, or nullptr if it has no frames.
+   */
+  const Slice* slice(uint64_t slice) const noexcept; // NOLINT(build/unsigned)
+
+  /// Channels with a TP in any slice overlapping [t0, t1)
+  ChannelBitmap active_in_any(uint64_t t0, uint64_t t1) const; // NOLINT(build/unsigned)
+  /// Channels with a TP in every slice overlapping [t0, t1)
+  ChannelBitmap active_in_all(uint64_t t0, uint64_t t1) const; // NOLINT(build/unsigned)
+
+  /**
+   * @brief Append to @p out the frame runs of the slices overlapping [t0, t1) that have a TP on a
+   * channel in [first_channel, last_channel). Runs may hold frames outside the region; see
+   * for_each_frame() for an exact selection.
+   * @return Number of slices whose frames were selected
+   */
+  std::size_t find(uint64_t t0, // NOLINT(build/unsigned)
+                   uint64_t t1, // NOLINT(build/unsigned)
+                   channel_t first_channel,
+                   channel_t last_channel,
+                   std::vector<TpFrameRun>& out) const;
+
+  /**
+   * @brief Call @p f(const frame_t&) for every indexed frame with a timestamp in [t0, t1) and a
+   * channel in [first_channel, last_channel). @p stream is the start of the indexed byte stream.
+   * @return Number of frames passed to @p f
+   */
+  template<class F>
+  std::size_t for_each_frame(const void* stream,
+                             uint64_t t0, // NOLINT(build/unsigned)
+                             uint64_t t1, // NOLINT(build/unsigned)
+                             channel_t first_channel,
+                             channel_t last_channel,
+                             F&& f) const;
+
+  /**
+   * @brief Forget the slices that end at or before @p timestamp.
+   */
+  void erase_before(uint64_t timestamp); // NOLINT(build/unsigned)
+
+  std::size_t n_slices() const noexcept { return m_slices.size(); }
+  uint64_t bytes_indexed() const noexcept { return m_bytes_indexed; } // NOLINT(build/unsigned)
+  uint64_t n_frames() const noexcept { return m_n_frames; }           // NOLINT(build/unsigned)
+  uint64_t n_unmapped() const noexcept { return m_n_unmapped; }       // NOLINT(build/unsigned)
+  std::size_t memory_bytes() const noexcept;
+
+private:
+  using slice_map_t = std::map<uint64_t, Slice>; // NOLINT(build/unsigned)
+
+  // Slice numbers overlapping [t0, t1), as [first, last]; false if the interval is empty
+  bool slice_range(uint64_t t0, uint64_t t1, uint64_t& first, uint64_t& last) const noexcept; // NOLINT
+
+  const channel_map_t& m_channel_map;
+  Config m_config;
+  slice_map_t m_slices;
+  uint64_t m_bytes_indexed{ 0 }; // NOLINT(build/unsigned)
+  uint64_t m_n_frames{ 0 };      // NOLINT(build/unsigned)
+  uint64_t m_n_unmapped{ 0 };    // NOLINT(build/unsigned)
+
+  std::vector<const header_t*> m_header_scratch;
+  std::vector<std::size_t> m_offset_scratch;
+  std::vector<channel_t> m_channel_scratch;
+  std::vector<std::pair<uint64_t, channel_t>> m_pending; ///< (slice, channel) of one add() // NOLINT
+};
+
+using FwtpSliceIndex = TpSliceIndex<FwtpChannelLayout>;
+using WIBSliceIndex = TpSliceIndex<WIBChannelLayout>;
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/TpSliceIndex.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPSLICEINDEX_HPP_
@@ -0,0 +1,111 @@
+/**
+ * @file TpStitcher.hpp Streaming reassembly of trigger primitives split via m_hit_continue
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPSTITCHER_HPP_
+#define DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPSTITCHER_HPP_
+
+#include "detdataformats/ChannelMap.hpp"
+#include "detdataformats/TpFrame.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dunedaq::detdataformats {
+
+/**
+ * @brief A hit with all of its m_hit_continue fragments merged. Times are absolute
+ * (header timestamp plus the 16-bit TpData offsets) and sum_adc is widened so that
+ * long hits don't overflow.
+ */
+struct StitchedHit
+{
+  uint64_t start_time; // NOLINT(build/unsigned)
+  uint64_t end_time;   // NOLINT(build/unsigned)
+  uint64_t peak_time;  // NOLINT(build/unsigned)
+  uint32_t channel;    // NOLINT(build/unsigned)
+  uint32_t sum_adc;    // NOLINT(build/unsigned)
+  uint16_t peak_adc;   // NOLINT(build/unsigned)
+  uint16_t tp_flags;   // NOLINT(build/unsigned)
+  uint16_t n_fragments; // NOLINT(build/unsigned)
+  /// False when the hit was flushed before its last fragment arrived
+  bool complete;
+};
+
+/**
+ * @brief TpStitcher merges TpData fragments flagged with m_hit_continue into single hits.
+ *
+ * Frames must be fed in arrival order. Partial hits are kept in a table indexed by the
+ * dense channel number from a ChannelMap, plus a list of the channels that currently hold
+ * a partial hit, so flushing only touches active channels. Nothing is allocated per hit.
+ */
+template<class Layout>
+class TpStitcher
+{
+public:
+  using channel_map_t = ChannelMap<Layout>;
+  using header_t = typename Layout::header_t;
+  using data_t = typename Layout::data_t;
+  using frame_t = TpFrameRef<header_t, data_t>;
+
+  /**
+   * @brief The channel map must be compiled and must outlive the stitcher.
+   */
+  explicit TpStitcher(const channel_map_t& channel_map);
+
+  /**
+   * @brief Merge the hits of one frame; @p emit is called with each finished StitchedHit.
+   */
+  template<class Emit>
+  void process_frame(const frame_t& frame, Emit&& emit);
+
+  /**
+   * @brief Process all complete frames in a buffer, appending finished hits to @p out.
+   * @return Number of bytes consumed (a trailing truncated frame is left for the caller)
+   */
+  std::size_t process(const void* buffer, std::size_t size, std::vector<StitchedHit>& out);
+
+  /**
+   * @brief Emit, as incomplete, partial hits whose last fragment ended before @p timestamp.
+   * @return Number of hits flushed
+   */
+  template<class Emit>
+  std::size_t flush_stale(uint64_t timestamp, Emit&& emit); // NOLINT(build/unsigned)
+
+  /**
+   * @brief Emit every pending partial hit, e.g. at the end of a run.
+   */
+  template<class Emit>
+  std::size_t flush_all(Emit&& emit);
+
+  std::size_t n_pending() const noexcept { return m_active.size(); }
+  uint64_t n_unmapped_frames() const noexcept { return m_n_unmapped_frames; } // NOLINT(build/unsigned)
+  uint64_t n_stale_flushed() const noexcept { return m_n_stale_flushed; }     // NOLINT(build/unsigned)
+
+private:
+  static constexpr uint32_t s_not_active = std::numeric_limits<uint32_t>::max(); // NOLINT(build/unsigned)
+
+  void deactivate(uint32_t channel) noexcept; // NOLINT(build/unsigned)
+
+  const channel_map_t& m_channel_map;
+  std::vector<StitchedHit> m_partial;     ///< Indexed by channel
+  std::vector<uint32_t> m_active_slot;    ///< Position of each channel in m_active, or s_not_active // NOLINT
+  std::vector<uint32_t> m_active;         ///< Channels with a pending partial hit // NOLINT(build/unsigned)
+  uint64_t m_n_unmapped_frames{ 0 };      // NOLINT(build/unsigned)
+  uint64_t m_n_stale_flushed{ 0 };        // NOLINT(build/unsigned)
+};
+
+using FwtpStitcher = TpStitcher<FwtpChannelLayout>;
+using WIBStitcher = TpStitcher<WIBChannelLayout>;
+
+} // namespace dunedaq::detdataformats
+
+#include "detail/TpStitcher.hxx"
+
+#endif // DETDATAFORMATS_INCLUDE_DETDATAFORMATS_TPSTITCHER_HPP_
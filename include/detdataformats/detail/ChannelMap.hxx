@@ -0,0 +1,157 @@
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+namespace dunedaq::detdataformats {
+
+static_assert(sizeof(fwtp::TpHeader) == 24, "fwtp::TpHeader size different than expected!");
+static_assert(sizeof(wib::TpHeader) == 24, "wib::TpHeader size different than expected!");
+static_assert(FwtpChannelLayout::s_link_key_bits <= 32 && WIBChannelLayout::s_link_key_bits <= 32,
+              "Link keys must fit a 32-bit word");
+
+template<class Layout>
+ChannelMap<Layout>::ChannelMap(const std::vector<Entry>& entries)
+{
+  for (auto const& e : entries)
+    add(e.crate, e.slot, e.fiber, e.wire, e.channel);
+  compile();
+}
+
+template<class Layout>
+void
+ChannelMap<Layout>::add(uint32_t crate, uint32_t slot, uint32_t fiber, uint32_t wire, channel_t channel) // NOLINT
+{
+  if (crate >> Layout::s_crate_bits || slot >> Layout::s_slot_bits || fiber >> Layout::s_fiber_bits ||
+      wire >> Layout::s_wire_bits) {
+    std::ostringstream ostr;
+    ostr << "ChannelMap entry out of range for layout: crate=" << crate << " slot=" << slot << " fiber=" << fiber
+         << " wire=" << wire;
+    throw std::out_of_range(ostr.str());
+  }
+  if (channel == s_invalid_channel)
+    throw std::out_of_range("ChannelMap entry uses the reserved invalid channel number");
+
+  m_entries.push_back({ crate, slot, fiber, wire, channel });
+  m_compiled = false;
+}
+
+template<class Layout>
+void
+ChannelMap<Layout>::compile()
+{
+  m_link_table.clear();
+  m_wire_table.clear();
+  m_link_key_offset = 0;
+  m_max_channel = s_invalid_channel;
+
+  if (!m_entries.empty()) {
+    uint32_t min_key = std::numeric_limits<uint32_t>::max(); // NOLINT(build/unsigned)
+    uint32_t max_key = 0;                                    // NOLINT(build/unsigned)
+    for (auto const& e : m_entries) {
+      const uint32_t key = Layout::pack_link(e.crate, e.slot, e.fiber); // NOLINT(build/unsigned)
+      min_key = std::min(min_key, key);
+      max_key = std::max(max_key, key);
+    }
+    m_link_key_offset = min_key;
+    m_link_table.assign(std::size_t(max_key - min_key) + 1, s_no_link);
+
+    // Links are numbered in key order so that neighbouring geometry stays adjacent in the wire table
+    uint32_t n_links = 0; // NOLINT(build/unsigned)
+    for (auto const& e : m_entries)
+      m_link_table[Layout::pack_link(e.crate, e.slot, e.fiber) - min_key] = 0;
+    for (auto& link : m_link_table)
+      if (link != s_no_link)
+        link = n_links++;
+
+    m_wire_table.assign(std::size_t(n_links) * s_wires_per_link, s_invalid_channel);
+    for (auto const& e : m_entries) {
+      const uint32_t link = m_link_table[Layout::pack_link(e.crate, e.slot, e.fiber) - min_key]; // NOLINT
+      m_wire_table[link * s_wires_per_link + e.wire] = e.channel;
+      m_max_channel = m_max_channel == s_invalid_channel ? e.channel : std::max(m_max_channel, e.channel);
+    }
+  }
+  m_compiled = true;
+}
+
+template<class Layout>
+typename ChannelMap<Layout>::channel_t
+ChannelMap<Layout>::lookup(uint32_t crate, uint32_t slot, uint32_t fiber, uint32_t wire) const noexcept // NOLINT
+{
+  if (crate >> Layout::s_crate_bits || slot >> Layout::s_slot_bits || fiber >> Layout::s_fiber_bits ||
+      wire >> Layout::s_wire_bits)
+    return s_invalid_channel;
+
+  const uint32_t key = Layout::pack_link(crate, slot, fiber) - m_link_key_offset; // NOLINT(build/unsigned)
+  if (key >= m_link_table.size() || m_link_table[key] == s_no_link)
+    return s_invalid_channel;
+  return m_wire_table[m_link_table[key] * s_wires_per_link + wire];
+}
+
+template<class Layout>
+void
+ChannelMap<Layout>::lookup(const header_t* const* headers, std::size_t n, channel_t* out) const noexcept
+{
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = lookup_word(first_word(*headers[i]));
+}
+
+template<class Layout>
+void
+ChannelMap<Layout>::lookup(const void* first, std::size_t n, std::size_t stride, channel_t* out) const noexcept
+{
+  auto bytes = static_cast<const char*>(first);
+  for (std::size_t i = 0; i < n; ++i, bytes += stride) {
+    uint32_t word; // NOLINT(build/unsigned)
+    std::memcpy(&word, bytes, sizeof(word));
+    out[i] = lookup_word(word);
+  }
+}
+
+template<class Layout>
+ChannelMap<Layout>
+ChannelMap<Layout>::load(std::istream& is)
+{
+  ChannelMap map;
+  std::string line;
+  std::size_t line_no = 0;
+  while (std::getline(is, line)) {
+    ++line_no;
+    auto comment = line.find('#');
+    if (comment != std::string::npos)
+      line.erase(comment);
+    if (line.find_first_not_of(" \t\r") == std::string::npos)
+      continue;
+
+    std::istringstream iss(line);
+    uint64_t crate, slot, fiber, wire, channel; // NOLINT(build/unsigned)
+    if (!(iss >> crate >> slot >> fiber >> wire >> channel) || (crate | slot | fiber | wire) > 0xFFFFFFFF ||
+        channel >= s_invalid_channel) {
+      throw std::runtime_error("ChannelMap: malformed line " + std::to_string(line_no) + ": '" + line + "'");
+    }
+    try {
+      map.add(static_cast<uint32_t>(crate), // NOLINT(build/unsigned)
+              static_cast<uint32_t>(slot),  // NOLINT(build/unsigned)
+              static_cast<uint32_t>(fiber), // NOLINT(build/unsigned)
+              static_cast<uint32_t>(wire),  // NOLINT(build/unsigned)
+              static_cast<channel_t>(channel));
+    } catch (const std::out_of_range& e) {
+      throw std::runtime_error("ChannelMap: line " + std::to_string(line_no) + ": " + e.what());
+    }
+  }
+  map.compile();
+  return map;
+}
+
+template<class Layout>
+ChannelMap<Layout>
+ChannelMap<Layout>::load_from_file(const std::string& path)
+{
+  std::ifstream ifs(path);
+  if (!ifs)
+    throw std::runtime_error("ChannelMap: cannot open " + path);
+  return load(ifs);
+}
+
+} // namespace dunedaq::detdataformats
@@ -0,0 +1,108 @@
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace dunedaq::detdataformats {
+
+static_assert(sizeof(CompactTp) == 16, "CompactTp struct size different than expected!");
+static_assert(std::is_trivially_copyable_v<CompactTp>, "CompactTp must be trivially copyable");
+
+template<class Layout>
+CompactTpCodec<Layout>::CompactTpCodec(const channel_map_t& channel_map)
+  : m_channel_map(channel_map)
+{
+  if (!channel_map.is_compiled())
+    throw std::invalid_argument("CompactTpCodec: the channel map must be compiled");
+  if (channel_map.max_channel() != channel_map_t::s_invalid_channel &&
+      channel_map.max_channel() > CompactTp::s_max_channel)
+    throw std::invalid_argument("CompactTpCodec: channel " + std::to_string(channel_map.max_channel()) +
+                                " does not fit in a CompactTp");
+
+  const std::size_t n_channels =
+    channel_map.max_channel() == channel_map_t::s_invalid_channel ? 0 : std::size_t(channel_map.max_channel()) + 1;
+  m_geometry_word.assign(n_channels, 0);
+  m_mapped.assign(n_channels, false);
+  for (auto const& e : channel_map.entries()) {
+    header_t header;
+    std::memset(static_cast<void*>(&header), 0, sizeof(header));
+    header.m_crate_no = e.crate;
+    header.m_slot_no = e.slot;
+    header.m_fiber_no = e.fiber;
+    header.m_wire_no = e.wire;
+    m_geometry_word[e.channel] = channel_map_t::first_word(header);
+    m_mapped[e.channel] = true;
+  }
+}
+
+template<class Layout>
+std::size_t
+CompactTpCodec<Layout>::pack(const void* buffer, std::size_t size, std::vector<CompactTp>& out)
+{
+  TpFrameRange<header_t, data_t> frames(buffer, size);
+  const unsigned char* last_end = static_cast<const unsigned char*>(buffer);
+  out.reserve(out.size() + size / s_unpacked_size);
+  for (auto it = frames.begin(); it != frames.end(); ++it) {
+    last_end = it.position() + it->size();
+    ++m_counters.n_frames;
+    const uint32_t channel = m_channel_map.lookup(*it->header); // NOLINT(build/unsigned)
+    if (channel == channel_map_t::s_invalid_channel) {
+      m_counters.n_unmapped += it->nhits;
+      continue;
+    }
+    const uint64_t t0 = it->header->get_timestamp(); // NOLINT(build/unsigned)
+    for (std::size_t h = 0; h < it->nhits; ++h) {
+      const data_t& d = it->hits[h];
+      const uint32_t start = d.m_start_time; // NOLINT(build/unsigned)
+      const uint32_t end = d.m_end_time;     // NOLINT(build/unsigned)
+      uint32_t tot = end > start ? end - start : 0; // NOLINT(build/unsigned)
+      if (tot > CompactTp::s_max_time_over_threshold) {
+        tot = CompactTp::s_max_time_over_threshold;
+        ++m_counters.n_saturated;
+      }
+      CompactTp tp;
+      tp.timestamp = t0 + start;
+      tp.channel = channel;
+      tp.time_over_threshold = tot;
+      tp.peak_adc = d.m_peak_adc;
+      tp.sum_adc = d.m_sum_adc;
+      out.push_back(tp);
+    }
+    m_counters.n_hits += it->nhits;
+  }
+  return last_end - static_cast<const unsigned char*>(buffer);
+}
+
+template<class Layout>
+std::size_t
+CompactTpCodec<Layout>::unpack(const CompactTp* tps, std::size_t n, void* buffer, std::size_t capacity) const
+{
+  n = std::min(n, capacity / s_unpacked_size);
+  auto bytes = static_cast<unsigned char*>(buffer);
+  for (std::size_t i = 0; i < n; ++i, bytes += s_unpacked_size) {
+    const CompactTp& tp = tps[i];
+    if (tp.channel >= m_mapped.size() || !m_mapped[tp.channel])
+      throw std::out_of_range("CompactTpCodec: channel " + std::to_string(tp.channel) + " is not mapped");
+
+    header_t header;
+    std::memset(static_cast<void*>(&header), 0, sizeof(header));
+    std::memcpy(static_cast<void*>(&header), &m_geometry_word[tp.channel], sizeof(uint32_t)); // NOLINT(build/unsigned)
+    header.set_timestamp(tp.timestamp);
+    header.set_nhits(1);
+
+    data_t data;
+    std::memset(static_cast<void*>(&data), 0, sizeof(data));
+    data.m_start_time = 0;
+    data.m_end_time = tp.time_over_threshold;
+    data.m_peak_adc = tp.peak_adc;
+    data.m_sum_adc = tp.sum_adc;
+
+    std::memcpy(bytes, &header, sizeof(header));
+    std::memcpy(bytes + sizeof(header), &data, sizeof(data));
+  }
+  return n;
+}
+
+} // namespace dunedaq::detdataformats
@@ -0,0 +1,195 @@
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace dunedaq::detdataformats {
+
+template<class Header>
+DetIdDemux<Header>::DetIdDemux(const Config& config)
+  : m_config(config)
+{
+  if (m_config.block_size == 0 && !std::is_same_v<Header, DAQEthHeader>)
+    throw std::invalid_argument("DetIdDemux: a block size is needed for headers without a block length");
+  if (m_config.block_size != 0 && m_config.block_size < sizeof(Header))
+    throw std::invalid_argument("DetIdDemux: block size " + std::to_string(m_config.block_size) +
+                                " is smaller than a header");
+
+  const std::string unknown = DetID::subdetector_to_string(DetID::Subdetector::kUnknown);
+  for (std::size_t d = 0; d < s_n_det_ids; ++d) {
+    const auto subdetector = static_cast<DetID::Subdetector>(d);
+    const bool known = subdetector != DetID::Subdetector::kUnknown && DetID::subdetector_to_string(subdetector) != unknown;
+    m_route[d] = known ? d : s_quarantine;
+  }
+}
+
+template<class Header>
+std::size_t
+DetIdDemux<Header>::frame_blocks(const unsigned char* buffer, std::size_t size)
+{
+  // The length of a block is only known from its header, so this walk is sequential. It reads the
+  // det_id while the header is loaded, which leaves only counting to the parallel pass
+  m_offsets.clear();
+  m_destination.clear();
+  std::size_t offset = 0;
+  while (offset + sizeof(Header) <= size) {
+    Header h;
+    std::memcpy(&h, buffer + offset, sizeof(h));
+    const std::size_t length = sizeof(Header) + 8 * std::size_t(h.block_length);
+    if (offset + length > size)
+      break;
+    m_offsets.push_back(offset);
+    m_destination.push_back(m_route[h.det_id]);
+    offset += length;
+  }
+  m_offsets.push_back(offset);
+  return offset;
+}
+
+template<class Header>
+BlockRef
+DetIdDemux<Header>::block(std::size_t i) const noexcept
+{
+  if (m_config.block_size != 0)
+    return { i * m_config.block_size, m_config.block_size };
+  return { m_offsets[i], m_offsets[i + 1] - m_offsets[i] };
+}
+
+template<class Header>
+DetIdDemux<Header>::Workers::~Workers()
+{
+  {
+    std::lock_guard<std::mutex> lk(mutex);
+    stop = true;
+  }
+  cv.notify_all();
+  for (auto& t : threads)
+    t.join();
+}
+
+template<class Header>
+void
+DetIdDemux<Header>::Workers::loop(unsigned t, uint64_t seen) // NOLINT(build/unsigned)
+{
+  std::unique_lock<std::mutex> lk(mutex);
+  while (true) {
+    cv.wait(lk, [&] { return stop || generation != seen; });
+    if (generation == seen)
+      return;
+    seen = generation;
+    if (t >= n_parts)
+      continue;
+    lk.unlock();
+    call(context, t);
+    lk.lock();
+    if (--n_busy == 0)
+      cv.notify_all();
+  }
+}
+
+template<class Header>
+template<class F>
+void
+DetIdDemux<Header>::run(unsigned n_threads, F&& f)
+{
+  // Thread t handles blocks [t * n / n_threads, (t + 1) * n / n_threads)
+  auto work = [&](unsigned t) { f(t, t * m_n_input / n_threads, (t + 1) * m_n_input / n_threads); };
+  if (n_threads == 1) {
+    work(0);
+    return;
+  }
+
+  if (!m_workers)
+    m_workers = std::make_unique<Workers>();
+  Workers& w = *m_workers;
+  // A thread that fails to start throws here; those already running are joined by ~Workers
+  w.threads.reserve(n_threads - 1);
+  while (w.threads.size() + 1 < n_threads)
+    w.threads.emplace_back(&Workers::loop, &w, unsigned(w.threads.size() + 1), w.generation);
+
+  {
+    std::lock_guard<std::mutex> lk(w.mutex);
+    w.call = [](const void* context, unsigned t) { (*static_cast<const decltype(work)*>(context))(t); };
+    w.context = &work;
+    w.n_parts = n_threads;
+    w.n_busy = n_threads - 1;
+    ++w.generation;
+  }
+  w.cv.notify_all();
+  work(0);
+  std::unique_lock<std::mutex> lk(w.mutex);
+  w.cv.wait(lk, [&] { return w.n_busy == 0; });
+}
+
+template<class Header>
+std::size_t
+DetIdDemux<Header>::demux(const void* buffer, std::size_t size, unsigned n_threads)
+{
+  m_buffer = static_cast<const unsigned char*>(buffer);
+  std::size_t consumed = 0;
+  if (m_config.block_size != 0) {
+    m_n_input = size / m_config.block_size;
+    consumed = m_n_input * m_config.block_size;
+  } else if constexpr (std::is_same_v<Header, DAQEthHeader>) {
+    consumed = frame_blocks(m_buffer, size);
+    m_n_input = m_offsets.size() - 1;
+  }
+
+  const std::size_t by_size = std::max<std::size_t>(m_n_input / std::max<std::size_t>(m_config.min_blocks_per_thread, 1), 1);
+  n_threads = static_cast<unsigned>(std::min<std::size_t>(std::max(n_threads, 1u), by_size));
+  m_n_threads_used = n_threads;
+  m_destination.resize(m_n_input);
+  m_counts.assign(n_threads, count_t{});
+
+  // Count: the destination of every block is kept so that the scatter doesn't reload headers
+  const bool routed = m_config.block_size == 0;
+  run(n_threads, [this, routed](unsigned t, std::size_t first, std::size_t last) {
+    count_t& counts = m_counts[t];
+    for (std::size_t i = first; i < last; ++i) {
+      if (!routed) {
+        Header h;
+        std::memcpy(&h, m_buffer + i * m_config.block_size, sizeof(h));
+        m_destination[i] = m_route[h.det_id];
+      }
+      ++counts[m_destination[i]];
+    }
+  });
+
+  // Prefix sum, output-major so that each output is one contiguous range in buffer order; the
+  // counts become the write cursors of each thread
+  std::size_t total = 0;
+  for (std::size_t d = 0; d < s_n_outputs; ++d) {
+    m_begin[d] = total;
+    for (auto& counts : m_counts) {
+      const std::size_t n = counts[d];
+      counts[d] = total;
+      total += n;
+    }
+  }
+  m_begin[s_n_outputs] = total;
+  m_blocks.resize(total);
+
+  // Scatter: every (output, thread) slice is written by one thread only
+  run(n_threads, [this](unsigned t, std::size_t first, std::size_t last) {
+    count_t& cursor = m_counts[t];
+    BlockRef* out = m_blocks.data();
+    for (std::size_t i = first; i < last; ++i)
+      out[cursor[m_destination[i]]++] = block(i);
+  });
+
+  return consumed;
+}
+
+template<class Header>
+BlockRange
+DetIdDemux<Header>::output(DetID::Subdetector subdetector) const noexcept
+{
+  const auto d = static_cast<std::size_t>(subdetector);
+  if (d >= s_n_det_ids || m_route[d] == s_quarantine)
+    return { m_blocks.data(), m_blocks.data() };
+  return range(d);
+}
+
+} // namespace dunedaq::detdataformats
@@ -0,0 +1,173 @@
+
+#include <stdexcept>
+#include <string>
+
+namespace dunedaq::detdataformats {
+
+inline EthReorderBuffer::EthReorderBuffer(const Config& config)
+  : m_config(config)
+  , m_mask(config.window_size - 1)
+{
+  if (config.window_size == 0 || (config.window_size & m_mask) != 0 || config.window_size > s_seq_id_modulo / 2)
+    throw std::invalid_argument("EthReorderBuffer: the window size must be a power of two no larger than " +
+                                std::to_string(s_seq_id_modulo / 2));
+}
+
+inline uint32_t // NOLINT(build/unsigned)
+EthReorderBuffer::find_stream(uint32_t key, uint32_t first_seq_id) // NOLINT(build/unsigned)
+{
+  if (key == m_last_key)
+    return m_last_index;
+
+  auto it = m_stream_index.find(key);
+  if (it == m_stream_index.end()) {
+    Stream stream;
+    stream.expected_seq_id = first_seq_id;
+    stream.slot_base = m_slots.size();
+    m_slots.resize(m_slots.size() + m_config.window_size, nullptr);
+    it = m_stream_index.emplace(key, m_streams.size()).first;
+    m_streams.push_back(stream);
+    m_pending_streams.reserve(m_streams.size());
+  }
+  m_last_key = key;
+  m_last_index = it->second;
+  return m_last_index;
+}
+
+inline void
+EthReorderBuffer::set_pending(Stream& stream, bool pending)
+{
+  if (pending == (stream.pending_index != s_not_pending))
+    return;
+  if (pending) {
+    stream.pending_index = m_pending_streams.size();
+    m_pending_streams.push_back(&stream - m_streams.data());
+  } else {
+    const uint32_t last = m_pending_streams.back(); // NOLINT(build/unsigned)
+    m_pending_streams[stream.pending_index] = last;
+    m_streams[last].pending_index = stream.pending_index;
+    m_pending_streams.pop_back();
+    stream.pending_index = s_not_pending;
+  }
+}
+
+template<class Emit>
+void
+EthReorderBuffer::release_run(Stream& stream, uint64_t now, Emit& emit) // NOLINT(build/unsigned)
+{
+  while (stream.n_buffered > 0) {
+    const DAQEthHeader*& next = slot(stream, stream.expected_seq_id);
+    if (next == nullptr)
+      break;
+    emit(next);
+    next = nullptr;
+    stream.expected_seq_id = (stream.expected_seq_id + 1) & (s_seq_id_modulo - 1);
+    --stream.n_buffered;
+    --m_n_buffered;
+    ++m_counters.n_released;
+  }
+  // Whatever is still buffered is now waiting on a new hole
+  stream.hole_since = now;
+  set_pending(stream, stream.n_buffered > 0);
+}
+
+template<class Emit>
+void
+EthReorderBuffer::skip_hole(Stream& stream, uint64_t now, Emit& emit) // NOLINT(build/unsigned)
+{
+  while (stream.n_buffered > 0 && slot(stream, stream.expected_seq_id) == nullptr) {
+    stream.expected_seq_id = (stream.expected_seq_id + 1) & (s_seq_id_modulo - 1);
+    ++m_counters.n_lost;
+  }
+  release_run(stream, now, emit);
+}
+
+template<class Emit>
+void
+EthReorderBuffer::skip_to(Stream& stream, uint32_t seq_id, uint64_t now, Emit& emit) // NOLINT(build/unsigned)
+{
+  // Slide the window forward to start at seq_id, releasing what it leaves behind
+  while (stream.expected_seq_id != seq_id) {
+    const DAQEthHeader*& next = slot(stream, stream.expected_seq_id);
+    if (next != nullptr) {
+      emit(next);
+      next = nullptr;
+      --stream.n_buffered;
+      --m_n_buffered;
+      ++m_counters.n_released;
+    } else {
+      ++m_counters.n_lost;
+    }
+    stream.expected_seq_id = (stream.expected_seq_id + 1) & (s_seq_id_modulo - 1);
+  }
+  release_run(stream, now, emit);
+}
+
+template<class Emit>
+void
+EthReorderBuffer::push(const DAQEthHeader* packet, uint64_t now, Emit&& emit) // NOLINT(build/unsigned)
+{
+  const uint32_t seq_id = packet->seq_id; // NOLINT(build/unsigned)
+  Stream& stream = m_streams[find_stream(stream_key(*packet), seq_id)];
+
+  uint32_t delta = (seq_id - stream.expected_seq_id) & (s_seq_id_modulo - 1); // NOLINT(build/unsigned)
+  if (delta >= s_seq_id_modulo / 2) {
+    ++m_counters.n_late;
+    return;
+  }
+  if (delta >= m_config.window_size) {
+    skip_to(stream, (seq_id - m_config.window_size + 1) & (s_seq_id_modulo - 1), now, emit);
+    delta = (seq_id - stream.expected_seq_id) & (s_seq_id_modulo - 1);
+  }
+
+  const DAQEthHeader*& target = slot(stream, seq_id);
+  if (target != nullptr) {
+    ++m_counters.n_duplicates;
+    return;
+  }
+  target = packet;
+  ++stream.n_buffered;
+  ++m_n_buffered;
+
+  if (delta == 0) {
+    release_run(stream, now, emit);
+    return;
+  }
+
+  ++m_counters.n_reordered;
+  if (stream.n_buffered == 1) {
+    stream.hole_since = now;
+    set_pending(stream, true);
+  } else if (m_config.timeout != 0 && now - stream.hole_since > m_config.timeout) {
+    skip_hole(stream, now, emit);
+  }
+}
+
+template<class Emit>
+void
+EthReorderBuffer::expire(uint64_t now, Emit&& emit) // NOLINT(build/unsigned)
+{
+  if (m_config.timeout == 0)
+    return;
+
+  for (std::size_t i = 0; i < m_pending_streams.size();) {
+    Stream& stream = m_streams[m_pending_streams[i]];
+    if (now - stream.hole_since > m_config.timeout)
+      skip_hole(stream, now, emit);
+    // skip_hole may have removed the stream from the pending list, moving another one into position i
+    if (i < m_pending_streams.size() && &m_streams[m_pending_streams[i]] == &stream)
+      ++i;
+  }
+}
+
+template<class Emit>
+void
+EthReorderBuffer::flush(Emit&& emit)
+{
+  while (!m_pending_streams.empty()) {
+    Stream& stream = m_streams[m_pending_streams.back()];
+    skip_hole(stream, stream.hole_since, emit);
+  }
+}
+
+} // namespace dunedaq::detdataformats
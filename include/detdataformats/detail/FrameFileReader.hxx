@@ -0,0 +1,178 @@
+
+#include "detdataformats/TpFrame.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dunedaq::detdataformats {
+
+inline FrameFileReader::FrameFileReader(const std::string& path,
+                                        FrameKind kind,
+                                        std::size_t chunk_bytes,
+                                        std::size_t frame_size,
+                                        std::size_t prefetch_depth)
+  : m_kind(kind)
+  , m_chunk_bytes(chunk_bytes)
+  , m_frame_size(kind == FrameKind::kRawTp ? 0 : frame_size)
+  , m_prefetch_depth(prefetch_depth)
+{
+  if (m_kind == FrameKind::kFixedSize && m_frame_size == 0)
+    throw std::invalid_argument("FrameFileReader: fixed-size frames need a non-zero frame size");
+  if (m_chunk_bytes == 0 || m_prefetch_depth == 0)
+    throw std::invalid_argument("FrameFileReader: chunk size and prefetch depth must be non-zero");
+  // Fixed-size chunks always hold a whole number of frames, and at least one
+  if (m_kind == FrameKind::kFixedSize)
+    m_chunk_bytes = std::max<std::size_t>(1, m_chunk_bytes / m_frame_size) * m_frame_size;
+
+  m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT
+  if (m_fd < 0)
+    throw std::runtime_error("FrameFileReader: cannot open " + path + ": " + std::strerror(errno));
+  struct stat st;
+  if (::fstat(m_fd, &st) != 0) {
+    ::close(m_fd);
+    throw std::runtime_error("FrameFileReader: cannot stat " + path + ": " + std::strerror(errno));
+  }
+  m_file_size = st.st_size;
+#ifdef POSIX_FADV_SEQUENTIAL
+  ::posix_fadvise(m_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+  try {
+    m_thread = std::thread(&FrameFileReader::prefetch, this);
+  } catch (...) {
+    ::close(m_fd);
+    throw;
+  }
+}
+
+inline FrameFileReader::~FrameFileReader()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  if (m_thread.joinable())
+    m_thread.join();
+  ::close(m_fd);
+}
+
+inline std::shared_ptr<FrameChunk>
+FrameFileReader::next()
+{
+  std::unique_lock<std::mutex> lk(m_mutex);
+  m_cv.wait(lk, [this] { return !m_ready.empty() || m_eof || m_error; });
+  if (!m_ready.empty()) {
+    auto chunk = std::move(m_ready.front());
+    m_ready.pop_front();
+    lk.unlock();
+    m_cv.notify_all();
+    return chunk;
+  }
+  if (m_error)
+    std::rethrow_exception(m_error);
+  return nullptr;
+}
+
+inline void
+FrameFileReader::prefetch()
+{
+  uint64_t offset = 0; // NOLINT(build/unsigned)
+  try {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lk(m_mutex);
+        m_cv.wait(lk, [this] { return m_stop || m_ready.size() < m_prefetch_depth; });
+        if (m_stop)
+          return;
+      }
+      auto chunk = read_chunk(offset);
+      const bool eof = !chunk;
+      {
+        std::lock_guard<std::mutex> lk(m_mutex);
+        if (eof)
+          m_eof = true;
+        else
+          m_ready.push_back(std::move(chunk));
+      }
+      m_cv.notify_all();
+      if (eof)
+        return;
+    }
+  } catch (...) {
+    {
+      std::lock_guard<std::mutex> lk(m_mutex);
+      m_error = std::current_exception();
+    }
+    m_cv.notify_all();
+  }
+}
+
+inline std::shared_ptr<FrameChunk>
+FrameFileReader::read_chunk(uint64_t& offset) // NOLINT(build/unsigned)
+{
+  auto read_at = [this](unsigned char* dst, std::size_t n, uint64_t pos) { // NOLINT(build/unsigned)
+    std::size_t done = 0;
+    while (done < n) {
+      auto r = ::pread(m_fd, dst + done, n - done, pos + done);
+      if (r < 0) {
+        if (errno == EINTR)
+          continue;
+        throw std::runtime_error(std::string("FrameFileReader: read failed: ") + std::strerror(errno));
+      }
+      if (r == 0)
+        break;
+      done += r;
+    }
+    return done;
+  };
+
+  if (offset >= m_file_size)
+    return nullptr;
+
+  auto chunk = std::make_shared<FrameChunk>();
+  chunk->file_offset = offset;
+  std::size_t want = std::min<uint64_t>(m_chunk_bytes, m_file_size - offset); // NOLINT(build/unsigned)
+
+  if (m_kind == FrameKind::kFixedSize) {
+    want -= want % m_frame_size;
+    if (want == 0)
+      return nullptr;
+    chunk->data.reset(new unsigned char[want]);
+    chunk->size = read_at(chunk->data.get(), want, offset);
+    chunk->size -= chunk->size % m_frame_size;
+    chunk->n_frames = chunk->size / m_frame_size;
+  } else {
+    chunk->data.reset(new unsigned char[want]);
+    std::size_t got = read_at(chunk->data.get(), want, offset);
+    FwtpFrameRange frames(chunk->data.get(), got);
+    chunk->size = frames.bytes_consumed();
+
+    // A single frame larger than the chunk: grow the buffer to hold exactly that frame
+    if (chunk->size == 0 && got >= sizeof(fwtp::TpHeader)) {
+      const std::size_t frame_bytes = tp_frame_size(chunk->data.get());
+      if (frame_bytes > m_file_size - offset)
+        return nullptr;
+      chunk->data.reset(new unsigned char[frame_bytes]);
+      got = read_at(chunk->data.get(), frame_bytes, offset);
+      frames = FwtpFrameRange(chunk->data.get(), got);
+      chunk->size = frames.bytes_consumed();
+    }
+    for (auto it = frames.begin(); it != frames.end(); ++it)
+      chunk->frame_offsets.push_back(it.position() - chunk->data.get());
+    chunk->n_frames = chunk->frame_offsets.size();
+  }
+
+  if (chunk->n_frames == 0)
+    return nullptr;
+  offset += chunk->size;
+  return chunk;
+}
+
+} // namespace dunedaq::detdataformats
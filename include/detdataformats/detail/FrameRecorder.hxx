@@ -0,0 +1,268 @@
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace dunedaq::detdataformats {
+
+inline FrameRecorder::FrameRecorder(const std::string& path, const Config& config)
+  : m_config(config)
+{
+  if (m_config.alignment == 0 || (m_config.alignment & (m_config.alignment - 1)) != 0)
+    throw std::invalid_argument("FrameRecorder: alignment must be a power of two");
+  if (m_config.buffer_bytes == 0 || m_config.buffer_bytes % m_config.alignment != 0)
+    throw std::invalid_argument("FrameRecorder: buffer size must be a non-zero multiple of the alignment");
+  if (m_config.n_buffers == 0)
+    throw std::invalid_argument("FrameRecorder: at least one buffer is needed");
+
+  const int flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC; // NOLINT
+#ifdef O_DIRECT
+  if (m_config.direct_io) {
+    m_fd = ::open(path.c_str(), flags | O_DIRECT, 0644);
+    m_direct_io = m_fd >= 0;
+  }
+#endif
+  // Filesystems without O_DIRECT support (tmpfs, some network filesystems) refuse it at open
+  if (m_fd < 0)
+    m_fd = ::open(path.c_str(), flags, 0644);
+  if (m_fd < 0)
+    throw std::runtime_error("FrameRecorder: cannot open " + path + ": " + std::strerror(errno));
+
+  for (std::size_t i = 0; i < m_config.n_buffers; ++i) {
+    void* p = nullptr;
+    if (::posix_memalign(&p, m_config.alignment, m_config.buffer_bytes) != 0) {
+      ::close(m_fd);
+      throw std::bad_alloc();
+    }
+    m_buffers.emplace_back(static_cast<unsigned char*>(p));
+    m_free.push_back(i);
+  }
+
+  m_thread = std::thread(&FrameRecorder::write_loop, this);
+}
+
+inline FrameRecorder::~FrameRecorder()
+{
+  try {
+    close();
+  } catch (...) { // NOLINT(bugprone-empty-catch)
+    // Errors can only be reported by an explicit close()
+  }
+}
+
+inline void
+FrameRecorder::check_error()
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  if (m_error)
+    std::rethrow_exception(m_error);
+}
+
+inline void
+FrameRecorder::acquire_buffer()
+{
+  std::unique_lock<std::mutex> lk(m_mutex);
+  if (m_free.empty()) {
+    const auto start = clock_t::now();
+    m_cv.wait(lk, [this] { return !m_free.empty() || m_error; });
+    m_stats.blocked_seconds += std::chrono::duration<double>(clock_t::now() - start).count();
+  }
+  if (m_error)
+    std::rethrow_exception(m_error);
+  m_current = m_free.front();
+  m_free.pop_front();
+  m_fill = 0;
+}
+
+inline void
+FrameRecorder::submit()
+{
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_queue.push_back({ m_current, m_current_offset, m_fill, clock_t::now() });
+    ++m_in_flight;
+  }
+  m_cv.notify_all();
+  m_current_offset += m_fill;
+  m_current = s_no_buffer;
+  m_fill = 0;
+}
+
+inline bool
+FrameRecorder::record(const void* data, std::size_t size)
+{
+  if (m_fd < 0)
+    throw std::logic_error("FrameRecorder: record() after close()");
+  check_error();
+
+  if (!m_config.block_when_full) {
+    // Only the producer takes buffers, so space seen here can't shrink before the copy below
+    std::lock_guard<std::mutex> lk(m_mutex);
+    const std::size_t room =
+      (m_current == s_no_buffer ? 0 : m_config.buffer_bytes - m_fill) + m_free.size() * m_config.buffer_bytes;
+    if (room < size) {
+      ++m_stats.dropped_spans;
+      m_stats.dropped_bytes += size;
+      return false;
+    }
+  }
+
+  auto bytes = static_cast<const unsigned char*>(data);
+  for (std::size_t left = size; left > 0;) {
+    if (m_current == s_no_buffer)
+      acquire_buffer();
+    const std::size_t n = std::min(left, m_config.buffer_bytes - m_fill);
+    std::memcpy(m_buffers[m_current].get() + m_fill, bytes, n);
+    m_fill += n;
+    bytes += n;
+    left -= n;
+    if (m_fill == m_config.buffer_bytes)
+      submit();
+  }
+  m_size += size;
+
+  std::lock_guard<std::mutex> lk(m_mutex);
+  ++m_stats.spans;
+  return true;
+}
+
+inline void
+FrameRecorder::flush()
+{
+  if (m_fd < 0)
+    return;
+  check_error();
+
+  if (m_current != s_no_buffer && m_fill > 0) {
+    // The partial last block is written padded, then kept at the start of the next buffer so
+    // that it is rewritten, completed, at the same aligned offset
+    const std::size_t tail = m_fill % m_config.alignment;
+    const uint64_t next_offset = m_current_offset + (m_fill - tail); // NOLINT(build/unsigned)
+    std::vector<unsigned char> tail_bytes(m_buffers[m_current].get() + m_fill - tail,
+                                          m_buffers[m_current].get() + m_fill);
+    submit();
+    m_current_offset = next_offset;
+    if (tail > 0) {
+      acquire_buffer();
+      std::memcpy(m_buffers[m_current].get(), tail_bytes.data(), tail);
+      m_fill = tail;
+    }
+  }
+
+  std::unique_lock<std::mutex> lk(m_mutex);
+  m_cv.wait(lk, [this] { return (m_queue.empty() && m_in_flight == 0) || m_error; });
+  if (m_error)
+    std::rethrow_exception(m_error);
+}
+
+inline void
+FrameRecorder::close()
+{
+  if (m_fd < 0)
+    return;
+
+  std::exception_ptr error;
+  try {
+    flush();
+  } catch (...) {
+    error = std::current_exception();
+  }
+  {
+    std::lock_guard<std::mutex> lk(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  if (m_thread.joinable())
+    m_thread.join();
+
+  // Drop the zero padding of the last O_DIRECT block
+  if (!error && ::ftruncate(m_fd, m_size) != 0)
+    error = std::make_exception_ptr(std::runtime_error(std::string("FrameRecorder: ftruncate failed: ") +
+                                                       std::strerror(errno)));
+  if (::close(m_fd) != 0 && !error)
+    error = std::make_exception_ptr(std::runtime_error(std::string("FrameRecorder: close failed: ") +
+                                                       std::strerror(errno)));
+  m_fd = -1;
+  if (error)
+    std::rethrow_exception(error);
+}
+
+inline FrameRecorder::Stats
+FrameRecorder::stats() const
+{
+  std::lock_guard<std::mutex> lk(m_mutex);
+  return m_stats;
+}
+
+inline void
+FrameRecorder::write_loop()
+{
+  std::unique_lock<std::mutex> lk(m_mutex);
+  while (true) {
+    m_cv.wait(lk, [this] { return m_stop || !m_queue.empty(); });
+    if (m_queue.empty())
+      return;
+    const Batch batch = m_queue.front();
+    m_queue.pop_front();
+    const bool failed = static_cast<bool>(m_error);
+    lk.unlock();
+
+    std::size_t written = 0;
+    double write_seconds = 0;
+    std::exception_ptr error;
+    if (!failed) {
+      try {
+        unsigned char* data = m_buffers[batch.buffer].get();
+        std::size_t length = batch.size;
+        if (m_direct_io) {
+          length = (batch.size + m_config.alignment - 1) & ~(m_config.alignment - 1);
+          std::memset(data + batch.size, 0, length - batch.size);
+        }
+        const auto start = clock_t::now();
+        while (written < length) {
+          const ssize_t w = ::pwrite(m_fd, data + written, length - written, batch.file_offset + written);
+          if (w < 0 && errno == EINTR)
+            continue;
+#ifdef O_DIRECT
+          if (w < 0 && errno == EINVAL && m_direct_io) {
+            // Accepted at open but not supported for this write; carry on through the page cache
+            ::fcntl(m_fd, F_SETFL, ::fcntl(m_fd, F_GETFL) & ~O_DIRECT);
+            m_direct_io = false;
+            continue;
+          }
+#endif
+          if (w < 0)
+            throw std::runtime_error(std::string("FrameRecorder: write failed: ") + std::strerror(errno));
+          written += w;
+        }
+        write_seconds = std::chrono::duration<double>(clock_t::now() - start).count();
+      } catch (...) {
+        error = std::current_exception();
+      }
+    }
+
+    const double latency = std::chrono::duration<double>(clock_t::now() - batch.submitted).count();
+    lk.lock();
+    if (error && !m_error)
+      m_error = error;
+    if (!failed && !error) {
+      ++m_stats.batches;
+      m_stats.bytes_written += written;
+      m_stats.write_seconds += write_seconds;
+      m_stats.total_latency += latency;
+      m_stats.max_latency = std::max(m_stats.max_latency, latency);
+      const uint64_t us = static_cast<uint64_t>(latency * 1e6) | 1; // NOLINT(build/unsigned)
+      const std::size_t bin = std::min<std::size_t>(63 - __builtin_clzll(us), m_stats.latency_histogram.size() - 1);
+      ++m_stats.latency_histogram[bin];
+    }
+    m_free.push_back(batch.buffer);
+    --m_in_flight;
+    m_cv.notify_all();
+  }
+}
+
+} // namespace dunedaq::detdataformats
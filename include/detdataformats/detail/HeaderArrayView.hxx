@@ -0,0 +1,153 @@
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace dunedaq::detdataformats {
+
+namespace detail {
+
+inline uint32_t // NOLINT(build/unsigned)
+link_of(const DAQHeader& h) noexcept
+{
+  return h.link_id;
+}
+
+inline uint32_t // NOLINT(build/unsigned)
+link_of(const DAQEthHeader& h) noexcept
+{
+  return h.stream_id;
+}
+
+// Apply get(const Header&) to every header; the field is chosen outside the loop so that the
+// loop body is a load, a shift and a mask
+template<class Header, class T, class Get>
+inline void
+gather_column(const unsigned char* p, std::size_t n, std::size_t stride, T* out, Get get) noexcept
+{
+  for (std::size_t i = 0; i < n; ++i) {
+    Header h;
+    std::memcpy(&h, p + i * stride, sizeof(h));
+    out[i] = static_cast<T>(get(h));
+  }
+}
+
+} // namespace detail
+
+template<class Header>
+HeaderArrayView<Header>::HeaderArrayView(const void* data, std::size_t n, std::size_t stride)
+  : m_data(static_cast<const unsigned char*>(data))
+  , m_size(n)
+  , m_stride(stride == 0 ? sizeof(Header) : stride)
+{
+  if (m_stride < sizeof(Header))
+    throw std::invalid_argument("HeaderArrayView: stride " + std::to_string(m_stride) + " is smaller than a header");
+}
+
+template<class Header>
+Header
+HeaderArrayView<Header>::operator[](std::size_t i) const noexcept
+{
+  Header h;
+  std::memcpy(&h, m_data + i * m_stride, sizeof(h));
+  return h;
+}
+
+template<class Header>
+Header
+HeaderArrayView<Header>::at(std::size_t i) const
+{
+  if (i >= m_size)
+    throw std::out_of_range("HeaderArrayView: index " + std::to_string(i) + " out of range");
+  return (*this)[i];
+}
+
+template<class Header>
+bool
+HeaderArrayView<Header>::has_field(HeaderField field) noexcept
+{
+  if constexpr (std::is_same_v<Header, DAQEthHeader>)
+    return true;
+  return field != HeaderField::kSeqId && field != HeaderField::kBlockLength;
+}
+
+template<class Header>
+template<class T>
+void
+HeaderArrayView<Header>::column(HeaderField field, T* out) const
+{
+  const auto p = m_data;
+  const auto n = m_size;
+  const auto s = m_stride;
+  switch (field) {
+    case HeaderField::kVersion:
+      detail::gather_column<Header>(p, n, s, out, [](const Header& h) { return h.version; });
+      return;
+    case HeaderField::kDetId:
+      detail::gather_column<Header>(p, n, s, out, [](const Header& h) { return h.det_id; });
+      return;
+    case HeaderField::kCrateId:
+      detail::gather_column<Header>(p, n, s, out, [](const Header& h) { return h.crate_id; });
+      return;
+    case HeaderField::kSlotId:
+      detail::gather_column<Header>(p, n, s, out, [](const Header& h) { return h.slot_id; });
+      return;
+    case HeaderField::kLinkId:
+      detail::gather_column<Header>(p, n, s, out, [](const Header& h) { return detail::link_of(h); });
+      return;
+    case HeaderField::kTimestamp:
+      detail::gather_column<Header>(p, n, s, out, [](const Header& h) { return h.get_timestamp(); });
+      return;
+    case HeaderField::kSeqId:
+      if constexpr (std::is_same_v<Header, DAQEthHeader>) {
+        detail::gather_column<Header>(p, n, s, out, [](const Header& h) { return h.seq_id; });
+        return;
+      }
+      break;
+    case HeaderField::kBlockLength:
+      if constexpr (std::is_same_v<Header, DAQEthHeader>) {
+        detail::gather_column<Header>(p, n, s, out, [](const Header& h) { return h.block_length; });
+        return;
+      }
+      break;
+  }
+  throw std::invalid_argument("HeaderArrayView: the header has no field " + std::to_string(static_cast<int>(field)));
+}
+
+template<class Header>
+std::size_t
+HeaderArrayView<Header>::select(const HeaderSelection& selection, uint64_t* out) const noexcept // NOLINT
+{
+  // A field left at s_any gets a zero mask and compares equal whatever the header holds
+  auto mask = [](uint32_t want) -> uint32_t { return want == HeaderSelection::s_any ? 0 : ~uint32_t(0); }; // NOLINT
+  const uint32_t det_mask = mask(selection.det_id);     // NOLINT(build/unsigned)
+  const uint32_t crate_mask = mask(selection.crate_id); // NOLINT(build/unsigned)
+  const uint32_t slot_mask = mask(selection.slot_id);   // NOLINT(build/unsigned)
+  const uint32_t link_mask = mask(selection.link_id);   // NOLINT(build/unsigned)
+
+  std::size_t n_out = 0;
+  for (std::size_t i = 0; i < m_size; ++i) {
+    const Header h = (*this)[i];
+    const uint64_t ts = h.get_timestamp(); // NOLINT(build/unsigned)
+    const bool match = (((h.det_id ^ selection.det_id) & det_mask) | ((h.crate_id ^ selection.crate_id) & crate_mask) |
+                        ((h.slot_id ^ selection.slot_id) & slot_mask) |
+                        ((detail::link_of(h) ^ selection.link_id) & link_mask)) == 0 &&
+                       ts >= selection.t0 && ts < selection.t1;
+    // Written unconditionally and kept only on a match, so the loop has no data-dependent branch
+    out[n_out] = i;
+    n_out += match;
+  }
+  return n_out;
+}
+
+template<class Header>
+std::vector<uint64_t> // NOLINT(build/unsigned)
+HeaderArrayView<Header>::select(const HeaderSelection& selection) const
+{
+  std::vector<uint64_t> out(m_size); // NOLINT(build/unsigned)
+  out.resize(select(selection, out.data()));
+  return out;
+}
+
+} // namespace dunedaq::detdataformats
@@ -0,0 +1,157 @@
+
+namespace dunedaq::detdataformats {
+
+template<>
+struct HeaderVersions<DAQHeader>
+{
+  static constexpr unsigned s_current_version = 1;
+  using versions = std::integer_sequence<unsigned, 1>;
+};
+
+template<>
+struct HeaderVersions<DAQEthHeader>
+{
+  static constexpr unsigned s_current_version = 1;
+  using versions = std::integer_sequence<unsigned, 1>;
+};
+
+template<>
+struct HeaderVersions<HSIFrame>
+{
+  static constexpr unsigned s_current_version = 1;
+  using versions = std::integer_sequence<unsigned, 1>;
+};
+
+static_assert(HeaderVersions<DAQHeader>::s_current_version == 1 &&
+                HeaderVersions<DAQEthHeader>::s_current_version == 1 &&
+                HeaderVersions<HSIFrame>::s_current_version == 1,
+              "This is intentionally designed to tell the developer to add a HeaderDecoder specialisation and update "
+              "the static_assert checks (including this one) when a version is bumped");
+
+static_assert(sizeof(DAQHeader) == 12, "DAQHeader struct size different than expected!");
+static_assert(sizeof(DAQEthHeader) == 16, "DAQEthHeader struct size different than expected!");
+static_assert(sizeof(HSIFrame) == 28, "HSIFrame struct size different than expected!");
+static_assert(sizeof(DecodedHeader) == 24, "DecodedHeader struct size different than expected!");
+
+namespace detail {
+
+template<class Word>
+inline Word
+load_word(const unsigned char* p, std::size_t index) noexcept
+{
+  Word w;
+  std::memcpy(&w, p + index * sizeof(Word), sizeof(Word));
+  return w;
+}
+
+} // namespace detail
+
+/**
+ * @brief DAQHeader v1: version:6 det_id:6 crate_id:10 slot_id:4 link_id:6 | timestamp_1:32 | timestamp_2:32
+ */
+template<>
+struct HeaderDecoder<DAQHeader, 1>
+{
+  static constexpr std::size_t s_size = 12;
+  static_assert(s_size == sizeof(DAQHeader), "DAQHeader v1 size mismatch");
+
+  static void decode(const unsigned char* p, DecodedHeader& out) noexcept
+  {
+    const uint32_t w0 = detail::load_word<uint32_t>(p, 0); // NOLINT(build/unsigned)
+    out.version = w0 & 0x3F;
+    out.det_id = (w0 >> 6) & 0x3F;
+    out.crate_id = (w0 >> 12) & 0x3FF;
+    out.slot_id = (w0 >> 22) & 0xF;
+    out.link_id = (w0 >> 26) & 0x3F;
+    out.block_length = 0;
+    out.seq_id = 0;
+    out.timestamp = uint64_t(detail::load_word<uint32_t>(p, 1)) |           // NOLINT(build/unsigned)
+                    (uint64_t(detail::load_word<uint32_t>(p, 2)) << 32); // NOLINT(build/unsigned)
+  }
+};
+
+/**
+ * @brief DAQEthHeader v1: version:6 det_id:6 crate_id:10 slot_id:4 stream_id:8 reserved:6 seq_id:12
+ * block_length:12 | timestamp:64
+ */
+template<>
+struct HeaderDecoder<DAQEthHeader, 1>
+{
+  static constexpr std::size_t s_size = 16;
+  static_assert(s_size == sizeof(DAQEthHeader), "DAQEthHeader v1 size mismatch");
+
+  static void decode(const unsigned char* p, DecodedHeader& out) noexcept
+  {
+    const uint64_t w0 = detail::load_word<uint64_t>(p, 0); // NOLINT(build/unsigned)
+    out.version = w0 & 0x3F;
+    out.det_id = (w0 >> 6) & 0x3F;
+    out.crate_id = (w0 >> 12) & 0x3FF;
+    out.slot_id = (w0 >> 22) & 0xF;
+    out.link_id = (w0 >> 26) & 0xFF;
+    out.seq_id = (w0 >> 40) & 0xFFF;
+    out.block_length = (w0 >> 52) & 0xFFF;
+    out.timestamp = detail::load_word<uint64_t>(p, 1); // NOLINT(build/unsigned)
+  }
+};
+
+/**
+ * @brief HSIFrame v1: version:6 detector_id:6 crate:10 slot:4 link:6 | timestamp_low | timestamp_high |
+ * input_low | input_high | trigger | sequence
+ */
+template<>
+struct HeaderDecoder<HSIFrame, 1>
+{
+  static constexpr std::size_t s_size = 28;
+  static_assert(s_size == sizeof(HSIFrame), "HSIFrame v1 size mismatch");
+
+  static void decode(const unsigned char* p, DecodedHeader& out) noexcept
+  {
+    HeaderDecoder<DAQHeader, 1>::decode(p, out);
+    out.seq_id = detail::load_word<uint32_t>(p, 6); // NOLINT(build/unsigned)
+  }
+};
+
+namespace detail {
+
+template<class Header, unsigned Version>
+DecodeResult
+decode_loop(const unsigned char* p, std::size_t n, DecodedHeader* out, std::size_t stride) noexcept
+{
+  // Version mismatches are accumulated rather than branched on, so the loop body stays straight-line
+  unsigned mismatch = 0;
+  for (std::size_t i = 0; i < n; ++i, p += stride) {
+    HeaderDecoder<Header, Version>::decode(p, out[i]);
+    mismatch |= out[i].version ^ Version;
+  }
+  return { mismatch ? DecodeStatus::kMixedVersions : DecodeStatus::kOk, Version, n };
+}
+
+template<class Header, unsigned... Versions>
+DecodeResult
+dispatch_version(unsigned version,
+                 const unsigned char* p,
+                 std::size_t n,
+                 DecodedHeader* out,
+                 std::size_t stride,
+                 std::integer_sequence<unsigned, Versions...>) noexcept
+{
+  DecodeResult result{ DecodeStatus::kUnsupportedVersion, version, 0 };
+  (void)((version == Versions ? (result = decode_loop<Header, Versions>(p, n, out, stride), true) : false) || ...);
+  return result;
+}
+
+} // namespace detail
+
+template<class Header>
+DecodeResult
+decode_headers(const void* buffer, std::size_t n, DecodedHeader* out, std::size_t stride) noexcept
+{
+  if (n == 0)
+    return { DecodeStatus::kEmpty, 0, 0 };
+
+  auto p = static_cast<const unsigned char*>(buffer);
+  return detail::dispatch_version<Header>(
+    header_version(p), p, n, out, stride, typename HeaderVersions<Header>::versions{});
+}
+
+} // namespace dunedaq::detdataformats
@@ -0,0 +1,479 @@
+
+#include "detdataformats/EthReorderBuffer.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dunedaq::detdataformats {
+
+namespace pcap::detail {
+
+inline uint16_t // NOLINT(build/unsigned)
+load_be16(const unsigned char* p) noexcept
+{
+  return static_cast<uint16_t>(p[0] << 8 | p[1]); // NOLINT(build/unsigned)
+}
+
+// Capture file fields, in the byte order of the file (@p swap: opposite to ours)
+inline uint16_t // NOLINT(build/unsigned)
+load16(const unsigned char* p, bool swap) noexcept
+{
+  uint16_t v; // NOLINT(build/unsigned)
+  std::memcpy(&v, p, sizeof(v));
+  return swap ? __builtin_bswap16(v) : v;
+}
+
+inline uint32_t // NOLINT(build/unsigned)
+load32(const unsigned char* p, bool swap) noexcept
+{
+  uint32_t v; // NOLINT(build/unsigned)
+  std::memcpy(&v, p, sizeof(v));
+  return swap ? __builtin_bswap32(v) : v;
+}
+
+inline uint64_t // NOLINT(build/unsigned)
+ticks_to_ns(uint64_t ticks, uint64_t ticks_per_second) noexcept // NOLINT(build/unsigned)
+{
+  if (ticks_per_second == 1000000000u)
+    return ticks;
+  // Whole seconds, then the remainder: below 1 GHz the remainder times 10^9 fits in 64 bits, and
+  // for finer clocks a double is precise to far less than a nanosecond
+  const uint64_t whole = ticks / ticks_per_second * 1000000000u; // NOLINT(build/unsigned)
+  const uint64_t rest = ticks % ticks_per_second;                // NOLINT(build/unsigned)
+  if (ticks_per_second < 1000000000u)
+    return whole + rest * 1000000000u / ticks_per_second;
+  return whole + static_cast<uint64_t>(static_cast<double>(rest) * 1e9 / static_cast<double>(ticks_per_second)); // NOLINT
+}
+
+// Link types, see https://www.tcpdump.org/linktypes.html
+constexpr unsigned s_linktype_ethernet = 1;
+constexpr unsigned s_linktype_raw = 101;
+constexpr unsigned s_linktype_linux_sll = 113;
+constexpr unsigned s_linktype_ipv4 = 228;
+constexpr unsigned s_linktype_ipv6 = 229;
+constexpr unsigned s_linktype_linux_sll2 = 276;
+
+constexpr unsigned s_ethertype_ipv4 = 0x0800;
+constexpr unsigned s_ethertype_ipv6 = 0x86DD;
+constexpr unsigned s_ethertype_vlan = 0x8100;
+constexpr unsigned s_ethertype_qinq = 0x88A8;
+constexpr unsigned s_ip_proto_udp = 17;
+constexpr unsigned s_ipv6_fragment = 44;
+
+inline PacketStatus
+udp_payload(unsigned link_type,
+            const unsigned char* frame,
+            std::size_t captured,
+            uint16_t& dst_port, // NOLINT(build/unsigned)
+            const unsigned char*& payload,
+            std::size_t& size) noexcept
+{
+  const unsigned char* p = frame;
+  std::size_t n = captured;
+  unsigned ethertype = 0;
+  switch (link_type) {
+    case s_linktype_ethernet:
+      if (n < 14)
+        return PacketStatus::kTruncated;
+      ethertype = load_be16(p + 12);
+      p += 14;
+      n -= 14;
+      while (ethertype == s_ethertype_vlan || ethertype == s_ethertype_qinq) {
+        if (n < 4)
+          return PacketStatus::kTruncated;
+        ethertype = load_be16(p + 2);
+        p += 4;
+        n -= 4;
+      }
+      break;
+    case s_linktype_linux_sll:
+      if (n < 16)
+        return PacketStatus::kTruncated;
+      ethertype = load_be16(p + 14);
+      p += 16;
+      n -= 16;
+      break;
+    case s_linktype_linux_sll2:
+      if (n < 20)
+        return PacketStatus::kTruncated;
+      ethertype = load_be16(p);
+      p += 20;
+      n -= 20;
+      break;
+    case s_linktype_raw:
+    case s_linktype_ipv4:
+    case s_linktype_ipv6:
+      if (n < 1)
+        return PacketStatus::kTruncated;
+      ethertype = (p[0] >> 4) == 4 ? s_ethertype_ipv4 : (p[0] >> 4) == 6 ? s_ethertype_ipv6 : 0;
+      break;
+    default:
+      return PacketStatus::kNotUdp;
+  }
+
+  if (ethertype == s_ethertype_ipv4) {
+    if (n < 20)
+      return PacketStatus::kTruncated;
+    const std::size_t header_length = (p[0] & 0xF) * 4;
+    if ((p[0] >> 4) != 4 || header_length < 20)
+      return PacketStatus::kNotUdp;
+    if (n < header_length)
+      return PacketStatus::kTruncated;
+    // More-fragments flag or a non-zero fragment offset
+    if (load_be16(p + 6) & 0x3FFF)
+      return PacketStatus::kFragment;
+    if (p[9] != s_ip_proto_udp)
+      return PacketStatus::kNotUdp;
+    const std::size_t total_length = load_be16(p + 2);
+    p += header_length;
+    // Ethernet pads short frames; the IP length tells where the datagram really ends
+    n = std::min(n - header_length, total_length > header_length ? total_length - header_length : 0);
+  } else if (ethertype == s_ethertype_ipv6) {
+    if (n < 40)
+      return PacketStatus::kTruncated;
+    const unsigned next_header = p[6];
+    const std::size_t payload_length = load_be16(p + 4);
+    if (next_header == s_ipv6_fragment)
+      return PacketStatus::kFragment;
+    if (next_header != s_ip_proto_udp)
+      return PacketStatus::kNotUdp;
+    p += 40;
+    n = std::min(n - 40, payload_length);
+  } else {
+    return PacketStatus::kNotUdp;
+  }
+
+  if (n < 8)
+    return PacketStatus::kTruncated;
+  dst_port = load_be16(p + 2);
+  const std::size_t udp_length = load_be16(p + 4);
+  if (udp_length < 8)
+    return PacketStatus::kNotUdp;
+  if (udp_length > n)
+    return PacketStatus::kTruncated;
+  payload = p + 8;
+  size = udp_length - 8;
+  return PacketStatus::kOk;
+}
+
+} // namespace pcap::detail
+
+inline PcapReader::PcapReader(const std::string& path, const Config& config)
+  : m_config(config)
+  , m_path(path)
+{
+  if (m_config.batch_packets == 0)
+    throw std::invalid_argument("PcapReader: batch size must be non-zero");
+
+  m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT
+  if (m_fd < 0)
+    throw std::runtime_error("PcapReader: cannot open " + path + ": " + std::strerror(errno));
+
+  struct stat st;
+  if (::fstat(m_fd, &st) != 0 || st.st_size < 24) {
+    ::close(m_fd);
+    throw std::runtime_error("PcapReader: " + path + " is too small to be a capture file");
+  }
+  m_size = st.st_size;
+  void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (p == MAP_FAILED) {
+    ::close(m_fd);
+    throw std::runtime_error("PcapReader: cannot map " + path + ": " + std::strerror(errno));
+  }
+  m_data = static_cast<const unsigned char*>(p);
+
+  const uint32_t magic = pcap::detail::load32(m_data, false); // NOLINT(build/unsigned)
+  if (magic == 0x0A0D0D0A) {
+    m_format = Format::kPcapNg;
+  } else if (magic == 0xA1B2C3D4 || magic == 0xD4C3B2A1 || magic == 0xA1B23C4D || magic == 0x4D3CB2A1) {
+    m_format = Format::kPcap;
+  } else {
+    ::munmap(const_cast<unsigned char*>(m_data), m_size);
+    ::close(m_fd);
+    throw std::runtime_error("PcapReader: " + path + " is not a pcap or pcapng file");
+  }
+
+  ::madvise(p, m_size, MADV_SEQUENTIAL);
+}
+
+inline PcapReader::~PcapReader()
+{
+  ::munmap(const_cast<unsigned char*>(m_data), m_size);
+  ::close(m_fd);
+}
+
+inline bool
+PcapReader::extract(unsigned link_type,
+                    const unsigned char* frame,
+                    std::size_t captured,
+                    uint64_t capture_time, // NOLINT(build/unsigned)
+                    PcapPacket& packet) noexcept
+{
+  ++m_counters.n_records;
+  uint16_t port = 0; // NOLINT(build/unsigned)
+  const unsigned char* payload = nullptr;
+  std::size_t size = 0;
+  switch (pcap::detail::udp_payload(link_type, frame, captured, port, payload, size)) {
+    case pcap::detail::PacketStatus::kOk:
+      break;
+    case pcap::detail::PacketStatus::kNotUdp:
+      ++m_counters.n_not_udp;
+      return false;
+    case pcap::detail::PacketStatus::kFragment:
+      ++m_counters.n_fragments;
+      return false;
+    case pcap::detail::PacketStatus::kTruncated:
+      ++m_counters.n_truncated;
+      return false;
+  }
+  if (m_config.udp_port != 0 && port != m_config.udp_port) {
+    ++m_counters.n_other_port;
+    return false;
+  }
+  if (size < sizeof(DAQEthHeader)) {
+    ++m_counters.n_too_short;
+    return false;
+  }
+
+  packet.data = payload;
+  packet.size = static_cast<uint32_t>(size); // NOLINT(build/unsigned)
+  packet.stream_key = EthReorderBuffer::stream_key(packet.header());
+  packet.capture_time = capture_time;
+  ++m_counters.n_packets;
+  return true;
+}
+
+template<class Record>
+void
+PcapReader::walk(Record&& record)
+{
+  m_counters = Counters();
+  if (m_format == Format::kPcap)
+    walk_pcap(record);
+  else
+    walk_pcapng(record);
+}
+
+template<class Record>
+void
+PcapReader::walk_pcap(Record& record)
+{
+  using pcap::detail::load32;
+  const uint32_t magic = load32(m_data, false); // NOLINT(build/unsigned)
+  const bool swap = magic == 0xD4C3B2A1 || magic == 0x4D3CB2A1;
+  const bool nanoseconds = magic == 0xA1B23C4D || magic == 0x4D3CB2A1;
+  // The upper bits of the link type field carry the FCS length
+  const unsigned link_type = load32(m_data + 20, swap) & 0xFFFF;
+
+  std::size_t offset = 24;
+  while (offset + 16 <= m_size) {
+    const unsigned char* r = m_data + offset;
+    const uint64_t seconds = load32(r, swap);   // NOLINT(build/unsigned)
+    const uint64_t fraction = load32(r + 4, swap); // NOLINT(build/unsigned)
+    const std::size_t captured = load32(r + 8, swap);
+    if (captured > m_size - offset - 16)
+      break;
+    record(link_type, r + 16, captured, seconds * 1000000000u + fraction * (nanoseconds ? 1 : 1000));
+    offset += 16 + captured;
+  }
+  if (offset != m_size)
+    ++m_counters.n_truncated;
+}
+
+template<class Record>
+void
+PcapReader::walk_pcapng(Record& record)
+{
+  using pcap::detail::load16;
+  using pcap::detail::load32;
+  auto corrupt = [this](std::size_t offset) {
+    return std::runtime_error("PcapReader: " + m_path + ": corrupt block at offset " + std::to_string(offset));
+  };
+
+  bool swap = false;
+  std::vector<Interface> interfaces;
+  std::size_t offset = 0;
+  while (offset + 12 <= m_size) {
+    const unsigned char* b = m_data + offset;
+    if (load32(b, false) == 0x0A0D0D0A) {
+      // Section header: the byte-order magic sets the byte order of the whole section
+      if (offset + 16 > m_size)
+        break;
+      const uint32_t byte_order = load32(b + 8, false); // NOLINT(build/unsigned)
+      if (byte_order != 0x1A2B3C4D && byte_order != 0x4D3C2B1A)
+        throw corrupt(offset);
+      swap = byte_order == 0x4D3C2B1A;
+      interfaces.clear();
+    }
+    const uint32_t type = load32(b, swap);        // NOLINT(build/unsigned)
+    const std::size_t length = load32(b + 4, swap);
+    if (length < 12 || length % 4 != 0)
+      throw corrupt(offset);
+    if (length > m_size - offset)
+      break;
+    const unsigned char* body = b + 8;
+    const std::size_t body_length = length - 12;
+
+    if (type == 1) {
+      // Interface description: link type, then options; only if_tsresol matters here
+      if (body_length < 8)
+        throw corrupt(offset);
+      Interface interface{ load16(body, swap), 1000000 };
+      for (std::size_t o = 8; o + 4 <= body_length;) {
+        const unsigned code = load16(body + o, swap);
+        const std::size_t option_length = load16(body + o + 2, swap);
+        if (code == 0)
+          break;
+        if (code == 9 && option_length >= 1 && o + 4 < body_length) {
+          const unsigned resolution = body[o + 4];
+          if (resolution & 0x80) {
+            interface.ticks_per_second = uint64_t(1) << std::min(resolution & 0x7F, 63u); // NOLINT
+          } else {
+            interface.ticks_per_second = 1;
+            for (unsigned i = 0; i < std::min(resolution, 19u); ++i)
+              interface.ticks_per_second *= 10;
+          }
+        }
+        o += 4 + ((option_length + 3) & ~std::size_t(3));
+      }
+      interfaces.push_back(interface);
+    } else if (type == 6) {
+      // Enhanced packet
+      if (body_length < 20)
+        throw corrupt(offset);
+      const uint32_t id = load32(body, swap); // NOLINT(build/unsigned)
+      const uint64_t ticks = uint64_t(load32(body + 4, swap)) << 32 | load32(body + 8, swap); // NOLINT
+      const std::size_t captured = load32(body + 12, swap);
+      if (id >= interfaces.size() || captured > body_length - 20)
+        throw corrupt(offset);
+      record(interfaces[id].link_type,
+             body + 20,
+             captured,
+             pcap::detail::ticks_to_ns(ticks, interfaces[id].ticks_per_second));
+    } else if (type == 3) {
+      // Simple packet: always interface 0, no timestamp
+      if (body_length < 4 || interfaces.empty())
+        throw corrupt(offset);
+      const std::size_t captured = std::min<std::size_t>(load32(body, swap), body_length - 4);
+      record(interfaces[0].link_type, body + 4, captured, 0);
+    }
+    offset += length;
+  }
+  if (offset != m_size)
+    ++m_counters.n_truncated;
+}
+
+template<class Callback>
+void
+PcapReader::for_each(Callback&& callback)
+{
+  walk([&](unsigned link_type, const unsigned char* frame, std::size_t captured, uint64_t time) { // NOLINT
+    PcapPacket packet;
+    if (extract(link_type, frame, captured, time, packet))
+      callback(static_cast<const PcapPacket&>(packet));
+  });
+}
+
+template<class Callback>
+void
+PcapReader::for_each_parallel(Callback&& callback, unsigned n_threads)
+{
+  n_threads = std::max(1u, n_threads);
+
+  // The calling thread walks the file and sorts packets into one bucket per worker. A full batch
+  // of buckets is handed over to the workers, which stay up for the whole pass, and the next
+  // batch is filled while they go through it; every packet is touched by one worker only
+  std::vector<std::vector<PcapPacket>> current(n_threads);
+  std::vector<std::vector<PcapPacket>> next(n_threads);
+  std::vector<std::exception_ptr> errors(n_threads);
+  std::mutex mutex;
+  std::condition_variable cv;
+  uint64_t generation = 0; // NOLINT(build/unsigned)
+  unsigned n_busy = 0;
+  bool stop = false;
+
+  auto work = [&](unsigned t) {
+    uint64_t seen = 0; // NOLINT(build/unsigned)
+    std::unique_lock<std::mutex> lk(mutex);
+    while (true) {
+      cv.wait(lk, [&] { return stop || generation != seen; });
+      if (generation == seen)
+        return;
+      seen = generation;
+      lk.unlock();
+      try {
+        if (!errors[t])
+          for (auto const& packet : current[t])
+            callback(t, packet);
+      } catch (...) {
+        errors[t] = std::current_exception();
+      }
+      lk.lock();
+      if (--n_busy == 0)
+        cv.notify_all();
+    }
+  };
+  auto wait_idle = [&]() {
+    std::unique_lock<std::mutex> lk(mutex);
+    cv.wait(lk, [&] { return n_busy == 0; });
+    for (auto& e : errors)
+      if (e)
+        std::rethrow_exception(e);
+  };
+  std::size_t n_pending = 0;
+  auto hand_off = [&]() {
+    wait_idle();
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      current.swap(next);
+      n_busy = n_threads;
+      ++generation;
+    }
+    cv.notify_all();
+    for (auto& bucket : next)
+      bucket.clear();
+    n_pending = 0;
+  };
+
+  std::vector<std::thread> workers;
+  auto finish = [&]() {
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+      stop = true;
+    }
+    cv.notify_all();
+    for (auto& w : workers)
+      w.join();
+  };
+
+  try {
+    for (unsigned t = 0; t < n_threads; ++t)
+      workers.emplace_back(work, t);
+    walk([&](unsigned link_type, const unsigned char* frame, std::size_t captured, uint64_t time) { // NOLINT
+      PcapPacket packet;
+      if (!extract(link_type, frame, captured, time, packet))
+        return;
+      next[thread_of(packet.stream_key, n_threads)].push_back(packet);
+      if (++n_pending == m_config.batch_packets)
+        hand_off();
+    });
+    if (n_pending > 0)
+      hand_off();
+    wait_idle();
+  } catch (...) {
+    finish();
+    throw;
+  }
+  finish();
+}
+
+} // namespace dunedaq::detdataformats
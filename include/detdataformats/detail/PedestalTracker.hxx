@@ -0,0 +1,279 @@
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace dunedaq::detdataformats {
+
+static_assert(sizeof(ChannelPedestal) == 32, "ChannelPedestal struct size different than expected!");
+static_assert(sizeof(ChannelPedestal) % sizeof(uint64_t) == 0, // NOLINT(build/unsigned)
+              "ChannelPedestal must be published as whole 64-bit words");
+
+namespace detail {
+
+/**
+ * @brief Merge the batch moments of channels [begin, end) into the running statistics.
+ *
+ * Chan et al. pairwise combination of (count, mean, m2) with the batch. A channel without samples
+ * in the batch comes out unchanged, so the body is branch-free. It is a free function over
+ * restrict-qualified arrays, and the selects are written as plain comparisons of doubles, because
+ * that is the form GCC vectorises.
+ */
+inline void
+merge_pedestals(std::size_t begin,
+                std::size_t end,
+                double weight,
+                double warmup,
+                double* __restrict count,
+                double* __restrict mean,
+                double* __restrict m2,
+                double* __restrict recent,
+                double* __restrict reference,
+                double* __restrict drift,
+                double* __restrict batch_count,
+                double* __restrict batch_sum,
+                double* __restrict batch_sum2,
+                const double* __restrict shift) noexcept
+{
+  for (std::size_t c = begin; c < end; ++c) {
+    const double na = count[c];
+    const double nb = batch_count[c];
+    const double nn = na + nb;
+    const double nb_div = nb < 1.0 ? 1.0 : nb;
+    const double nn_div = nn < 1.0 ? 1.0 : nn;
+    const double mean_b = shift[c] + batch_sum[c] / nb_div;
+    const double m2_b = batch_sum2[c] - batch_sum[c] * batch_sum[c] / nb_div;
+    const double delta = mean_b - mean[c];
+
+    const double new_mean = mean[c] + delta * nb / nn_div;
+    m2[c] += m2_b + delta * delta * na * nb / nn_div;
+    mean[c] = new_mean;
+    count[c] = nn;
+
+    // The first batch seeds recent; later ones move it by weight
+    const double w = na < 1.0 ? 1.0 : (nb < 1.0 ? 0.0 : weight);
+    const double new_recent = recent[c] + w * (mean_b - recent[c]);
+    const double new_reference = (na < warmup && nn >= warmup) ? new_mean : reference[c];
+    recent[c] = new_recent;
+    reference[c] = new_reference;
+    drift[c] = std::fabs(new_recent - new_reference);
+
+    batch_count[c] = 0;
+    batch_sum[c] = 0;
+    batch_sum2[c] = 0;
+  }
+}
+
+} // namespace detail
+
+template<class Layout>
+PedestalTracker<Layout>::PedestalTracker(const channel_map_t& channel_map)
+  : PedestalTracker(channel_map, Config())
+{}
+
+template<class Layout>
+PedestalTracker<Layout>::PedestalTracker(const channel_map_t& channel_map, const Config& config)
+  : m_channel_map(channel_map)
+  , m_config(config)
+{
+  if (!channel_map.is_compiled())
+    throw std::invalid_argument("PedestalTracker: the channel map must be compiled");
+  if (!(config.recent_weight > 0 && config.recent_weight <= 1))
+    throw std::invalid_argument("PedestalTracker: recent_weight must be in (0, 1]");
+  m_config.warmup_samples = std::max<uint64_t>(config.warmup_samples, 1); // NOLINT(build/unsigned)
+
+  const std::size_t n_channels =
+    channel_map.max_channel() == channel_map_t::s_invalid_channel ? 0 : std::size_t(channel_map.max_channel()) + 1;
+  m_count.assign(n_channels, 0);
+  m_mean.assign(n_channels, 0);
+  m_m2.assign(n_channels, 0);
+  m_recent.assign(n_channels, 0);
+  m_reference.assign(n_channels, std::numeric_limits<double>::quiet_NaN());
+  m_last_median.assign(n_channels, 0);
+  m_last_accumulator.assign(n_channels, 0);
+  m_drift.assign(n_channels, std::numeric_limits<double>::quiet_NaN());
+  m_batch_count.assign(n_channels, 0);
+  m_batch_sum.assign(n_channels, 0);
+  m_batch_sum2.assign(n_channels, 0);
+  m_shift.assign(n_channels, 0);
+  m_touched.reserve(n_channels);
+
+  m_published.reset(new std::atomic<uint64_t>[n_channels * s_words_per_channel]()); // NOLINT(build/unsigned)
+  publish();
+}
+
+template<class Layout>
+inline void
+PedestalTracker<Layout>::accumulate(uint32_t channel, const header_t& header) noexcept // NOLINT(build/unsigned)
+{
+  const double x = header.m_median;
+  if (m_batch_count[channel] == 0) {
+    m_touched.push_back(channel);
+    // Summing offsets from a value close to the mean keeps the batch variance exact in doubles
+    m_shift[channel] = m_count[channel] > 0 ? std::round(m_mean[channel]) : x;
+  }
+  const double d = x - m_shift[channel];
+  m_batch_count[channel] += 1;
+  m_batch_sum[channel] += d;
+  m_batch_sum2[channel] += d * d;
+  m_last_median[channel] = header.m_median;
+  m_last_accumulator[channel] = header.m_accumulator;
+}
+
+template<class Layout>
+void
+PedestalTracker<Layout>::merge_batch() noexcept
+{
+  if (m_touched.empty())
+    return;
+
+  // Batches covering a good part of the detector are merged densely, small ones channel by channel
+  const std::size_t n = n_channels();
+  const double weight = m_config.recent_weight;
+  const double warmup = static_cast<double>(m_config.warmup_samples);
+  const double threshold = m_config.drift_threshold;
+  auto merge = [&](std::size_t begin, std::size_t end) {
+    detail::merge_pedestals(begin, end, weight, warmup, m_count.data(), m_mean.data(), m_m2.data(), m_recent.data(),
+                            m_reference.data(), m_drift.data(), m_batch_count.data(), m_batch_sum.data(),
+                            m_batch_sum2.data(), m_shift.data());
+  };
+  if (m_touched.size() * 4 >= n) {
+    merge(0, n);
+    m_n_alarms = 0;
+    for (std::size_t c = 0; c < n; ++c)
+      m_n_alarms += m_drift[c] > threshold;
+  } else {
+    for (auto c : m_touched) {
+      m_n_alarms -= m_drift[c] > threshold;
+      merge(c, c + 1);
+      m_n_alarms += m_drift[c] > threshold;
+    }
+  }
+  m_touched.clear();
+  ++m_n_batches;
+}
+
+template<class Layout>
+void
+PedestalTracker<Layout>::process_headers(const void* first, std::size_t n, std::size_t stride)
+{
+  m_channel_scratch.resize(n);
+  m_channel_map.lookup(first, n, stride, m_channel_scratch.data());
+
+  auto bytes = static_cast<const unsigned char*>(first);
+  for (std::size_t i = 0; i < n; ++i, bytes += stride) {
+    const uint32_t channel = m_channel_scratch[i]; // NOLINT(build/unsigned)
+    if (channel == channel_map_t::s_invalid_channel) {
+      ++m_n_unmapped;
+      continue;
+    }
+    accumulate(channel, *reinterpret_cast<const header_t*>(bytes));
+    ++m_n_samples;
+  }
+  merge_batch();
+}
+
+template<class Layout>
+std::size_t
+PedestalTracker<Layout>::process(const void* buffer, std::size_t size)
+{
+  TpFrameRange<header_t, data_t> frames(buffer, size);
+  const unsigned char* last_end = static_cast<const unsigned char*>(buffer);
+  m_header_scratch.clear();
+  for (auto it = frames.begin(); it != frames.end(); ++it) {
+    m_header_scratch.push_back(it->header);
+    last_end = it.position() + it->size();
+  }
+
+  const std::size_t n = m_header_scratch.size();
+  m_channel_scratch.resize(n);
+  m_channel_map.lookup(m_header_scratch.data(), n, m_channel_scratch.data());
+  for (std::size_t i = 0; i < n; ++i) {
+    const uint32_t channel = m_channel_scratch[i]; // NOLINT(build/unsigned)
+    if (channel == channel_map_t::s_invalid_channel) {
+      ++m_n_unmapped;
+      continue;
+    }
+    accumulate(channel, *m_header_scratch[i]);
+    ++m_n_samples;
+  }
+  merge_batch();
+  return last_end - static_cast<const unsigned char*>(buffer);
+}
+
+template<class Layout>
+ChannelPedestal
+PedestalTracker<Layout>::stats(uint32_t channel) const // NOLINT(build/unsigned)
+{
+  if (channel >= n_channels())
+    throw std::out_of_range("PedestalTracker: channel " + std::to_string(channel) + " out of range");
+
+  ChannelPedestal p{};
+  const double n = m_count[channel];
+  p.n_samples = static_cast<uint64_t>(n); // NOLINT(build/unsigned)
+  if (n > 0) {
+    p.mean = m_mean[channel];
+    p.rms = std::sqrt(m_m2[channel] / n);
+    p.recent_mean = m_recent[channel];
+  } else {
+    p.mean = p.rms = p.recent_mean = std::numeric_limits<float>::quiet_NaN();
+  }
+  p.reference = m_reference[channel];
+  p.last_median = m_last_median[channel];
+  p.last_accumulator = m_last_accumulator[channel];
+  p.alarm = m_drift[channel] > m_config.drift_threshold;
+  return p;
+}
+
+template<class Layout>
+void
+PedestalTracker<Layout>::publish()
+{
+  // Seqlock writer: readers that saw an odd sequence, or a different one after copying, retry
+  const uint64_t seq = m_sequence.load(std::memory_order_relaxed); // NOLINT(build/unsigned)
+  m_sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (std::size_t c = 0; c < n_channels(); ++c) {
+    const ChannelPedestal p = stats(c);
+    uint64_t words[s_words_per_channel]; // NOLINT(build/unsigned)
+    std::memcpy(words, &p, sizeof(p));
+    for (std::size_t w = 0; w < s_words_per_channel; ++w)
+      m_published[c * s_words_per_channel + w].store(words[w], std::memory_order_relaxed);
+  }
+
+  m_sequence.store(seq + 2, std::memory_order_release);
+}
+
+template<class Layout>
+void
+PedestalTracker<Layout>::snapshot(PedestalSnapshot& out) const
+{
+  const std::size_t n = n_channels();
+  out.channels.resize(n);
+  while (true) {
+    const uint64_t before = m_sequence.load(std::memory_order_acquire); // NOLINT(build/unsigned)
+    if (before & 1) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (std::size_t c = 0; c < n; ++c) {
+      uint64_t words[s_words_per_channel]; // NOLINT(build/unsigned)
+      for (std::size_t w = 0; w < s_words_per_channel; ++w)
+        words[w] = m_published[c * s_words_per_channel + w].load(std::memory_order_relaxed);
+      std::memcpy(&out.channels[c], words, sizeof(words));
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_sequence.load(std::memory_order_relaxed) == before) {
+      // The constructor's initial publish() is generation 0
+      out.generation = before / 2 - 1;
+      return;
+    }
+  }
+}
+
+} // namespace dunedaq::detdataformats
@@ -0,0 +1,150 @@
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace dunedaq::detdataformats {
+
+inline TimestampSkewMonitor::TimestampSkewMonitor(const Config& config)
+  : m_config(config)
+{
+  if (!(m_config.memory_samples >= 2))
+    throw std::invalid_argument("TimestampSkewMonitor: the fit memory must be at least 2 samples");
+  if (m_config.max_links == 0)
+    throw std::invalid_argument("TimestampSkewMonitor: at least one link is needed");
+  m_decay = 1 - 1 / m_config.memory_samples;
+  m_link_index.reserve(std::min<std::size_t>(m_config.max_links, 1024));
+}
+
+inline void
+TimestampSkewMonitor::sample(link_t link, uint64_t timestamp, uint64_t reference) // NOLINT(build/unsigned)
+{
+  ++m_counters.n_samples;
+
+  if (!m_has_last || link != m_last_link) {
+    auto it = m_link_index.find(link);
+    if (it == m_link_index.end()) {
+      if (m_links.size() >= m_config.max_links) {
+        ++m_counters.n_dropped;
+        return;
+      }
+      it = m_link_index.emplace(link, static_cast<uint32_t>(m_links.size())).first; // NOLINT(build/unsigned)
+      m_links.push_back(LinkState{ link, 0, reference, 0, 0, 0, 0, 0, 0, 0, 0 });
+    }
+    m_last_link = link;
+    m_last_index = it->second;
+    m_has_last = true;
+  }
+  LinkState& s = m_links[m_last_index];
+
+  // Differences are taken in integers first, so that 57-bit timestamps lose no precision
+  const double x = static_cast<double>(static_cast<int64_t>(reference - s.first_reference));
+  const double y = static_cast<double>(static_cast<int64_t>(timestamp - reference));
+
+  // Exponentially weighted Welford update: old weights shrink by m_decay, the new sample has
+  // weight 1
+  s.weight = m_decay * s.weight + 1;
+  const double dx = x - s.mean_x;
+  const double dy = y - s.mean_y;
+  s.mean_x += dx / s.weight;
+  s.mean_y += dy / s.weight;
+  s.cxx = m_decay * s.cxx + dx * (x - s.mean_x);
+  s.cxy = m_decay * s.cxy + dx * (y - s.mean_y);
+  s.cyy = m_decay * s.cyy + dy * (y - s.mean_y);
+  s.last_x = x;
+  s.last_timestamp = timestamp;
+  ++s.n_samples;
+}
+
+inline LinkClockFit
+TimestampSkewMonitor::fit_of(const LinkState& s) noexcept
+{
+  LinkClockFit fit{ s.n_samples, s.last_timestamp, s.mean_y, 0, 0 };
+  // With all samples at one reference time there is no slope to fit
+  if (s.cxx > 0) {
+    fit.drift = s.cxy / s.cxx;
+    fit.offset = s.mean_y + fit.drift * (s.last_x - s.mean_x);
+    fit.jitter = std::sqrt(std::max(0., s.cyy - s.cxy * fit.drift) / s.weight);
+  } else {
+    fit.jitter = std::sqrt(std::max(0., s.cyy) / s.weight);
+  }
+  return fit;
+}
+
+inline bool
+TimestampSkewMonitor::fit(link_t link, LinkClockFit& out) const
+{
+  const auto it = m_link_index.find(link);
+  if (it == m_link_index.end())
+    return false;
+  out = fit_of(m_links[it->second]);
+  return true;
+}
+
+inline TimestampSkewMonitor::Report
+TimestampSkewMonitor::report() const
+{
+  Report report;
+  report.links.reserve(m_links.size());
+  std::vector<double> offsets;
+  std::vector<double> drifts;
+  for (const auto& state : m_links) {
+    report.links.push_back(LinkStatus{ state.link, fit_of(state), 0, 0, false, false });
+    const auto& fit = report.links.back().fit;
+    if (fit.n_samples >= m_config.min_samples) {
+      offsets.push_back(fit.offset);
+      drifts.push_back(fit.drift);
+    }
+  }
+  std::sort(report.links.begin(), report.links.end(), [](const LinkStatus& a, const LinkStatus& b) {
+    return a.link < b.link;
+  });
+
+  if (m_config.reference_link != s_no_link) {
+    const auto it = std::lower_bound(
+      report.links.begin(), report.links.end(), m_config.reference_link, [](const LinkStatus& s, link_t link) {
+        return s.link < link;
+      });
+    if (it != report.links.end() && it->link == m_config.reference_link && it->fit.n_samples >= m_config.min_samples) {
+      report.has_reference = true;
+      report.reference_offset = it->fit.offset;
+      report.reference_drift = it->fit.drift;
+    }
+  } else if (!offsets.empty()) {
+    // The median ignores a minority of misaligned links, however far off they are
+    auto median = [](std::vector<double>& v) {
+      auto mid = v.begin() + v.size() / 2;
+      std::nth_element(v.begin(), mid, v.end());
+      if (v.size() % 2 != 0)
+        return *mid;
+      return (*mid + *std::max_element(v.begin(), mid)) / 2;
+    };
+    report.has_reference = true;
+    report.reference_offset = median(offsets);
+    report.reference_drift = median(drifts);
+  }
+  if (!report.has_reference)
+    return report;
+
+  for (auto& status : report.links) {
+    status.skew = status.fit.offset - report.reference_offset;
+    status.drift_ppm = (status.fit.drift - report.reference_drift) * 1e6;
+    if (status.fit.n_samples < m_config.min_samples)
+      continue;
+    status.offset_out = std::abs(status.skew) > m_config.offset_tolerance;
+    status.drift_out = std::abs(status.drift_ppm) > m_config.drift_tolerance_ppm;
+    report.n_flagged += status.flagged();
+  }
+  return report;
+}
+
+inline void
+TimestampSkewMonitor::clear()
+{
+  m_link_index.clear();
+  m_links.clear();
+  m_has_last = false;
+  m_counters = Counters();
+}
+
+} // namespace dunedaq::detdataformats
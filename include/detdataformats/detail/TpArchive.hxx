@@ -0,0 +1,467 @@
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace dunedaq::detdataformats {
+
+static_assert(tparchive::s_version == 1,
+              "This is intentionally designed to tell the developer to update the static_assert checks (including this "
+              "one) when the version is bumped");
+static_assert(sizeof(TpRow) == 32, "TpRow struct size different than expected!");
+static_assert(sizeof(tparchive::FileHeader) == 16, "TpArchive FileHeader size different than expected!");
+static_assert(sizeof(tparchive::ColumnMeta) == 32, "TpArchive ColumnMeta size different than expected!");
+static_assert(sizeof(tparchive::RowGroupMeta) == 8 + 32 * tparchive::kNumColumns,
+              "TpArchive RowGroupMeta size different than expected!");
+static_assert(sizeof(tparchive::Trailer) == 32, "TpArchive Trailer size different than expected!");
+
+namespace tparchive::detail {
+
+inline uint32_t // NOLINT(build/unsigned)
+width_for_range(uint64_t range) noexcept // NOLINT(build/unsigned)
+{
+  if (range == 0)
+    return 0;
+  if (range <= 0xFF)
+    return 1;
+  if (range <= 0xFFFF)
+    return 2;
+  if (range <= 0xFFFFFFFF)
+    return 4;
+  return 8;
+}
+
+template<class T>
+inline void
+encode(const uint64_t* in, std::size_t n, uint64_t min, unsigned char* out) noexcept // NOLINT(build/unsigned)
+{
+  T* dst = reinterpret_cast<T*>(out);
+  for (std::size_t i = 0; i < n; ++i)
+    dst[i] = static_cast<T>(in[i] - min);
+}
+
+template<class T>
+inline void
+decode(const unsigned char* in, std::size_t n, uint64_t min, uint64_t* out) noexcept // NOLINT(build/unsigned)
+{
+  const T* src = reinterpret_cast<const T*>(in);
+  for (std::size_t i = 0; i < n; ++i)
+    out[i] = src[i] + min;
+}
+
+template<class T>
+inline void
+gather(const unsigned char* in,
+       const uint32_t* selection, // NOLINT(build/unsigned)
+       std::size_t n,
+       uint64_t min, // NOLINT(build/unsigned)
+       uint64_t* out) noexcept // NOLINT(build/unsigned)
+{
+  const T* src = reinterpret_cast<const T*>(in);
+  for (std::size_t k = 0; k < n; ++k)
+    out[k] = src[selection[k]] + min;
+}
+
+} // namespace tparchive::detail
+
+//========================
+// TpArchiveWriter
+//========================
+
+inline TpArchiveWriter::TpArchiveWriter(const std::string& path, std::size_t rows_per_group)
+  : m_path(path)
+  , m_rows_per_group(rows_per_group)
+{
+  if (rows_per_group == 0)
+    throw std::invalid_argument("TpArchiveWriter: rows per group must be non-zero");
+  m_file = std::fopen(path.c_str(), "wb");
+  if (m_file == nullptr)
+    throw std::runtime_error("TpArchiveWriter: cannot open " + path + ": " + std::strerror(errno));
+  for (auto& c : m_columns)
+    c.reserve(rows_per_group);
+
+  tparchive::FileHeader header{};
+  std::memcpy(header.magic, tparchive::s_magic, sizeof(header.magic));
+  header.version = tparchive::s_version;
+  header.n_columns = tparchive::kNumColumns;
+  write(&header, sizeof(header));
+}
+
+inline TpArchiveWriter::~TpArchiveWriter()
+{
+  if (m_file != nullptr) {
+    try {
+      close();
+    } catch (...) { // NOLINT(bugprone-empty-catch)
+      // Destructors must not throw; call close() explicitly to see write errors
+    }
+  }
+}
+
+inline void
+TpArchiveWriter::write(const void* data, std::size_t size)
+{
+  if (std::fwrite(data, 1, size, m_file) != size)
+    throw std::runtime_error("TpArchiveWriter: write to " + m_path + " failed: " + std::strerror(errno));
+  m_offset += size;
+}
+
+inline void
+TpArchiveWriter::append(const TpRow& row)
+{
+  using namespace tparchive;
+  m_columns[kTimestamp].push_back(row.timestamp);
+  m_columns[kCrate].push_back(row.crate);
+  m_columns[kSlot].push_back(row.slot);
+  m_columns[kFiber].push_back(row.fiber);
+  m_columns[kWire].push_back(row.wire);
+  m_columns[kHeaderFlags].push_back(row.header_flags);
+  m_columns[kMedian].push_back(row.median);
+  m_columns[kAccumulator].push_back(row.accumulator);
+  m_columns[kStartTime].push_back(row.start_time);
+  m_columns[kEndTime].push_back(row.end_time);
+  m_columns[kPeakTime].push_back(row.peak_time);
+  m_columns[kPeakAdc].push_back(row.peak_adc);
+  m_columns[kSumAdc].push_back(row.sum_adc);
+  m_columns[kTpFlags].push_back(row.tp_flags);
+  m_columns[kHitContinue].push_back(row.hit_continue);
+  ++m_n_rows;
+  if (m_columns[kTimestamp].size() >= m_rows_per_group)
+    flush_group();
+}
+
+template<class Header, class Data>
+void
+TpArchiveWriter::append(const TpFrameRef<Header, Data>& frame)
+{
+  TpRow row{};
+  const Header& h = *frame.header;
+  row.timestamp = h.get_timestamp();
+  row.crate = h.m_crate_no;
+  row.slot = h.m_slot_no;
+  row.fiber = h.m_fiber_no;
+  row.wire = h.m_wire_no;
+  row.header_flags = h.m_flags;
+  row.median = h.m_median;
+  row.accumulator = h.m_accumulator;
+  for (std::size_t i = 0; i < frame.nhits; ++i) {
+    const Data& d = frame.hits[i];
+    row.start_time = d.m_start_time;
+    row.end_time = d.m_end_time;
+    row.peak_time = d.m_peak_time;
+    row.peak_adc = d.m_peak_adc;
+    row.sum_adc = d.m_sum_adc;
+    row.tp_flags = d.m_tp_flags;
+    row.hit_continue = d.m_hit_continue;
+    append(row);
+  }
+}
+
+template<class Header, class Data>
+std::size_t
+TpArchiveWriter::append_frames(const void* buffer, std::size_t size)
+{
+  TpFrameRange<Header, Data> frames(buffer, size);
+  std::size_t consumed = 0;
+  for (auto it = frames.begin(); it != frames.end(); ++it) {
+    append(*it);
+    consumed = it.position() + it->size() - static_cast<const unsigned char*>(buffer);
+  }
+  return consumed;
+}
+
+inline void
+TpArchiveWriter::flush_group()
+{
+  using namespace tparchive;
+  const std::size_t n = m_columns[kTimestamp].size();
+  if (n == 0)
+    return;
+
+  RowGroupMeta meta{};
+  meta.n_rows = n;
+  for (unsigned c = 0; c < kNumColumns; ++c) {
+    const auto& values = m_columns[c];
+    auto [lo, hi] = std::minmax_element(values.begin(), values.end());
+    ColumnMeta& col = meta.columns[c];
+    col.min = *lo;
+    col.max = *hi;
+    col.width = detail::width_for_range(col.max - col.min);
+    col.offset = m_offset;
+
+    // Columns are padded to 8 bytes so that every column can be read in place
+    const std::size_t bytes = (n * col.width + 7) & ~std::size_t(7);
+    m_encoded.assign(bytes, 0);
+    switch (col.width) {
+      case 1:
+        detail::encode<uint8_t>(values.data(), n, col.min, m_encoded.data()); // NOLINT(build/unsigned)
+        break;
+      case 2:
+        detail::encode<uint16_t>(values.data(), n, col.min, m_encoded.data()); // NOLINT(build/unsigned)
+        break;
+      case 4:
+        detail::encode<uint32_t>(values.data(), n, col.min, m_encoded.data()); // NOLINT(build/unsigned)
+        break;
+      case 8:
+        detail::encode<uint64_t>(values.data(), n, col.min, m_encoded.data()); // NOLINT(build/unsigned)
+        break;
+      default:
+        break;
+    }
+    if (bytes != 0)
+      write(m_encoded.data(), bytes);
+  }
+  m_groups.push_back(meta);
+  for (auto& c : m_columns)
+    c.clear();
+}
+
+inline void
+TpArchiveWriter::close()
+{
+  if (m_file == nullptr)
+    return;
+  flush_group();
+
+  tparchive::Trailer trailer{};
+  trailer.meta_offset = m_offset;
+  trailer.n_row_groups = m_groups.size();
+  trailer.n_rows = m_n_rows;
+  std::memcpy(trailer.magic, tparchive::s_magic, sizeof(trailer.magic));
+  if (!m_groups.empty())
+    write(m_groups.data(), m_groups.size() * sizeof(tparchive::RowGroupMeta));
+  write(&trailer, sizeof(trailer));
+
+  const bool failed = std::fclose(m_file) != 0;
+  m_file = nullptr;
+  if (failed)
+    throw std::runtime_error("TpArchiveWriter: closing " + m_path + " failed: " + std::strerror(errno));
+}
+
+//========================
+// TpArchiveReader
+//========================
+
+inline TpArchiveReader::TpArchiveReader(const std::string& path)
+{
+  m_fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC); // NOLINT
+  if (m_fd < 0)
+    throw std::runtime_error("TpArchiveReader: cannot open " + path + ": " + std::strerror(errno));
+
+  struct stat st;
+  if (::fstat(m_fd, &st) != 0 ||
+      static_cast<std::size_t>(st.st_size) < sizeof(tparchive::FileHeader) + sizeof(tparchive::Trailer)) {
+    ::close(m_fd);
+    throw std::runtime_error("TpArchiveReader: " + path + " is too small to be a TP archive");
+  }
+  m_size = st.st_size;
+  void* p = ::mmap(nullptr, m_size, PROT_READ, MAP_SHARED, m_fd, 0);
+  if (p == MAP_FAILED) {
+    ::close(m_fd);
+    throw std::runtime_error("TpArchiveReader: cannot map " + path + ": " + std::strerror(errno));
+  }
+  m_data = static_cast<const unsigned char*>(p);
+
+  auto fail = [&](const std::string& what) {
+    ::munmap(const_cast<unsigned char*>(m_data), m_size);
+    ::close(m_fd);
+    throw std::runtime_error("TpArchiveReader: " + path + ": " + what);
+  };
+
+  tparchive::FileHeader header;
+  std::memcpy(&header, m_data, sizeof(header));
+  std::memcpy(&m_trailer, m_data + m_size - sizeof(m_trailer), sizeof(m_trailer));
+  if (std::memcmp(header.magic, tparchive::s_magic, sizeof(header.magic)) != 0 ||
+      std::memcmp(m_trailer.magic, tparchive::s_magic, sizeof(m_trailer.magic)) != 0)
+    fail("bad magic");
+  if (header.version != tparchive::s_version || header.n_columns != tparchive::kNumColumns)
+    fail("unsupported version " + std::to_string(header.version));
+  if (m_trailer.meta_offset % 8 != 0 ||
+      m_trailer.meta_offset + m_trailer.n_row_groups * sizeof(tparchive::RowGroupMeta) + sizeof(m_trailer) != m_size)
+    fail("inconsistent footer");
+  m_groups = reinterpret_cast<const tparchive::RowGroupMeta*>(m_data + m_trailer.meta_offset);
+
+  for (std::size_t g = 0; g < m_trailer.n_row_groups; ++g)
+    for (auto const& col : m_groups[g].columns) {
+      if (col.width != 0 && col.width != 1 && col.width != 2 && col.width != 4 && col.width != 8)
+        fail("bad column width " + std::to_string(col.width) + " in row group " + std::to_string(g));
+      if (col.offset + m_groups[g].n_rows * col.width > m_trailer.meta_offset)
+        fail("column of row group " + std::to_string(g) + " out of bounds");
+    }
+
+  ::madvise(p, m_size, MADV_RANDOM);
+}
+
+inline TpArchiveReader::~TpArchiveReader()
+{
+  ::munmap(const_cast<unsigned char*>(m_data), m_size);
+  ::close(m_fd);
+}
+
+inline bool
+TpArchiveReader::may_match(std::size_t i, const TpQuery& q) const noexcept
+{
+  using namespace tparchive;
+  auto overlaps = [&](Column c, uint64_t lo, uint64_t hi) { // NOLINT(build/unsigned)
+    return m_groups[i].columns[c].max >= lo && m_groups[i].columns[c].min <= hi;
+  };
+  return q.timestamp_begin < q.timestamp_end && overlaps(kTimestamp, q.timestamp_begin, q.timestamp_end - 1) &&
+         overlaps(kCrate, q.crate_min, q.crate_max) && overlaps(kSlot, q.slot_min, q.slot_max) &&
+         overlaps(kFiber, q.fiber_min, q.fiber_max) && overlaps(kWire, q.wire_min, q.wire_max);
+}
+
+inline void
+TpArchiveReader::decode_column(std::size_t group, tparchive::Column column, uint64_t* out) const // NOLINT
+{
+  const tparchive::ColumnMeta& col = m_groups[group].columns[column];
+  const std::size_t n = m_groups[group].n_rows;
+  const unsigned char* in = m_data + col.offset;
+  switch (col.width) {
+    case 0:
+      std::fill(out, out + n, col.min);
+      break;
+    case 1:
+      tparchive::detail::decode<uint8_t>(in, n, col.min, out); // NOLINT(build/unsigned)
+      break;
+    case 2:
+      tparchive::detail::decode<uint16_t>(in, n, col.min, out); // NOLINT(build/unsigned)
+      break;
+    case 4:
+      tparchive::detail::decode<uint32_t>(in, n, col.min, out); // NOLINT(build/unsigned)
+      break;
+    case 8:
+      tparchive::detail::decode<uint64_t>(in, n, col.min, out); // NOLINT(build/unsigned)
+      break;
+  }
+}
+
+inline void
+TpArchiveReader::gather_column(std::size_t group,
+                               tparchive::Column column,
+                               const uint32_t* selection, // NOLINT(build/unsigned)
+                               std::size_t n,
+                               uint64_t* out) const // NOLINT(build/unsigned)
+{
+  const tparchive::ColumnMeta& col = m_groups[group].columns[column];
+  const unsigned char* in = m_data + col.offset;
+  switch (col.width) {
+    case 0:
+      std::fill(out, out + n, col.min);
+      break;
+    case 1:
+      tparchive::detail::gather<uint8_t>(in, selection, n, col.min, out); // NOLINT(build/unsigned)
+      break;
+    case 2:
+      tparchive::detail::gather<uint16_t>(in, selection, n, col.min, out); // NOLINT(build/unsigned)
+      break;
+    case 4:
+      tparchive::detail::gather<uint32_t>(in, selection, n, col.min, out); // NOLINT(build/unsigned)
+      break;
+    case 8:
+      tparchive::detail::gather<uint64_t>(in, selection, n, col.min, out); // NOLINT(build/unsigned)
+      break;
+  }
+}
+
+template<class Emit>
+std::size_t
+TpArchiveReader::scan(const TpQuery& q, Emit&& emit) const
+{
+  using namespace tparchive;
+  std::size_t n_decoded = 0;
+  std::array<std::vector<uint64_t>, kNumColumns> values; // NOLINT(build/unsigned)
+  std::vector<uint32_t> selection;                       // NOLINT(build/unsigned)
+
+  struct Filter
+  {
+    Column column;
+    uint64_t lo, hi; // NOLINT(build/unsigned)
+  };
+  const Filter filters[] = { { kTimestamp, q.timestamp_begin, q.timestamp_end - 1 },
+                             { kCrate, q.crate_min, q.crate_max },
+                             { kSlot, q.slot_min, q.slot_max },
+                             { kFiber, q.fiber_min, q.fiber_max },
+                             { kWire, q.wire_min, q.wire_max } };
+
+  for (std::size_t g = 0; g < m_trailer.n_row_groups; ++g) {
+    if (!may_match(g, q))
+      continue;
+    ++n_decoded;
+    const std::size_t n = m_groups[g].n_rows;
+
+    // Only columns whose zone map is not entirely inside the query range need a per-row check
+    bool decoded[kNumColumns] = {};
+    selection.resize(n);
+    for (std::size_t i = 0; i < n; ++i)
+      selection[i] = i;
+    for (auto const& f : filters) {
+      const ColumnMeta& col = m_groups[g].columns[f.column];
+      if (col.min >= f.lo && col.max <= f.hi)
+        continue;
+      values[f.column].resize(n);
+      decode_column(g, f.column, values[f.column].data());
+      decoded[f.column] = true;
+      const uint64_t* v = values[f.column].data(); // NOLINT(build/unsigned)
+      std::size_t kept = 0;
+      for (std::size_t k = 0; k < selection.size(); ++k) {
+        const uint32_t i = selection[k]; // NOLINT(build/unsigned)
+        selection[kept] = i;
+        kept += (v[i] >= f.lo) & (v[i] <= f.hi);
+      }
+      selection.resize(kept);
+    }
+    if (selection.empty())
+      continue;
+
+    // Sparse selections fetch only the selected rows of the remaining columns; dense ones decode
+    // whole columns, which vectorises. Either way values[c][k] holds the k-th selected row.
+    const std::size_t n_sel = selection.size();
+    const bool sparse = n_sel * 4 < n;
+    for (unsigned c = 0; c < kNumColumns; ++c) {
+      values[c].resize(n);
+      if (decoded[c] || !sparse) {
+        if (!decoded[c])
+          decode_column(g, static_cast<Column>(c), values[c].data());
+        if (n_sel != n)
+          for (std::size_t k = 0; k < n_sel; ++k)
+            values[c][k] = values[c][selection[k]];
+      } else {
+        gather_column(g, static_cast<Column>(c), selection.data(), n_sel, values[c].data());
+      }
+    }
+    for (std::size_t i = 0; i < n_sel; ++i) {
+      TpRow row;
+      row.timestamp = values[kTimestamp][i];
+      row.crate = values[kCrate][i];
+      row.slot = values[kSlot][i];
+      row.fiber = values[kFiber][i];
+      row.wire = values[kWire][i];
+      row.header_flags = values[kHeaderFlags][i];
+      row.median = values[kMedian][i];
+      row.accumulator = values[kAccumulator][i];
+      row.start_time = values[kStartTime][i];
+      row.end_time = values[kEndTime][i];
+      row.peak_time = values[kPeakTime][i];
+      row.peak_adc = values[kPeakAdc][i];
+      row.sum_adc = values[kSumAdc][i];
+      row.tp_flags = values[kTpFlags][i];
+      row.hit_continue = values[kHitContinue][i];
+      emit(static_cast<const TpRow&>(row));
+    }
+  }
+  return n_decoded;
+}
+
+inline std::size_t
+TpArchiveReader::query(const TpQuery& q, std::vector<TpRow>& out) const
+{
+  return scan(q, [&out](const TpRow& row) { out.push_back(row); });
+}
+
+} // namespace dunedaq::detdataformats
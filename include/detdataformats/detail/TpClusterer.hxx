@@ -0,0 +1,230 @@
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace dunedaq::detdataformats {
+
+static_assert(sizeof(TpCluster) == 48, "TpCluster struct size different than expected!");
+
+inline TpClusterer::TpClusterer(std::size_t n_channels, const Config& config)
+  : m_config(config)
+  , m_n_channels(n_channels)
+  , m_active_bits((n_channels + 63) / 64, 0)
+  , m_channels(n_channels, ChannelState{ 0, s_no_slot })
+{
+  if (n_channels == 0)
+    throw std::invalid_argument("TpClusterer: the number of channels must be non-zero");
+}
+
+inline TpClusterer::slot_t
+TpClusterer::find(slot_t s) noexcept
+{
+  while (m_slots[s].parent != s) {
+    m_slots[s].parent = m_slots[m_slots[s].parent].parent;
+    s = m_slots[s].parent;
+  }
+  return s;
+}
+
+inline TpClusterer::slot_t
+TpClusterer::allocate()
+{
+  slot_t s;
+  if (!m_free_slots.empty()) {
+    s = m_free_slots.back();
+    m_free_slots.pop_back();
+  } else {
+    s = m_slots.size();
+    m_slots.emplace_back();
+  }
+  m_slots[s].parent = s;
+  m_slots[s].next_alias = s_no_slot;
+  m_slots[s].alias_tail = s;
+  m_slots[s].open_index = m_open.size();
+  m_open.push_back(s);
+  m_open_expiry.push_back(s_never);
+  return s;
+}
+
+inline void
+TpClusterer::release(slot_t root)
+{
+  for (slot_t s = root; s != s_no_slot; s = m_slots[s].next_alias)
+    m_free_slots.push_back(s);
+}
+
+inline void
+TpClusterer::remove_open(std::size_t open_index) noexcept
+{
+  m_open[open_index] = m_open.back();
+  m_open_expiry[open_index] = m_open_expiry.back();
+  m_slots[m_open[open_index]].open_index = open_index;
+  m_open.pop_back();
+  m_open_expiry.pop_back();
+}
+
+inline TpClusterer::slot_t
+TpClusterer::merge(slot_t a, slot_t b) noexcept
+{
+  if (a == b)
+    return a;
+  if (m_slots[a].cluster.n_hits < m_slots[b].cluster.n_hits)
+    std::swap(a, b);
+
+  TpCluster& root = m_slots[a].cluster;
+  const TpCluster& other = m_slots[b].cluster;
+  root.start_time = std::min(root.start_time, other.start_time);
+  root.end_time = std::max(root.end_time, other.end_time);
+  root.channel_min = std::min(root.channel_min, other.channel_min);
+  root.channel_max = std::max(root.channel_max, other.channel_max);
+  if (other.peak_adc > root.peak_adc) {
+    root.peak_adc = other.peak_adc;
+    root.peak_time = other.peak_time;
+    root.peak_channel = other.peak_channel;
+  }
+  root.sum_adc += other.sum_adc;
+  root.n_hits += other.n_hits;
+  root.tp_flags |= other.tp_flags;
+
+  // b is no longer open: remove it and chain it (and its aliases) behind a
+  m_open_expiry[m_slots[a].open_index] = std::max(m_open_expiry[m_slots[a].open_index],
+                                                  m_open_expiry[m_slots[b].open_index]);
+  remove_open(m_slots[b].open_index);
+
+  m_slots[b].parent = a;
+  m_slots[m_slots[a].alias_tail].next_alias = b;
+  m_slots[a].alias_tail = m_slots[b].alias_tail;
+  return a;
+}
+
+template<class Emit>
+void
+TpClusterer::close(std::size_t open_index, Emit& emit)
+{
+  const slot_t root = m_open[open_index];
+  remove_open(open_index);
+
+  if (m_slots[root].cluster.n_hits >= m_config.min_hits)
+    emit(static_cast<const TpCluster&>(m_slots[root].cluster));
+  release(root);
+}
+
+template<class Emit>
+void
+TpClusterer::advance(uint64_t timestamp, Emit&& emit) // NOLINT(build/unsigned)
+{
+  if (m_next_expiry >= timestamp)
+    return;
+
+  m_next_expiry = s_never;
+  for (std::size_t i = 0; i < m_open_expiry.size();) {
+    if (m_open_expiry[i] < timestamp) {
+      close(i, emit); // moves the last open cluster into position i
+    } else {
+      m_next_expiry = std::min(m_next_expiry, m_open_expiry[i]);
+      ++i;
+    }
+  }
+}
+
+template<class Emit>
+void
+TpClusterer::flush(Emit&& emit)
+{
+  while (!m_open.empty())
+    close(m_open.size() - 1, emit);
+  m_next_expiry = s_never;
+
+  // Every slot is released, so no channel may lead a later hit back to one
+  for (std::size_t w = 0; w < m_active_bits.size(); ++w) {
+    for (uint64_t bits = m_active_bits[w]; bits; bits &= bits - 1) // NOLINT(build/unsigned)
+      m_channels[w * 64 + __builtin_ctzll(bits)] = ChannelState{ 0, s_no_slot };
+    m_active_bits[w] = 0;
+  }
+}
+
+template<class Emit>
+void
+TpClusterer::add(uint32_t channel,    // NOLINT(build/unsigned)
+                 uint64_t start_time, // NOLINT(build/unsigned)
+                 uint64_t end_time,   // NOLINT(build/unsigned)
+                 uint64_t peak_time,  // NOLINT(build/unsigned)
+                 uint16_t peak_adc,   // NOLINT(build/unsigned)
+                 uint32_t sum_adc,    // NOLINT(build/unsigned)
+                 uint16_t tp_flags,   // NOLINT(build/unsigned)
+                 Emit&& emit)
+{
+  if (channel >= m_n_channels) {
+    ++m_n_dropped_hits;
+    return;
+  }
+  // Late hits are matched as if they arrived now, so they never reach a cluster that was already closed
+  if (start_time < m_last_start)
+    ++m_n_out_of_order_hits;
+  else
+    m_last_start = start_time;
+  const uint64_t now = m_last_start; // NOLINT(build/unsigned)
+
+  advance(now, emit);
+
+  const uint32_t gap = m_config.max_channel_gap; // NOLINT(build/unsigned)
+  const std::size_t lo = channel > gap ? channel - gap : 0;
+  const std::size_t hi = std::min<std::size_t>(std::size_t(channel) + gap, m_n_channels - 1);
+
+  slot_t target = s_no_slot;
+  for (std::size_t w = lo / 64; w <= hi / 64; ++w) {
+    uint64_t bits = m_active_bits[w]; // NOLINT(build/unsigned)
+    if (w == lo / 64)
+      bits &= ~uint64_t(0) << (lo % 64); // NOLINT(build/unsigned)
+    if (w == hi / 64 && hi % 64 != 63)
+      bits &= (uint64_t(1) << (hi % 64 + 1)) - 1; // NOLINT(build/unsigned)
+
+    while (bits) {
+      const std::size_t c = w * 64 + __builtin_ctzll(bits);
+      bits &= bits - 1;
+      if (m_channels[c].end_time + m_config.max_time_gap < now) {
+        m_active_bits[w] &= ~(uint64_t(1) << (c % 64)); // NOLINT(build/unsigned)
+        continue;
+      }
+      const slot_t s = find(m_channels[c].cluster);
+      target = target == s_no_slot ? s : merge(target, s);
+    }
+  }
+
+  if (target == s_no_slot) {
+    target = allocate();
+    TpCluster& cl = m_slots[target].cluster;
+    cl.start_time = start_time;
+    cl.end_time = end_time;
+    cl.peak_time = peak_time;
+    cl.channel_min = channel;
+    cl.channel_max = channel;
+    cl.peak_channel = channel;
+    cl.sum_adc = sum_adc;
+    cl.n_hits = 1;
+    cl.peak_adc = peak_adc;
+    cl.tp_flags = tp_flags;
+  } else {
+    TpCluster& cl = m_slots[target].cluster;
+    cl.start_time = std::min(cl.start_time, start_time);
+    cl.end_time = std::max(cl.end_time, end_time);
+    cl.channel_min = std::min(cl.channel_min, channel);
+    cl.channel_max = std::max(cl.channel_max, channel);
+    if (peak_adc > cl.peak_adc) {
+      cl.peak_adc = peak_adc;
+      cl.peak_time = peak_time;
+      cl.peak_channel = channel;
+    }
+    cl.sum_adc += sum_adc;
+    ++cl.n_hits;
+    cl.tp_flags |= tp_flags;
+  }
+  const uint64_t expiry = m_slots[target].cluster.end_time + m_config.max_time_gap; // NOLINT(build/unsigned)
+  m_open_expiry[m_slots[target].open_index] = expiry;
+  m_next_expiry = std::min(m_next_expiry, expiry);
+  m_channels[channel].end_time = std::max(m_channels[channel].end_time, end_time);
+  m_channels[channel].cluster = target;
+  m_active_bits[channel / 64] |= uint64_t(1) << (channel % 64); // NOLINT(build/unsigned)
+}
+
+} // namespace dunedaq::detdataformats
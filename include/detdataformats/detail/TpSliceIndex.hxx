@@ -0,0 +1,371 @@
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace dunedaq::detdataformats {
+
+namespace detail {
+
+inline void
+or_block(ChannelBitmap::Block& out, const ChannelBitmap::Block& a, const ChannelBitmap::Block& b) noexcept
+{
+  for (std::size_t k = 0; k < ChannelBitmap::s_words_per_block; ++k)
+    out.words[k] = a.words[k] | b.words[k];
+}
+
+// Returns whether the result has any bit set
+inline bool
+and_block(ChannelBitmap::Block& out, const ChannelBitmap::Block& a, const ChannelBitmap::Block& b) noexcept
+{
+  uint64_t any = 0; // NOLINT(build/unsigned)
+  for (std::size_t k = 0; k < ChannelBitmap::s_words_per_block; ++k) {
+    out.words[k] = a.words[k] & b.words[k];
+    any |= out.words[k];
+  }
+  return any != 0;
+}
+
+} // namespace detail
+
+//========================
+// ChannelBitmap
+//========================
+
+inline ChannelBitmap
+ChannelBitmap::from_channels(std::vector<channel_t> channels)
+{
+  std::sort(channels.begin(), channels.end());
+  ChannelBitmap bitmap;
+  for (auto c : channels) {
+    const uint32_t id = c / s_block_bits; // NOLINT(build/unsigned)
+    if (bitmap.m_ids.empty() || bitmap.m_ids.back() != id) {
+      bitmap.m_ids.push_back(id);
+      bitmap.m_blocks.push_back(Block{});
+    }
+    bitmap.m_blocks.back().words[c % s_block_bits / 64] |= uint64_t(1) << (c % 64); // NOLINT(build/unsigned)
+  }
+  return bitmap;
+}
+
+inline ChannelBitmap
+ChannelBitmap::range(channel_t first, channel_t last)
+{
+  ChannelBitmap bitmap;
+  for (uint64_t c = first; c < last;) { // NOLINT(build/unsigned)
+    const uint32_t id = c / s_block_bits; // NOLINT(build/unsigned)
+    Block block{};
+    const uint64_t block_end = std::min<uint64_t>(uint64_t(id + 1) * s_block_bits, last); // NOLINT(build/unsigned)
+    for (; c < block_end; ++c)
+      block.words[c % s_block_bits / 64] |= uint64_t(1) << (c % 64); // NOLINT(build/unsigned)
+    bitmap.m_ids.push_back(id);
+    bitmap.m_blocks.push_back(block);
+  }
+  return bitmap;
+}
+
+inline bool
+ChannelBitmap::test(channel_t channel) const noexcept
+{
+  auto it = std::lower_bound(m_ids.begin(), m_ids.end(), channel / s_block_bits);
+  if (it == m_ids.end() || *it != channel / s_block_bits)
+    return false;
+  return (m_blocks[it - m_ids.begin()].words[channel % s_block_bits / 64] >> (channel % 64)) & 1;
+}
+
+inline std::size_t
+ChannelBitmap::count() const noexcept
+{
+  std::size_t n = 0;
+  for (auto const& block : m_blocks)
+    for (auto w : block.words)
+      n += __builtin_popcountll(w);
+  return n;
+}
+
+inline std::vector<ChannelBitmap::channel_t>
+ChannelBitmap::channels() const
+{
+  std::vector<channel_t> out;
+  out.reserve(count());
+  for (std::size_t i = 0; i < m_ids.size(); ++i)
+    for (std::size_t k = 0; k < s_words_per_block; ++k)
+      for (uint64_t w = m_blocks[i].words[k]; w != 0; w &= w - 1) // NOLINT(build/unsigned)
+        out.push_back(m_ids[i] * s_block_bits + k * 64 + __builtin_ctzll(w));
+  return out;
+}
+
+inline bool
+ChannelBitmap::intersects(const ChannelBitmap& other) const noexcept
+{
+  Block scratch;
+  std::size_t i = 0, j = 0;
+  while (i < m_ids.size() && j < other.m_ids.size()) {
+    if (m_ids[i] < other.m_ids[j]) {
+      ++i;
+    } else if (m_ids[i] > other.m_ids[j]) {
+      ++j;
+    } else {
+      if (detail::and_block(scratch, m_blocks[i], other.m_blocks[j]))
+        return true;
+      ++i;
+      ++j;
+    }
+  }
+  return false;
+}
+
+inline ChannelBitmap&
+ChannelBitmap::operator|=(const ChannelBitmap& other)
+{
+  if (other.empty())
+    return *this;
+  std::vector<uint32_t> ids; // NOLINT(build/unsigned)
+  std::vector<Block> blocks;
+  ids.reserve(m_ids.size() + other.m_ids.size());
+  blocks.reserve(m_ids.size() + other.m_ids.size());
+  std::size_t i = 0, j = 0;
+  while (i < m_ids.size() || j < other.m_ids.size()) {
+    if (j == other.m_ids.size() || (i < m_ids.size() && m_ids[i] < other.m_ids[j])) {
+      ids.push_back(m_ids[i]);
+      blocks.push_back(m_blocks[i++]);
+    } else if (i == m_ids.size() || other.m_ids[j] < m_ids[i]) {
+      ids.push_back(other.m_ids[j]);
+      blocks.push_back(other.m_blocks[j++]);
+    } else {
+      ids.push_back(m_ids[i]);
+      blocks.emplace_back();
+      detail::or_block(blocks.back(), m_blocks[i++], other.m_blocks[j++]);
+    }
+  }
+  m_ids.swap(ids);
+  m_blocks.swap(blocks);
+  return *this;
+}
+
+inline ChannelBitmap&
+ChannelBitmap::operator&=(const ChannelBitmap& other)
+{
+  // In place: the result never has more blocks than either operand
+  std::size_t n = 0, i = 0, j = 0;
+  while (i < m_ids.size() && j < other.m_ids.size()) {
+    if (m_ids[i] < other.m_ids[j]) {
+      ++i;
+    } else if (m_ids[i] > other.m_ids[j]) {
+      ++j;
+    } else {
+      if (detail::and_block(m_blocks[n], m_blocks[i], other.m_blocks[j]))
+        m_ids[n++] = m_ids[i];
+      ++i;
+      ++j;
+    }
+  }
+  m_ids.resize(n);
+  m_blocks.resize(n);
+  return *this;
+}
+
+inline bool
+operator==(const ChannelBitmap& a, const ChannelBitmap& b) noexcept
+{
+  if (a.m_ids != b.m_ids)
+    return false;
+  for (std::size_t i = 0; i < a.m_blocks.size(); ++i)
+    if (!std::equal(a.m_blocks[i].words, a.m_blocks[i].words + ChannelBitmap::s_words_per_block, b.m_blocks[i].words))
+      return false;
+  return true;
+}
+
+//========================
+// TpSliceIndex
+//========================
+
+template<class Layout>
+TpSliceIndex<Layout>::TpSliceIndex(const channel_map_t& channel_map, const Config& config)
+  : m_channel_map(channel_map)
+  , m_config(config)
+{
+  if (m_config.slice_ticks == 0)
+    throw std::invalid_argument("TpSliceIndex: slice width must be non-zero");
+}
+
+template<class Layout>
+std::size_t
+TpSliceIndex<Layout>::add(const void* buffer, std::size_t size)
+{
+  auto begin = static_cast<const unsigned char*>(buffer);
+  TpFrameRange<header_t, data_t> frames(buffer, size);
+  std::size_t consumed = 0;
+  m_header_scratch.clear();
+  m_offset_scratch.clear();
+  for (auto it = frames.begin(); it != frames.end(); ++it) {
+    m_header_scratch.push_back(it->header);
+    m_offset_scratch.push_back(it.position() - begin);
+    consumed = it.position() - begin + it->size();
+  }
+
+  const std::size_t n = m_header_scratch.size();
+  m_channel_scratch.resize(n);
+  m_channel_map.lookup(m_header_scratch.data(), n, m_channel_scratch.data());
+
+  // Frame runs are extended as we go; channels are collected and merged into the bitmaps once
+  m_pending.clear();
+  auto slice_it = m_slices.end();
+  for (std::size_t i = 0; i < n; ++i) {
+    const channel_t channel = m_channel_scratch[i];
+    if (channel == channel_map_t::s_invalid_channel) {
+      ++m_n_unmapped;
+      continue;
+    }
+    const uint64_t s = slice_of(m_header_scratch[i]->get_timestamp()); // NOLINT(build/unsigned)
+    if (slice_it == m_slices.end() || slice_it->first != s)
+      slice_it = m_slices.try_emplace(s).first;
+    Slice& slice = slice_it->second;
+
+    const uint64_t offset = m_bytes_indexed + m_offset_scratch[i]; // NOLINT(build/unsigned)
+    const std::size_t frame_size = sizeof(header_t) + tp_frame_nhits(m_header_scratch[i]) * sizeof(data_t);
+    if (!slice.runs.empty() && slice.runs.back().offset + slice.runs.back().size == offset)
+      slice.runs.back().size += frame_size;
+    else
+      slice.runs.push_back({ offset, frame_size });
+    ++slice.n_frames;
+    slice.n_hits += tp_frame_nhits(m_header_scratch[i]);
+    m_pending.emplace_back(s, channel);
+    ++m_n_frames;
+  }
+
+  std::sort(m_pending.begin(), m_pending.end());
+  std::vector<channel_t> channels;
+  for (std::size_t i = 0; i < m_pending.size();) {
+    const uint64_t s = m_pending[i].first; // NOLINT(build/unsigned)
+    channels.clear();
+    for (; i < m_pending.size() && m_pending[i].first == s; ++i)
+      channels.push_back(m_pending[i].second);
+    m_slices[s].channels |= ChannelBitmap::from_channels(channels);
+  }
+
+  m_bytes_indexed += consumed;
+  return consumed;
+}
+
+template<class Layout>
+const typename TpSliceIndex<Layout>::Slice*
+TpSliceIndex<Layout>::slice(uint64_t slice) const noexcept // NOLINT(build/unsigned)
+{
+  auto it = m_slices.find(slice);
+  return it == m_slices.end() ? nullptr : &it->second;
+}
+
+template<class Layout>
+bool
+TpSliceIndex<Layout>::slice_range(uint64_t t0, uint64_t t1, uint64_t& first, uint64_t& last) const noexcept // NOLINT
+{
+  if (t1 <= t0)
+    return false;
+  first = slice_of(t0);
+  last = slice_of(t1 - 1);
+  return true;
+}
+
+template<class Layout>
+ChannelBitmap
+TpSliceIndex<Layout>::active_in_any(uint64_t t0, uint64_t t1) const // NOLINT(build/unsigned)
+{
+  ChannelBitmap result;
+  uint64_t first, last; // NOLINT(build/unsigned)
+  if (!slice_range(t0, t1, first, last))
+    return result;
+  for (auto it = m_slices.lower_bound(first); it != m_slices.end() && it->first <= last; ++it)
+    result |= it->second.channels;
+  return result;
+}
+
+template<class Layout>
+ChannelBitmap
+TpSliceIndex<Layout>::active_in_all(uint64_t t0, uint64_t t1) const // NOLINT(build/unsigned)
+{
+  uint64_t first, last; // NOLINT(build/unsigned)
+  if (!slice_range(t0, t1, first, last))
+    return ChannelBitmap();
+  auto it = m_slices.find(first);
+  if (it == m_slices.end())
+    return ChannelBitmap();
+  ChannelBitmap result = it->second.channels;
+  for (uint64_t s = first + 1; s <= last && !result.empty(); ++s) { // NOLINT(build/unsigned)
+    ++it;
+    if (it == m_slices.end() || it->first != s)
+      return ChannelBitmap();
+    result &= it->second.channels;
+  }
+  return result;
+}
+
+template<class Layout>
+std::size_t
+TpSliceIndex<Layout>::find(uint64_t t0, // NOLINT(build/unsigned)
+                           uint64_t t1, // NOLINT(build/unsigned)
+                           channel_t first_channel,
+                           channel_t last_channel,
+                           std::vector<TpFrameRun>& out) const
+{
+  uint64_t first, last; // NOLINT(build/unsigned)
+  if (!slice_range(t0, t1, first, last) || last_channel <= first_channel)
+    return 0;
+  const ChannelBitmap region = ChannelBitmap::range(first_channel, last_channel);
+  std::size_t n_selected = 0;
+  for (auto it = m_slices.lower_bound(first); it != m_slices.end() && it->first <= last; ++it) {
+    if (!it->second.channels.intersects(region))
+      continue;
+    out.insert(out.end(), it->second.runs.begin(), it->second.runs.end());
+    ++n_selected;
+  }
+  return n_selected;
+}
+
+template<class Layout>
+template<class F>
+std::size_t
+TpSliceIndex<Layout>::for_each_frame(const void* stream,
+                                     uint64_t t0, // NOLINT(build/unsigned)
+                                     uint64_t t1, // NOLINT(build/unsigned)
+                                     channel_t first_channel,
+                                     channel_t last_channel,
+                                     F&& f) const
+{
+  std::vector<TpFrameRun> runs;
+  find(t0, t1, first_channel, last_channel, runs);
+  auto bytes = static_cast<const unsigned char*>(stream);
+  std::size_t n = 0;
+  for (auto const& run : runs) {
+    // Runs hold only complete frames, so the range walks all of them
+    for (auto const& frame : TpFrameRange<header_t, data_t>(bytes + run.offset, run.size)) {
+      const uint64_t t = frame.get_timestamp(); // NOLINT(build/unsigned)
+      if (t < t0 || t >= t1)
+        continue;
+      const channel_t channel = m_channel_map.lookup(*frame.header);
+      if (channel < first_channel || channel >= last_channel)
+        continue;
+      f(frame);
+      ++n;
+    }
+  }
+  return n;
+}
+
+template<class Layout>
+void
+TpSliceIndex<Layout>::erase_before(uint64_t timestamp) // NOLINT(build/unsigned)
+{
+  m_slices.erase(m_slices.begin(), m_slices.lower_bound(slice_of(timestamp)));
+}
+
+template<class Layout>
+std::size_t
+TpSliceIndex<Layout>::memory_bytes() const noexcept
+{
+  std::size_t n = 0;
+  for (auto const& [s, slice] : m_slices)
+    n += sizeof(s) + sizeof(slice) + slice.channels.memory_bytes() + slice.runs.capacity() * sizeof(TpFrameRun);
+  return n;
+}
+
+} // namespace dunedaq::detdataformats
@@ -0,0 +1,138 @@
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace dunedaq::detdataformats {
+
+static_assert(sizeof(StitchedHit) == 40, "StitchedHit struct size different than expected!");
+
+template<class Layout>
+TpStitcher<Layout>::TpStitcher(const channel_map_t& channel_map)
+  : m_channel_map(channel_map)
+{
+  if (!channel_map.is_compiled())
+    throw std::invalid_argument("TpStitcher: the channel map must be compiled");
+
+  const std::size_t n_channels =
+    channel_map.max_channel() == channel_map_t::s_invalid_channel ? 0 : std::size_t(channel_map.max_channel()) + 1;
+  m_partial.resize(n_channels);
+  m_active_slot.assign(n_channels, s_not_active);
+  m_active.reserve(n_channels);
+}
+
+template<class Layout>
+void
+TpStitcher<Layout>::deactivate(uint32_t channel) noexcept // NOLINT(build/unsigned)
+{
+  // Swap-remove from the active list
+  const uint32_t slot = m_active_slot[channel]; // NOLINT(build/unsigned)
+  const uint32_t last = m_active.back();        // NOLINT(build/unsigned)
+  m_active[slot] = last;
+  m_active_slot[last] = slot;
+  m_active.pop_back();
+  m_active_slot[channel] = s_not_active;
+}
+
+template<class Layout>
+template<class Emit>
+void
+TpStitcher<Layout>::process_frame(const frame_t& frame, Emit&& emit)
+{
+  const uint32_t channel = m_channel_map.lookup(*frame.header); // NOLINT(build/unsigned)
+  if (channel == channel_map_t::s_invalid_channel) {
+    ++m_n_unmapped_frames;
+    return;
+  }
+
+  const uint64_t t0 = frame.header->get_timestamp(); // NOLINT(build/unsigned)
+  StitchedHit& hit = m_partial[channel];
+
+  for (std::size_t i = 0; i < frame.nhits; ++i) {
+    const data_t& d = frame.hits[i];
+
+    if (m_active_slot[channel] == s_not_active) {
+      hit.start_time = t0 + d.m_start_time;
+      hit.end_time = t0 + d.m_end_time;
+      hit.peak_time = t0 + d.m_peak_time;
+      hit.channel = channel;
+      hit.sum_adc = d.m_sum_adc;
+      hit.peak_adc = d.m_peak_adc;
+      hit.tp_flags = d.m_tp_flags;
+      hit.n_fragments = 1;
+      hit.complete = true;
+    } else {
+      hit.end_time = t0 + d.m_end_time;
+      hit.sum_adc += d.m_sum_adc;
+      if (d.m_peak_adc > hit.peak_adc) {
+        hit.peak_adc = d.m_peak_adc;
+        hit.peak_time = t0 + d.m_peak_time;
+      }
+      hit.tp_flags |= d.m_tp_flags;
+      ++hit.n_fragments;
+    }
+
+    if (d.m_hit_continue) {
+      if (m_active_slot[channel] == s_not_active) {
+        m_active_slot[channel] = m_active.size();
+        m_active.push_back(channel);
+      }
+    } else {
+      if (m_active_slot[channel] != s_not_active)
+        deactivate(channel);
+      emit(static_cast<const StitchedHit&>(hit));
+    }
+  }
+}
+
+template<class Layout>
+std::size_t
+TpStitcher<Layout>::process(const void* buffer, std::size_t size, std::vector<StitchedHit>& out)
+{
+  TpFrameRange<header_t, data_t> frames(buffer, size);
+  auto it = frames.begin();
+  const unsigned char* last_end = static_cast<const unsigned char*>(buffer);
+  for (; it != frames.end(); ++it) {
+    process_frame(*it, [&out](const StitchedHit& hit) { out.push_back(hit); });
+    last_end = it.position() + it->size();
+  }
+  return last_end - static_cast<const unsigned char*>(buffer);
+}
+
+template<class Layout>
+template<class Emit>
+std::size_t
+TpStitcher<Layout>::flush_stale(uint64_t timestamp, Emit&& emit) // NOLINT(build/unsigned)
+{
+  std::size_t n_flushed = 0;
+  for (std::size_t i = 0; i < m_active.size();) {
+    const uint32_t channel = m_active[i]; // NOLINT(build/unsigned)
+    StitchedHit& hit = m_partial[channel];
+    if (hit.end_time < timestamp) {
+      hit.complete = false;
+      deactivate(channel); // moves the last active channel into slot i
+      emit(static_cast<const StitchedHit&>(hit));
+      ++n_flushed;
+    } else {
+      ++i;
+    }
+  }
+  m_n_stale_flushed += n_flushed;
+  return n_flushed;
+}
+
+template<class Layout>
+template<class Emit>
+std::size_t
+TpStitcher<Layout>::flush_all(Emit&& emit)
+{
+  const std::size_t n_flushed = m_active.size();
+  for (auto channel : m_active) {
+    m_partial[channel].complete = false;
+    m_active_slot[channel] = s_not_active;
+    emit(static_cast<const StitchedHit&>(m_partial[channel]));
+  }
+  m_active.clear();
+  return n_flushed;
+}
+
+} // namespace dunedaq::detdataformats
@@ -8,6 +8,8 @@
 
 #include "detdataformats/DAQEthHeader.hpp"
 
+#include "headerarray.hpp"
+
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -20,7 +22,9 @@ namespace dunedaq::detdataformats::python {
 
 void register_daqethheader(py::module& m) {
 
-  py::class_<DAQEthHeader>(m, "DAQEthHeader", py::buffer_protocol())
+  py::class_<DAQEthHeader> py_header(m, "DAQEthHeader", py::buffer_protocol());
+
+  py_header
     .def_property("version", 
       [](DAQEthHeader& self) -> uint32_t { return self.version; }, 
       [](DAQEthHeader& self, uint32_t version) { self.version = version; } 
@@ -59,6 +63,9 @@ void register_daqethheader(py::module& m) {
       )
      .def("get_timestamp", &DAQEthHeader::get_timestamp)
     ;
+
+  def_header_buffer(py_header);
+  register_header_array<DAQEthHeader>(m, "DAQEthHeaderArray", "stream_id");
 }
 
 }  // namespace dunedaq::detdataformats::python
@@ -8,6 +8,8 @@
 
 #include "detdataformats/DAQHeader.hpp"
 
+#include "headerarray.hpp"
+
 #include <pybind11/operators.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
@@ -20,7 +22,9 @@ namespace dunedaq::detdataformats::python {
 
 void register_daqheader(py::module& m) {
 
-  py::class_<DAQHeader>(m, "DAQHeader", py::buffer_protocol())
+  py::class_<DAQHeader> py_header(m, "DAQHeader", py::buffer_protocol());
+
+  py_header
     .def_property("version", 
       [](DAQHeader& self) -> uint32_t { return self.version; }, 
       [](DAQHeader& self, uint32_t version) { self.version = version; } 
@@ -43,6 +47,9 @@ void register_daqheader(py::module& m) {
       )
     .def("get_timestamp", &DAQHeader::get_timestamp)
     ;
+
+  def_header_buffer(py_header);
+  register_header_array<DAQHeader>(m, "DAQHeaderArray", "link_id");
 }
 
 }  // namespace dunedaq::detdataformats::python
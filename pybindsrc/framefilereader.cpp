@@ -0,0 +1,102 @@
+/**
+ * @file framefilereader.cpp
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/FrameFileReader.hpp"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <memory>
+#include <string>
+
+namespace py = pybind11;
+
+namespace dunedaq::detdataformats::python {
+
+namespace {
+
+// The numpy arrays keep the chunk alive through a capsule, so no data is copied
+// and the chunk memory is released when the last array referencing it goes away
+py::capsule
+chunk_owner(const std::shared_ptr<FrameChunk>& chunk)
+{
+  return py::capsule(new std::shared_ptr<FrameChunk>(chunk),
+                     [](void* p) { delete static_cast<std::shared_ptr<FrameChunk>*>(p); });
+}
+
+} // namespace
+
+void
+register_framefilereader(py::module& m)
+{
+  py::class_<FrameChunk, std::shared_ptr<FrameChunk>>(m, "FrameChunk")
+    .def_readonly("n_frames", &FrameChunk::n_frames)
+    .def_readonly("size", &FrameChunk::size)
+    .def_readonly("file_offset", &FrameChunk::file_offset)
+    .def("data",
+         [](const std::shared_ptr<FrameChunk>& self, size_t frame_size) {
+           if (frame_size == 0 || self->size % frame_size != 0)
+             return py::array_t<uint8_t>({ self->size }, { 1 }, self->data.get(), chunk_owner(self));
+           return py::array_t<uint8_t>({ self->size / frame_size, frame_size },
+                                       { frame_size, size_t(1) },
+                                       self->data.get(),
+                                       chunk_owner(self));
+         },
+         py::arg("frame_size") = 0,
+         "Zero-copy uint8 view of the chunk, shaped (n_frames, frame_size) when frame_size is given")
+    .def("frame_offsets",
+         [](const std::shared_ptr<FrameChunk>& self) {
+           return py::array_t<uint64_t>(
+             { self->frame_offsets.size() }, { sizeof(uint64_t) }, self->frame_offsets.data(), chunk_owner(self));
+         })
+    .def("frame", [](const std::shared_ptr<FrameChunk>& self, size_t i) {
+      if (i >= self->n_frames)
+        throw py::index_error("frame index out of range");
+      if (self->frame_offsets.empty()) {
+        const size_t frame_size = self->size / self->n_frames;
+        return py::bytes(reinterpret_cast<const char*>(self->data.get() + i * frame_size), frame_size);
+      }
+      const size_t begin = self->frame_offsets[i];
+      const size_t end = i + 1 < self->n_frames ? self->frame_offsets[i + 1] : self->size;
+      return py::bytes(reinterpret_cast<const char*>(self->data.get() + begin), end - begin);
+    });
+
+  py::class_<FrameFileReader> py_reader(m, "FrameFileReader");
+
+  py::enum_<FrameFileReader::FrameKind>(py_reader, "FrameKind")
+    .value("kFixedSize", FrameFileReader::FrameKind::kFixedSize)
+    .value("kRawTp", FrameFileReader::FrameKind::kRawTp)
+    .export_values();
+
+  py_reader
+    .def(py::init<const std::string&, FrameFileReader::FrameKind, size_t, size_t, size_t>(),
+         py::arg("path"),
+         py::arg("kind"),
+         py::arg("chunk_bytes") = 64 << 20,
+         py::arg("frame_size") = 0,
+         py::arg("prefetch_depth") = 2)
+    .def("next", &FrameFileReader::next, py::call_guard<py::gil_scoped_release>())
+    .def("__iter__", [](FrameFileReader& self) -> FrameFileReader& { return self; })
+    .def("__next__",
+         [](FrameFileReader& self) {
+           std::shared_ptr<FrameChunk> chunk;
+           {
+             py::gil_scoped_release release;
+             chunk = self.next();
+           }
+           if (!chunk)
+             throw py::stop_iteration();
+           return chunk;
+         })
+    .def_property_readonly("frame_size", &FrameFileReader::frame_size)
+    .def_property_readonly("chunk_bytes", &FrameFileReader::chunk_bytes)
+    .def_property_readonly("file_size", &FrameFileReader::file_size);
+}
+
+} // namespace dunedaq::detdataformats::python
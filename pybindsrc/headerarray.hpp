@@ -0,0 +1,211 @@
+/**
+ * @file headerarray.hpp
+ *
+ * Buffer protocol support for the DAQHeader/DAQEthHeader bindings, and zero-copy
+ * header arrays with numpy column extraction and selection
+ *
+ * This is part of the DUNE DAQ Software Suite, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#ifndef DETDATAFORMATS_PYBINDSRC_HEADERARRAY_HPP_
+#define DETDATAFORMATS_PYBINDSRC_HEADERARRAY_HPP_
+
+#include "detdataformats/HeaderArrayView.hpp"
+
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace dunedaq::detdataformats::python {
+
+namespace py = pybind11;
+
+inline bool
+is_c_contiguous(const py::buffer_info& info)
+{
+  py::ssize_t expected = info.itemsize;
+  for (py::ssize_t d = info.ndim; d-- > 0;) {
+    if (info.shape[d] != 1 && info.strides[d] != expected)
+      return false;
+    expected *= info.shape[d];
+  }
+  return true;
+}
+
+/**
+ * @brief Default and from-bytes constructors, and a writable buffer over the header words, so
+ * that numpy.frombuffer(header, ...) and bytes(header) need no field-by-field copy.
+ */
+template<class Header>
+void
+def_header_buffer(py::class_<Header>& cls)
+{
+  using word_t = typename Header::word_t;
+
+  cls.def(py::init([]() { return Header{}; }))
+    .def(py::init([](const py::buffer& data) {
+           const py::buffer_info info = data.request();
+           if (!is_c_contiguous(info) || std::size_t(info.size * info.itemsize) != sizeof(Header))
+             throw py::value_error("expected " + std::to_string(sizeof(Header)) + " contiguous bytes");
+           Header h;
+           std::memcpy(&h, info.ptr, sizeof(h));
+           return h;
+         }),
+         py::arg("data"))
+    .def_buffer([](Header& self) {
+      return py::buffer_info(&self,
+                             sizeof(word_t),
+                             py::format_descriptor<word_t>::format(),
+                             1,
+                             { sizeof(Header) / sizeof(word_t) },
+                             { sizeof(word_t) });
+    })
+    .def("__bytes__",
+         [](const Header& self) { return py::bytes(reinterpret_cast<const char*>(&self), sizeof(self)); });
+}
+
+/**
+ * @brief Headers laid out in a Python buffer (bytes, bytearray, numpy array, FrameChunk.data()),
+ * viewed in place. The buffer stays exported, and so alive and unresizable, for the lifetime of
+ * the array.
+ */
+template<class Header>
+class HeaderArray
+{
+public:
+  HeaderArray(const py::buffer& data, std::size_t stride)
+    : m_info(data.request())
+    , m_view(make_view(m_info, stride))
+  {
+  }
+
+  const HeaderArrayView<Header>& view() const noexcept { return m_view; }
+
+private:
+  static HeaderArrayView<Header> make_view(const py::buffer_info& info, std::size_t stride)
+  {
+    if (!is_c_contiguous(info))
+      throw py::value_error("header buffer must be C-contiguous");
+    const std::size_t bytes = info.size * info.itemsize;
+    const std::size_t s = stride == 0 ? sizeof(Header) : stride;
+    if (s < sizeof(Header) || bytes % s != 0)
+      throw py::value_error("buffer of " + std::to_string(bytes) + " bytes is not a whole number of " +
+                            std::to_string(s) + "-byte records");
+    return HeaderArrayView<Header>(info.ptr, bytes / s, s);
+  }
+
+  py::buffer_info m_info;
+  HeaderArrayView<Header> m_view;
+};
+
+template<class Header, class T>
+py::array_t<T>
+header_column(const HeaderArray<Header>& self, HeaderField field)
+{
+  py::array_t<T> out(static_cast<py::ssize_t>(self.view().size()));
+  T* p = out.mutable_data();
+  {
+    py::gil_scoped_release release;
+    self.view().column(field, p);
+  }
+  return out;
+}
+
+/**
+ * @brief Register HeaderArray<Header> as @p name. @p link_name is the keyword that selects on
+ * HeaderField::kLinkId (link_id or stream_id).
+ */
+template<class Header>
+void
+register_header_array(py::module& m, const char* name, const char* link_name)
+{
+  using header_array_t = HeaderArray<Header>;
+
+  py::class_<header_array_t> cls(m, name, py::buffer_protocol());
+  cls
+    .def(py::init<const py::buffer&, std::size_t>(),
+         py::arg("data"),
+         py::arg("stride") = 0,
+         "Zero-copy view of the headers in data, one every stride bytes (default: packed headers)")
+    .def_buffer([](header_array_t& self) {
+      const auto& view = self.view();
+      return py::buffer_info(const_cast<unsigned char*>(view.data()), // NOLINT
+                             1,
+                             py::format_descriptor<uint8_t>::format(),
+                             2,
+                             { py::ssize_t(view.size()), py::ssize_t(sizeof(Header)) },
+                             { py::ssize_t(view.stride()), py::ssize_t(1) },
+                             true);
+    })
+    .def("__len__", [](const header_array_t& self) { return self.view().size(); })
+    .def("__getitem__",
+         [](const header_array_t& self, py::ssize_t i) {
+           const auto n = py::ssize_t(self.view().size());
+           if (i < 0)
+             i += n;
+           if (i < 0 || i >= n)
+             throw py::index_error("header index out of range");
+           return self.view()[i];
+         })
+    .def_property_readonly("stride", [](const header_array_t& self) { return self.view().stride(); })
+    .def("versions", [](const header_array_t& self) { return header_column<Header, uint8_t>(self, HeaderField::kVersion); })
+    .def("det_ids", [](const header_array_t& self) { return header_column<Header, uint8_t>(self, HeaderField::kDetId); })
+    .def("crate_ids", [](const header_array_t& self) { return header_column<Header, uint16_t>(self, HeaderField::kCrateId); })
+    .def("slot_ids", [](const header_array_t& self) { return header_column<Header, uint8_t>(self, HeaderField::kSlotId); })
+    .def((std::string(link_name) + "s").c_str(),
+         [](const header_array_t& self) { return header_column<Header, uint8_t>(self, HeaderField::kLinkId); })
+    .def("timestamps",
+         [](const header_array_t& self) { return header_column<Header, uint64_t>(self, HeaderField::kTimestamp); })
+    .def(
+      "select",
+      [](const header_array_t& self,
+         std::optional<uint32_t> det_id,
+         std::optional<uint32_t> crate_id,
+         std::optional<uint32_t> slot_id,
+         std::optional<uint32_t> link_id,
+         std::optional<uint64_t> t0,
+         std::optional<uint64_t> t1) {
+        HeaderSelection selection;
+        selection.det_id = det_id.value_or(HeaderSelection::s_any);
+        selection.crate_id = crate_id.value_or(HeaderSelection::s_any);
+        selection.slot_id = slot_id.value_or(HeaderSelection::s_any);
+        selection.link_id = link_id.value_or(HeaderSelection::s_any);
+        selection.t0 = t0.value_or(selection.t0);
+        selection.t1 = t1.value_or(selection.t1);
+
+        auto indices = std::make_unique<std::vector<uint64_t>>();
+        {
+          py::gil_scoped_release release;
+          *indices = self.view().select(selection);
+        }
+        auto* p = indices.get();
+        py::capsule owner(indices.release(), [](void* v) { delete static_cast<std::vector<uint64_t>*>(v); });
+        return py::array_t<uint64_t>({ p->size() }, { sizeof(uint64_t) }, p->data(), owner);
+      },
+      py::arg("det_id") = py::none(),
+      py::arg("crate_id") = py::none(),
+      py::arg("slot_id") = py::none(),
+      py::arg(link_name) = py::none(),
+      py::arg("t0") = py::none(),
+      py::arg("t1") = py::none(),
+      "Indices of the headers matching every given field, with a timestamp in [t0, t1)");
+
+  if constexpr (std::is_same_v<Header, DAQEthHeader>) {
+    cls.def("seq_ids", [](const header_array_t& self) { return header_column<Header, uint16_t>(self, HeaderField::kSeqId); })
+      .def("block_lengths",
+           [](const header_array_t& self) { return header_column<Header, uint16_t>(self, HeaderField::kBlockLength); });
+  }
+}
+
+} // namespace dunedaq::detdataformats::python
+
+#endif // DETDATAFORMATS_PYBINDSRC_HEADERARRAY_HPP_
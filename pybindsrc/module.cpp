@@ -23,6 +23,7 @@ PYBIND11_MODULE(_daq_detdataformats_py, m) {
     register_daqheader(m);
     register_daqethheader(m);
     register_hsi(m);
+    register_framefilereader(m);
 
 }
 
@@ -20,6 +20,7 @@ namespace dunedaq::detdataformats::python {
   void register_daqheader(pybind11::module&);
   void register_daqethheader(pybind11::module&);
   void register_hsi(pybind11::module&);
+  void register_framefilereader(pybind11::module&);
 }
 
 #endif // DETDATAFORMATS_PYBINDSRC_REGISTRATORS_HPP_
@@ -0,0 +1,135 @@
+/**
+ * @file compact_tp_benchmark.cxx Memory and scan cost of CompactTp against raw TP frames
+ *
+ * Fills a latency buffer of single-hit fwtp frames from many links, packs it
+ * into CompactTp records and compares the footprint of both forms and the
+ * time taken to answer trigger-window queries (hits on a channel range in a
+ * time window) by scanning each of them. Also reports pack and unpack rates.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/CompactTp.hpp"
+#include "detdataformats/SyntheticGenerator.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+struct QueryResult
+{
+  uint64_t n_hits{ 0 };  // NOLINT(build/unsigned)
+  uint64_t sum_adc{ 0 }; // NOLINT(build/unsigned)
+
+  bool operator==(const QueryResult& o) const { return n_hits == o.n_hits && sum_adc == o.sum_adc; }
+};
+
+double
+seconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  const std::size_t n_frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 4000000;
+  const unsigned n_links = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+  const unsigned n_queries = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 20;
+
+  // Links are (crate 0, slot link / 64, fiber link % 64), 256 wires each
+  FwtpChannelMap map;
+  std::vector<SyntheticGenerator> generators;
+  for (unsigned l = 0; l < n_links; ++l) {
+    for (unsigned wire = 0; wire < 256; ++wire)
+      map.add(0, l / 64, l % 64, wire, l * 256 + wire);
+    SyntheticConfig config;
+    config.format = SyntheticFormat::kFwtp;
+    config.slot = l / 64;
+    config.link = l % 64;
+    config.start_timestamp = 1ull << 56;
+    generators.emplace_back(config);
+  }
+  map.compile();
+
+  // Round-robin small chunks so the buffer is roughly time ordered, as a latency buffer would be
+  const std::size_t frame_size = sizeof(fwtp::TpHeader) + sizeof(fwtp::TpData);
+  std::vector<unsigned char> raw(n_frames * frame_size);
+  std::size_t used = 0;
+  for (std::size_t l = 0; used + 64 * frame_size <= raw.size(); l = (l + 1) % n_links)
+    used += generators[l].generate(raw.data() + used, 64 * frame_size);
+  raw.resize(used);
+
+  FwtpCompactTpCodec codec(map);
+  std::vector<CompactTp> compact;
+  auto start = std::chrono::steady_clock::now();
+  codec.pack(raw.data(), raw.size(), compact);
+  const double pack_seconds = seconds_since(start);
+  const std::size_t n_hits = compact.size();
+
+  std::vector<unsigned char> unpacked(n_hits * FwtpCompactTpCodec::s_unpacked_size);
+  start = std::chrono::steady_clock::now();
+  codec.unpack(compact.data(), n_hits, unpacked.data(), unpacked.size());
+  const double unpack_seconds = seconds_since(start);
+
+  const uint64_t t_first = compact.front().timestamp; // NOLINT(build/unsigned)
+  const uint64_t t_last = compact.back().timestamp;   // NOLINT(build/unsigned)
+  std::mt19937_64 rng(3);
+  double raw_seconds = 0, compact_seconds = 0;
+  bool ok = true;
+  for (unsigned q = 0; q < n_queries; ++q) {
+    const uint64_t t0 = t_first + rng() % (t_last - t_first + 1); // NOLINT(build/unsigned)
+    const uint64_t t1 = t0 + 62500;                               // 1 ms window // NOLINT(build/unsigned)
+    const uint32_t c0 = rng() % (n_links * 256);                  // NOLINT(build/unsigned)
+    const uint32_t c1 = c0 + 2560;                                // NOLINT(build/unsigned)
+
+    QueryResult from_raw, from_compact;
+    start = std::chrono::steady_clock::now();
+    for (auto const& frame : FwtpFrameRange(raw.data(), raw.size())) {
+      const uint32_t channel = map.lookup(*frame.header); // NOLINT(build/unsigned)
+      const uint64_t t0_frame = frame.get_timestamp();    // NOLINT(build/unsigned)
+      for (std::size_t h = 0; h < frame.nhits; ++h) {
+        const uint64_t t = t0_frame + frame.hits[h].m_start_time; // NOLINT(build/unsigned)
+        if (t >= t0 && t < t1 && channel >= c0 && channel < c1) {
+          ++from_raw.n_hits;
+          from_raw.sum_adc += frame.hits[h].m_sum_adc;
+        }
+      }
+    }
+    raw_seconds += seconds_since(start);
+
+    start = std::chrono::steady_clock::now();
+    for (auto const& tp : compact) {
+      const bool match = tp.timestamp >= t0 && tp.timestamp < t1 && tp.channel >= c0 && tp.channel < c1;
+      from_compact.n_hits += match;
+      from_compact.sum_adc += match ? tp.sum_adc : 0;
+    }
+    compact_seconds += seconds_since(start);
+    ok = ok && from_raw == from_compact;
+  }
+
+  std::cout << "Hits:          " << n_hits << " on " << n_links * 256 << " channels\n"
+            << "Memory:        raw " << raw.size() / 1e6 << " MB, compact " << n_hits * sizeof(CompactTp) / 1e6
+            << " MB (" << double(raw.size()) / (n_hits * sizeof(CompactTp)) << "x smaller)\n"
+            << "Pack:          " << n_hits / pack_seconds / 1e6 << " Mhits/s, " << raw.size() / pack_seconds / 1e9
+            << " GB/s of raw frames\n"
+            << "Unpack:        " << n_hits / unpack_seconds / 1e6 << " Mhits/s\n"
+            << "Window scan:   raw " << raw_seconds / n_queries / n_hits * 1e9 << " ns/hit, compact "
+            << compact_seconds / n_queries / n_hits * 1e9 << " ns/hit (" << raw_seconds / compact_seconds
+            << "x faster)\n"
+            << "Saturated:     " << codec.counters().n_saturated << '\n';
+  if (!ok)
+    std::cerr << "Raw and compact query results differ\n";
+  return ok ? 0 : 1;
+}
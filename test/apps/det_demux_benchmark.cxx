@@ -0,0 +1,120 @@
+/**
+ * @file det_demux_benchmark.cxx Routing of mixed DAQEthHeader blocks by det_id
+ *
+ * Builds a buffer of DAQEthHeader blocks from several subdetectors, with
+ * per-subdetector block sizes and a small fraction of unknown det_ids, and
+ * compares a sequential switch pushing block references into per-subdetector
+ * vectors with DetIdDemux at increasing thread counts. With a third argument
+ * every block is padded to that many bytes and DetIdDemux is told the size, so
+ * it can skip the sequential walk over block lengths.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/DetIdDemux.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+double
+seconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  const std::size_t n_blocks = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000000;
+  const unsigned max_threads = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : std::thread::hardware_concurrency();
+  const std::size_t fixed_size = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 0;
+  const unsigned n_rounds = 5;
+
+  // (det_id, payload words): HD_TPC, HD_PDS, HD_CRT, VD_BottomTPC, and an unassigned det_id
+  const std::vector<std::pair<unsigned, unsigned>> sources = { { 3, 56 }, { 2, 24 }, { 4, 8 }, { 10, 56 }, { 50, 4 } };
+  const std::vector<double> weights = { 60, 15, 5, 19.9, 0.1 };
+
+  std::mt19937_64 rng(42);
+  std::discrete_distribution<unsigned> pick(weights.begin(), weights.end());
+  std::vector<unsigned char> buffer;
+  buffer.reserve(n_blocks * (sizeof(DAQEthHeader) + 8 * 56));
+  for (std::size_t i = 0; i < n_blocks; ++i) {
+    const auto& source = sources[pick(rng)];
+    DAQEthHeader h;
+    std::memset(static_cast<void*>(&h), 0, sizeof(h));
+    h.version = 1;
+    h.det_id = source.first;
+    h.block_length = fixed_size > sizeof(h) ? (fixed_size - sizeof(h)) / 8 : source.second;
+    h.timestamp = i;
+    const std::size_t offset = buffer.size();
+    buffer.resize(offset + sizeof(h) + 8 * h.block_length);
+    std::memcpy(buffer.data() + offset, &h, sizeof(h));
+  }
+  std::cout << "Buffer: " << n_blocks << " blocks, " << buffer.size() / 1e6 << " MB\n";
+
+  // Reference: one pass routing each block through a switch
+  std::vector<std::vector<BlockRef>> outputs(5);
+  double best = 1e9;
+  for (unsigned r = 0; r < n_rounds; ++r) {
+    for (auto& o : outputs)
+      o.clear();
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t offset = 0; offset + sizeof(DAQEthHeader) <= buffer.size();) {
+      DAQEthHeader h;
+      std::memcpy(&h, buffer.data() + offset, sizeof(h));
+      const BlockRef block{ offset, sizeof(h) + 8 * h.block_length };
+      switch (static_cast<DetID::Subdetector>(h.det_id)) {
+        case DetID::Subdetector::kHD_TPC:
+          outputs[0].push_back(block);
+          break;
+        case DetID::Subdetector::kHD_PDS:
+          outputs[1].push_back(block);
+          break;
+        case DetID::Subdetector::kHD_CRT:
+          outputs[2].push_back(block);
+          break;
+        case DetID::Subdetector::kVD_BottomTPC:
+          outputs[3].push_back(block);
+          break;
+        default:
+          outputs[4].push_back(block);
+      }
+      offset += block.size;
+    }
+    best = std::min(best, seconds_since(start));
+  }
+  std::cout << "switch:            " << n_blocks / best / 1e6 << " Mblocks/s\n";
+
+  DetIdDemux<DAQEthHeader>::Config config;
+  config.block_size = fixed_size > sizeof(DAQEthHeader) ? sizeof(DAQEthHeader) + (fixed_size - sizeof(DAQEthHeader)) / 8 * 8 : 0;
+  DAQEthHeaderDemux demux(config);
+  for (unsigned n_threads = 1; n_threads <= std::max(max_threads, 1u); n_threads *= 2) {
+    best = 1e9;
+    for (unsigned r = 0; r < n_rounds; ++r) {
+      const auto start = std::chrono::steady_clock::now();
+      demux.demux(buffer.data(), buffer.size(), n_threads);
+      best = std::min(best, seconds_since(start));
+    }
+    if (demux.output(DetID::Subdetector::kHD_TPC).size() != outputs[0].size() ||
+        demux.quarantine().size() != outputs[4].size()) {
+      std::cerr << "DetIdDemux and the switch disagree\n";
+      return 1;
+    }
+    std::cout << "DetIdDemux " << n_threads << " thr:  " << n_blocks / best / 1e6 << " Mblocks/s\n";
+  }
+  return 0;
+}
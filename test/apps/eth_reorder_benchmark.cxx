@@ -0,0 +1,109 @@
+/**
+ * @file eth_reorder_benchmark.cxx Throughput of EthReorderBuffer under controlled reordering
+ *
+ * Interleaves packets from several streams, displaces a fraction of them by up
+ * to a maximum distance and drops a few, then checks that EthReorderBuffer
+ * releases each stream in seq_id order and measures the cost per packet.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/EthReorderBuffer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <utility>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+int
+main(int argc, char* argv[])
+{
+  const std::size_t n_packets = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+  const std::size_t n_streams = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 64;
+  const double reorder_fraction = argc > 3 ? std::strtod(argv[3], nullptr) : 0.05;
+  const std::size_t max_displacement = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 16;
+  const double drop_fraction = argc > 5 ? std::strtod(argv[5], nullptr) : 0.0001;
+
+  std::mt19937_64 rng(42);
+  std::vector<DAQEthHeader> packets(n_packets);
+  for (std::size_t i = 0; i < n_packets; ++i) {
+    auto& p = packets[i];
+    p = DAQEthHeader{};
+    const std::size_t stream = i % n_streams;
+    p.crate_id = stream / 64;
+    p.slot_id = (stream / 16) % 4;
+    p.stream_id = stream % 16;
+    p.seq_id = (i / n_streams) % EthReorderBuffer::s_seq_id_modulo;
+    p.timestamp = i;
+  }
+
+  // Arrival order: swap a fraction of the packets with one up to max_displacement positions later
+  std::vector<const DAQEthHeader*> arrival;
+  arrival.reserve(n_packets);
+  for (auto const& p : packets)
+    arrival.push_back(&p);
+  std::uniform_real_distribution<double> uniform(0., 1.);
+  std::uniform_int_distribution<std::size_t> displacement(1, max_displacement * n_streams);
+  std::size_t n_dropped = 0;
+  for (std::size_t i = 0; i < n_packets; ++i) {
+    if (uniform(rng) < reorder_fraction)
+      std::swap(arrival[i], arrival[std::min(n_packets - 1, i + displacement(rng))]);
+  }
+  std::vector<const DAQEthHeader*> input;
+  input.reserve(n_packets);
+  for (auto p : arrival) {
+    if (uniform(rng) < drop_fraction)
+      ++n_dropped;
+    else
+      input.push_back(p);
+  }
+
+  EthReorderBuffer::Config config;
+  config.window_size = 64;
+  config.timeout = 4 * max_displacement * n_streams; // in units of packet arrivals
+  EthReorderBuffer buffer(config);
+
+  std::vector<int> last_seq_id(n_streams, -1);
+  std::size_t n_out_of_order = 0;
+  std::size_t n_released = 0;
+  auto emit = [&](const DAQEthHeader* p) {
+    const std::size_t stream = p->crate_id * 64 + p->slot_id * 16 + p->stream_id;
+    const int expected = (last_seq_id[stream] + 1) % int(EthReorderBuffer::s_seq_id_modulo);
+    if (last_seq_id[stream] >= 0 && int(p->seq_id) != expected) {
+      // Gaps are allowed (drops), going backwards is not
+      const int delta = (int(p->seq_id) - last_seq_id[stream] + 4096) % 4096;
+      if (delta == 0 || delta >= 2048)
+        ++n_out_of_order;
+    }
+    last_seq_id[stream] = p->seq_id;
+    ++n_released;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (std::size_t i = 0; i < input.size(); ++i) {
+    buffer.push(input[i], i, emit);
+    if ((i & 1023) == 0)
+      buffer.expire(i, emit);
+  }
+  buffer.flush(emit);
+  auto stop = std::chrono::steady_clock::now();
+
+  const double elapsed = std::chrono::duration<double>(stop - start).count();
+  auto const& c = buffer.counters();
+  std::cout << "Packets:            " << input.size() << " over " << n_streams << " streams (" << n_dropped
+            << " dropped)\n"
+            << "Reordered:          " << c.n_reordered << '\n'
+            << "Lost / late / dup:  " << c.n_lost << " / " << c.n_late << " / " << c.n_duplicates << '\n'
+            << "Released:           " << n_released << " (" << n_out_of_order << " out of order)\n"
+            << "Elapsed:            " << elapsed << " s\n"
+            << "Throughput:         " << input.size() / elapsed / 1e6 << " Mpackets/s, "
+            << elapsed / input.size() * 1e9 << " ns/packet\n";
+  return n_out_of_order == 0 ? 0 : 1;
+}
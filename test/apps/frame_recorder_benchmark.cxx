@@ -0,0 +1,122 @@
+/**
+ * @file frame_recorder_benchmark.cxx Sustained write bandwidth of FrameRecorder
+ *
+ * Records spans of DAQEthHeader frames from a pre-generated pool to a file,
+ * once with O_DIRECT and once through the page cache, and compares them with
+ * a plain std::ofstream. Reports bandwidth, time the producer spent blocked on
+ * full buffers and the distribution of per-batch write latencies.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/FrameRecorder.hpp"
+#include "detdataformats/SyntheticGenerator.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+uint64_t // NOLINT(build/unsigned)
+file_size(const std::string& path)
+{
+  struct stat st;
+  return ::stat(path.c_str(), &st) == 0 ? st.st_size : 0;
+}
+
+double
+latency_quantile(const FrameRecorder::Stats& stats, double q)
+{
+  // Upper edge of the histogram bin holding the quantile, in seconds
+  uint64_t seen = 0; // NOLINT(build/unsigned)
+  for (std::size_t i = 0; i < stats.latency_histogram.size(); ++i) {
+    seen += stats.latency_histogram[i];
+    if (seen >= q * stats.batches)
+      return std::min((2ull << i) * 1e-6, stats.max_latency);
+  }
+  return stats.max_latency;
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  const double gigabytes = argc > 1 ? std::strtod(argv[1], nullptr) : 4;
+  const std::string path = argc > 2 ? argv[2] : "frame_recorder_benchmark.bin";
+  const std::size_t buffer_mib = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 4;
+  const std::size_t n_buffers = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 4;
+  const std::size_t span_frames = argc > 5 ? std::strtoul(argv[5], nullptr, 10) : 64;
+
+  SyntheticConfig gen_config;
+  gen_config.format = SyntheticFormat::kDAQEthHeader;
+  SyntheticGenerator generator(gen_config);
+  std::vector<unsigned char> pool(64 << 20);
+  pool.resize(generator.generate(pool.data(), pool.size()));
+  const std::size_t frame_size = sizeof(DAQEthHeader) + gen_config.payload_bytes;
+  const std::size_t span_bytes = span_frames * frame_size;
+  const std::size_t n_spans = static_cast<std::size_t>(gigabytes * 1e9 / span_bytes);
+  const uint64_t total = static_cast<uint64_t>(n_spans) * span_bytes; // NOLINT(build/unsigned)
+  const std::size_t spans_in_pool = pool.size() / span_bytes;
+  if (spans_in_pool == 0) {
+    std::cerr << "Span of " << span_bytes << " bytes is larger than the frame pool\n";
+    return 1;
+  }
+
+  std::cout << "Writing " << total / 1e9 << " GB as " << n_spans << " spans of " << span_frames << " "
+            << frame_size << "-byte frames to " << path << '\n';
+
+  bool ok = true;
+  for (bool direct : { true, false }) {
+    FrameRecorder::Config config;
+    config.buffer_bytes = buffer_mib << 20;
+    config.n_buffers = n_buffers;
+    config.direct_io = direct;
+
+    auto start = std::chrono::steady_clock::now();
+    FrameRecorder recorder(path, config);
+    for (std::size_t i = 0; i < n_spans; ++i)
+      recorder.record(pool.data() + (i % spans_in_pool) * span_bytes, span_bytes);
+    recorder.close();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto stats = recorder.stats();
+    ok = ok && file_size(path) == total;
+    std::cout << (recorder.direct_io() ? "FrameRecorder, O_DIRECT:  " : "FrameRecorder, buffered:  ")
+              << total / elapsed / 1e9 << " GB/s, " << stats.batches << " batches, producer blocked "
+              << stats.blocked_seconds / elapsed * 100 << "% of the time\n"
+              << "  batch latency mean / p50 / p99 / max: " << stats.mean_latency() * 1e3 << " / "
+              << latency_quantile(stats, 0.5) * 1e3 << " / " << latency_quantile(stats, 0.99) * 1e3 << " / "
+              << stats.max_latency * 1e3 << " ms\n";
+    if (!direct || !recorder.direct_io())
+      break;
+  }
+
+  {
+    auto start = std::chrono::steady_clock::now();
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    for (std::size_t i = 0; i < n_spans; ++i)
+      out.write(reinterpret_cast<const char*>(pool.data() + (i % spans_in_pool) * span_bytes), span_bytes);
+    out.close();
+    const double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    ok = ok && file_size(path) == total;
+    std::cout << "std::ofstream:            " << total / elapsed / 1e9 << " GB/s\n";
+  }
+
+  std::remove(path.c_str());
+  if (!ok)
+    std::cerr << "File size mismatch\n";
+  return ok ? 0 : 1;
+}
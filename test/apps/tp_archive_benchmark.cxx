@@ -0,0 +1,146 @@
+/**
+ * @file tp_archive_benchmark.cxx Write and query speed of the TpArchive columnar format
+ *
+ * Writes a time-ordered stream of raw fwtp frames both as a raw dump and as a
+ * TpArchive, then compares time/channel range queries on the archive with a
+ * full scan of the raw frames.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/TpArchive.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+double
+seconds_since(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int
+main(int argc, char* argv[])
+{
+  const std::size_t n_frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000000;
+  const std::string path = argc > 2 ? argv[2] : "/tmp/tp_archive_benchmark_" + std::to_string(::getpid()) + ".tpa";
+
+  std::mt19937_64 rng(7);
+  std::uniform_int_distribution<unsigned> crate_dist(0, 99), fiber_dist(0, 9), wire_dist(0, 255), slot_dist(0, 4);
+  std::uniform_int_distribution<unsigned> nhits_dist(1, 3), adc_dist(20, 2000);
+
+  std::vector<unsigned char> raw;
+  raw.reserve(n_frames * (sizeof(fwtp::TpHeader) + 2 * sizeof(fwtp::TpData)));
+  uint64_t timestamp = 0x0123000000000000ULL; // NOLINT(build/unsigned)
+  for (std::size_t f = 0; f < n_frames; ++f) {
+    timestamp += 2;
+    fwtp::TpHeader header;
+    header.m_flags = 0;
+    header.m_crate_no = crate_dist(rng);
+    header.m_slot_no = slot_dist(rng);
+    header.m_fiber_no = fiber_dist(rng);
+    header.m_wire_no = wire_dist(rng);
+    header.m_median = 8000 + wire_dist(rng) / 16;
+    header.m_accumulator = 0;
+    header.set_timestamp(timestamp);
+    const unsigned nhits = nhits_dist(rng);
+    header.set_nhits(nhits);
+    auto p = reinterpret_cast<const unsigned char*>(&header);
+    raw.insert(raw.end(), p, p + sizeof(header));
+    for (unsigned h = 0; h < nhits; ++h) {
+      fwtp::TpData d{};
+      d.m_start_time = 20 * h;
+      d.m_end_time = 20 * h + 12;
+      d.m_peak_time = 20 * h + 5;
+      d.m_peak_adc = adc_dist(rng);
+      d.m_sum_adc = d.m_peak_adc * 6;
+      auto q = reinterpret_cast<const unsigned char*>(&d);
+      raw.insert(raw.end(), q, q + sizeof(d));
+    }
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  uint64_t n_rows = 0; // NOLINT(build/unsigned)
+  {
+    TpArchiveWriter writer(path);
+    writer.append_frames<fwtp::TpHeader, fwtp::TpData>(raw.data(), raw.size());
+    writer.close();
+    n_rows = writer.n_rows();
+  }
+  const double write_time = seconds_since(start);
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  const double archive_bytes = ifs.tellg();
+
+  std::cout << "Frames / hits:      " << n_frames << " / " << n_rows << '\n'
+            << "Raw size:           " << raw.size() / 1e6 << " MB\n"
+            << "Archive size:       " << archive_bytes / 1e6 << " MB (" << archive_bytes / n_rows << " bytes/hit)\n"
+            << "Write:              " << write_time << " s (" << n_rows / write_time / 1e6 << " Mhits/s)\n";
+
+  TpArchiveReader reader(path);
+  const uint64_t t_first = 0x0123000000000000ULL; // NOLINT(build/unsigned)
+  const uint64_t span = 2 * n_frames;             // NOLINT(build/unsigned)
+
+  struct Case
+  {
+    const char* name;
+    TpQuery query;
+  };
+  std::vector<Case> cases(4);
+  cases[0].name = "1% time window";
+  cases[0].query.timestamp_begin = t_first + span / 2;
+  cases[0].query.timestamp_end = t_first + span / 2 + span / 100;
+  cases[1].name = "one crate, all time";
+  cases[1].query.crate_min = cases[1].query.crate_max = 42;
+  cases[2].name = "one crate in 10% window";
+  cases[2].query.timestamp_begin = t_first + span / 4;
+  cases[2].query.timestamp_end = t_first + span / 4 + span / 10;
+  cases[2].query.crate_min = cases[2].query.crate_max = 42;
+  cases[3].name = "full scan";
+
+  for (auto const& c : cases) {
+    start = std::chrono::steady_clock::now();
+    std::size_t n_archive = 0;
+    const std::size_t n_groups = reader.scan(c.query, [&n_archive](const TpRow&) { ++n_archive; });
+    const double archive_time = seconds_since(start);
+
+    // Baseline: walk every raw frame and test every hit
+    start = std::chrono::steady_clock::now();
+    std::size_t n_raw = 0;
+    const auto& q = c.query;
+    for (auto const& frame : FwtpFrameRange(raw.data(), raw.size())) {
+      const auto& h = *frame.header;
+      const uint64_t ts = h.get_timestamp(); // NOLINT(build/unsigned)
+      if (ts >= q.timestamp_begin && ts < q.timestamp_end && h.m_crate_no >= q.crate_min &&
+          h.m_crate_no <= q.crate_max && h.m_slot_no >= q.slot_min && h.m_slot_no <= q.slot_max &&
+          h.m_fiber_no >= q.fiber_min && h.m_fiber_no <= q.fiber_max && h.m_wire_no >= q.wire_min &&
+          h.m_wire_no <= q.wire_max)
+        n_raw += frame.nhits;
+    }
+    const double raw_time = seconds_since(start);
+
+    std::cout << "Query " << c.name << ": " << n_archive << " hits, " << n_groups << "/" << reader.n_row_groups()
+              << " row groups decoded, archive " << archive_time * 1e3 << " ms vs raw scan " << raw_time * 1e3
+              << " ms" << (n_raw == n_archive ? "" : "  MISMATCH") << '\n';
+    if (n_raw != n_archive)
+      return 1;
+  }
+
+  std::remove(path.c_str());
+  return 0;
+}
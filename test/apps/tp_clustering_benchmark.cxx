@@ -0,0 +1,94 @@
+/**
+ * @file tp_clustering_benchmark.cxx Throughput of TpClusterer at full-detector TP rates
+ *
+ * Generates a time-ordered stream of hits made of uncorrelated noise on every
+ * channel plus straight tracks, and measures how fast TpClusterer consumes it.
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2020.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/TpClusterer.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+int
+main(int argc, char* argv[])
+{
+  // Defaults: 150 APAs x 2560 channels, 62.5 MHz timestamps, 100 Hz of noise hits per channel
+  const std::size_t n_channels = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 384000;
+  const double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 0.25;
+  const double noise_rate_hz = argc > 3 ? std::strtod(argv[3], nullptr) : 100.;
+  const double track_rate_hz = 2000.;
+  constexpr double ticks_per_second = 62.5e6;
+
+  std::mt19937_64 rng(12345);
+  const uint64_t duration = seconds * ticks_per_second; // NOLINT(build/unsigned)
+  std::uniform_int_distribution<uint64_t> time_dist(0, duration); // NOLINT(build/unsigned)
+  std::uniform_int_distribution<uint32_t> channel_dist(0, n_channels - 1); // NOLINT(build/unsigned)
+  std::uniform_int_distribution<uint32_t> width_dist(5, 40); // NOLINT(build/unsigned)
+  std::uniform_int_distribution<uint32_t> adc_dist(20, 400); // NOLINT(build/unsigned)
+
+  std::vector<StitchedHit> hits;
+  const std::size_t n_noise = n_channels * noise_rate_hz * seconds;
+  const std::size_t n_tracks = track_rate_hz * seconds;
+  hits.reserve(n_noise + n_tracks * 100);
+
+  auto make_hit = [&](uint32_t channel, uint64_t start) { // NOLINT(build/unsigned)
+    StitchedHit h{};
+    h.channel = channel;
+    h.start_time = start;
+    h.end_time = start + width_dist(rng);
+    h.peak_time = (h.start_time + h.end_time) / 2;
+    h.peak_adc = adc_dist(rng);
+    h.sum_adc = h.peak_adc * (h.end_time - h.start_time) / 2;
+    return h;
+  };
+  for (std::size_t i = 0; i < n_noise; ++i)
+    hits.push_back(make_hit(channel_dist(rng), time_dist(rng)));
+  for (std::size_t i = 0; i < n_tracks; ++i) {
+    const uint32_t first = channel_dist(rng); // NOLINT(build/unsigned)
+    const uint64_t t0 = time_dist(rng);       // NOLINT(build/unsigned)
+    for (uint32_t j = 0; j < 100 && first + j < n_channels; ++j) // NOLINT(build/unsigned)
+      hits.push_back(make_hit(first + j, t0 + 4 * j));
+  }
+  std::sort(hits.begin(), hits.end(), [](auto& a, auto& b) { return a.start_time < b.start_time; });
+
+  TpClusterer::Config config;
+  config.max_channel_gap = 2;
+  config.max_time_gap = 10;
+  config.min_hits = 1;
+  TpClusterer clusterer(n_channels, config);
+
+  std::size_t n_clusters = 0;
+  std::size_t n_clustered_hits = 0;
+  auto emit = [&](const TpCluster& c) {
+    ++n_clusters;
+    n_clustered_hits += c.n_hits;
+  };
+
+  auto start = std::chrono::steady_clock::now();
+  for (auto const& h : hits)
+    clusterer.add(h, emit);
+  clusterer.flush(emit);
+  auto stop = std::chrono::steady_clock::now();
+
+  const double elapsed = std::chrono::duration<double>(stop - start).count();
+  std::cout << "Channels:           " << n_channels << '\n'
+            << "Hits:               " << hits.size() << " (" << n_noise << " noise, " << n_tracks << " tracks)\n"
+            << "Clusters:           " << n_clusters << " containing " << n_clustered_hits << " hits\n"
+            << "Elapsed:            " << elapsed << " s\n"
+            << "Throughput:         " << hits.size() / elapsed / 1e6 << " Mhits/s\n"
+            << "Real-time factor:   " << seconds / elapsed << "x the simulated detector rate\n"
+            // Clustering is normally partitioned per APA, so this is the number of APAs one thread keeps up with
+            << "APAs per thread:    " << seconds / elapsed * n_channels / 2560. << '\n';
+  return n_clustered_hits == hits.size() ? 0 : 1;
+}
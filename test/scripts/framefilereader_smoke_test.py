@@ -0,0 +1,103 @@
+#!/usr/bin/env python3
+"""
+Smoke test of the FrameFileReader Python bindings.
+
+Checks that FrameChunk.data() views stay valid after the chunk and the reader
+are gone, and that next() releases the GIL while it waits for the prefetch
+thread. Needs the built detdataformats package and numpy:
+
+    python3 test/scripts/framefilereader_smoke_test.py
+
+This is part of the DUNE DAQ Software Suite, copyright 2020.
+Licensing/copyright details are in the COPYING file that you should have
+received with this code.
+"""
+
+import gc
+import os
+import sys
+import tempfile
+import threading
+
+import numpy as np
+
+import detdataformats as ddf
+
+FRAME_SIZE = 28
+N_FRAMES = 100000
+
+
+def write_frames(path):
+    frames = np.arange(N_FRAMES * FRAME_SIZE, dtype=np.uint32).astype(np.uint8).reshape(N_FRAMES, FRAME_SIZE)
+    frames[:, 0] = np.arange(N_FRAMES) % 251
+    frames.tofile(path)
+    return frames
+
+
+def open_reader(path):
+    return ddf.FrameFileReader(path, ddf.FrameFileReader.kFixedSize, chunk_bytes=1 << 16, frame_size=FRAME_SIZE)
+
+
+def test_chunks(path, frames):
+    reader = open_reader(path)
+    assert reader.frame_size == FRAME_SIZE
+    assert reader.file_size == frames.nbytes
+    views = [chunk.data(FRAME_SIZE) for chunk in reader]
+    assert reader.next() is None
+    assert all(v.shape[1] == FRAME_SIZE and v.dtype == np.uint8 for v in views)
+    assert np.array_equal(np.concatenate(views), frames)
+
+
+def test_views_outlive_chunk_and_reader(path, frames):
+    reader = open_reader(path)
+    chunk = reader.next()
+    view = chunk.data(FRAME_SIZE)
+    flat = chunk.data()
+    first = chunk.frame(0)
+    n = chunk.n_frames
+    del chunk, reader
+    gc.collect()
+    # Allocate over the freed memory, had the chunk been released
+    _ = [bytearray(1 << 16) for _ in range(64)]
+    assert np.array_equal(view, frames[:n])
+    assert flat.size == n * FRAME_SIZE
+    assert first == frames[0].tobytes()
+
+
+def test_next_releases_gil(path):
+    reader = open_reader(path)
+    n_chunks = []
+    counter = [0]
+    done = threading.Event()
+
+    def consume():
+        n = 0
+        while reader.next() is not None:
+            n += 1
+        n_chunks.append(n)
+        done.set()
+
+    thread = threading.Thread(target=consume)
+    thread.start()
+    # The reader thread blocks in next() while this one keeps running Python code; a next() that
+    # kept the GIL while waiting on the prefetch thread would stall both
+    while not done.is_set():
+        counter[0] += 1
+    thread.join()
+    assert n_chunks[0] > 0
+    assert counter[0] > 0
+
+
+def main():
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "frames.bin")
+        frames = write_frames(path)
+        test_chunks(path, frames)
+        test_views_outlive_chunk_and_reader(path, frames)
+        test_next_releases_gil(path)
+    print("FrameFileReader Python smoke test passed")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
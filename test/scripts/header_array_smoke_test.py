@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+"""
+Smoke test of the DAQHeader/DAQEthHeader buffer protocol and of the
+DAQHeaderArray/DAQEthHeaderArray zero-copy views. Needs the built
+detdataformats package and numpy:
+
+    python3 test/scripts/header_array_smoke_test.py
+
+This is part of the DUNE DAQ Software Suite, copyright 2020.
+Licensing/copyright details are in the COPYING file that you should have
+received with this code.
+"""
+
+import gc
+import struct
+import sys
+
+import numpy as np
+
+import detdataformats as ddf
+
+STRIDE = 64
+N_HEADERS = 1000
+
+
+def eth_words(det_id, crate, slot, stream, seq, block_length):
+    return (1 | det_id << 6 | crate << 12 | slot << 22 | stream << 26 | seq << 40 | block_length << 52)
+
+
+def eth_buffer():
+    """N_HEADERS DAQEthHeaders, one every STRIDE bytes, and the expected columns."""
+    i = np.arange(N_HEADERS, dtype=np.uint64)
+    columns = {
+        "det_ids": np.where(i % 4 == 0, 2, 3).astype(np.uint64),
+        "crate_ids": i % 7,
+        "slot_ids": i % 3,
+        "stream_ids": i % 64,
+        "seq_ids": i % 4096,
+        "block_lengths": np.full(N_HEADERS, 6, dtype=np.uint64),
+        "timestamps": 1000 + 32 * i,
+    }
+    data = bytearray(N_HEADERS * STRIDE)
+    for k in range(N_HEADERS):
+        w0 = eth_words(*(int(columns[c][k]) for c in ("det_ids", "crate_ids", "slot_ids", "stream_ids",
+                                                      "seq_ids", "block_lengths")))
+        struct.pack_into("<QQ", data, k * STRIDE, w0, int(columns["timestamps"][k]))
+    return bytes(data), columns
+
+
+def test_single_headers():
+    raw = struct.pack("<QQ", eth_words(3, 5, 2, 17, 99, 6), 123456789)
+    h = ddf.DAQEthHeader(raw)
+    assert (h.det_id, h.crate_id, h.slot_id, h.stream_id, h.seq_id) == (3, 5, 2, 17, 99)
+    assert h.get_timestamp() == 123456789
+    assert bytes(h) == raw
+    words = np.frombuffer(h, dtype=np.uint64)
+    assert words[1] == 123456789
+    assert bytes(ddf.DAQEthHeader()) == bytes(16)
+
+    raw = struct.pack("<III", 1 | 10 << 6 | 300 << 12 | 4 << 22 | 33 << 26, 0x89abcdef, 0x1234)
+    h = ddf.DAQHeader(raw)
+    assert (h.det_id, h.crate_id, h.slot_id, h.link_id) == (10, 300, 4, 33)
+    assert h.get_timestamp() == 0x123489abcdef
+    assert bytes(h) == raw
+    assert np.frombuffer(h, dtype=np.uint32)[2] == 0x1234
+
+    try:
+        ddf.DAQHeader(raw[:8])
+        raise AssertionError("a short buffer was accepted")
+    except ValueError:
+        pass
+
+
+def test_columns_and_selection():
+    data, columns = eth_buffer()
+    headers = ddf.DAQEthHeaderArray(data, stride=STRIDE)
+    assert len(headers) == N_HEADERS
+    assert headers.stride == STRIDE
+    for name, expected in columns.items():
+        column = getattr(headers, name)()
+        assert np.array_equal(column, expected), name
+    assert headers.timestamps().dtype == np.uint64
+    assert headers.crate_ids().dtype == np.uint16
+    assert headers[-1].get_timestamp() == int(columns["timestamps"][-1])
+
+    t = columns["timestamps"]
+    indices = headers.select(det_id=3, t0=5000)
+    assert indices.dtype == np.uint64
+    assert np.array_equal(indices, np.nonzero((columns["det_ids"] == 3) & (t >= 5000))[0])
+    indices = headers.select(crate_id=2, stream_id=9, t1=20000)
+    assert np.array_equal(indices, np.nonzero((columns["crate_ids"] == 2) & (columns["stream_ids"] == 9) & (t < 20000))[0])
+    assert len(headers.select()) == N_HEADERS
+
+    # The array exports the header bytes, read-only, without the padding between headers
+    view = np.asarray(headers)
+    assert view.shape == (N_HEADERS, 16) and view.dtype == np.uint8
+    assert not view.flags.writeable
+    assert bytes(view[1]) == data[STRIDE:STRIDE + 16]
+
+
+def test_daqheader_array():
+    words = np.zeros((10, 3), dtype=np.uint32)
+    words[:, 0] = 1 | 3 << 6 | (np.arange(10) << 26)
+    words[:, 1] = np.arange(10) * 100
+    headers = ddf.DAQHeaderArray(words)
+    assert np.array_equal(headers.link_ids(), np.arange(10))
+    assert np.array_equal(headers.select(link_id=4), [4])
+    assert not hasattr(headers, "seq_ids")
+
+    for bad in (words[:, :2], np.zeros(13, dtype=np.uint8)):
+        try:
+            ddf.DAQHeaderArray(bad)
+            raise AssertionError("a buffer that is not whole headers was accepted")
+        except ValueError:
+            pass
+
+
+def test_buffer_outlives_source():
+    data, columns = eth_buffer()
+    source = bytearray(data)
+    headers = ddf.DAQEthHeaderArray(source, stride=STRIDE)
+    # Exported, so it can't be resized under the view
+    try:
+        source.extend(b"x")
+        raise AssertionError("the source was resized while viewed")
+    except BufferError:
+        pass
+    del source
+    view = np.asarray(headers)
+    del headers
+    gc.collect()
+    _ = [bytearray(N_HEADERS * STRIDE) for _ in range(16)]
+    assert np.array_equal(view[:, 8:].copy().view(np.uint64).ravel(), columns["timestamps"])
+
+    headers = ddf.DAQEthHeaderArray(bytes(data), stride=STRIDE)
+    gc.collect()
+    assert np.array_equal(headers.timestamps(), columns["timestamps"])
+
+
+def main():
+    test_single_headers()
+    test_columns_and_selection()
+    test_daqheader_array()
+    test_buffer_outlives_source()
+    print("Header array Python smoke test passed")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,94 @@
+/**
+ * @file ChannelMap_test.cxx ChannelMap class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/ChannelMap.hpp"
+
+#define BOOST_TEST_MODULE ChannelMap_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+BOOST_AUTO_TEST_SUITE(ChannelMap_test)
+
+BOOST_AUTO_TEST_CASE(FwtpLookup)
+{
+  FwtpChannelMap map;
+  map.add(341, 3, 33, 171, 12345);
+  map.add(341, 3, 33, 0, 7);
+  map.add(2, 1, 0, 255, 99);
+  map.compile();
+
+  BOOST_REQUIRE_EQUAL(map.n_links(), 2);
+  BOOST_REQUIRE_EQUAL(map.max_channel(), 12345);
+
+  fwtp::TpHeader header;
+  header.m_crate_no = 341;
+  header.m_slot_no = 3;
+  header.m_fiber_no = 33;
+  header.m_wire_no = 171;
+  header.m_flags = 0xF;
+  BOOST_REQUIRE_EQUAL(map.lookup(header), 12345);
+  BOOST_REQUIRE_EQUAL(map.lookup(341, 3, 33, 0), 7);
+  BOOST_REQUIRE_EQUAL(map.lookup(2, 1, 0, 255), 99);
+  BOOST_REQUIRE_EQUAL(map.lookup(2, 1, 0, 254), FwtpChannelMap::s_invalid_channel);
+  BOOST_REQUIRE_EQUAL(map.lookup(3, 1, 0, 255), FwtpChannelMap::s_invalid_channel);
+  BOOST_REQUIRE_EQUAL(map.lookup(2000, 1, 0, 255), FwtpChannelMap::s_invalid_channel);
+
+  BOOST_CHECK_THROW(map.add(1024, 0, 0, 0, 1), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(WIBBatchLookup)
+{
+  WIBChannelMap map({ { 31, 7, 7, 255, 1 }, { 0, 0, 0, 0, 2 }, { 5, 2, 3, 17, 3 } });
+
+  std::vector<wib::TpHeader> headers(4);
+  headers[0].m_crate_no = 31, headers[0].m_slot_no = 7, headers[0].m_fiber_no = 7, headers[0].m_wire_no = 255;
+  headers[1].m_crate_no = 0, headers[1].m_slot_no = 0, headers[1].m_fiber_no = 0, headers[1].m_wire_no = 0;
+  headers[2].m_crate_no = 5, headers[2].m_slot_no = 2, headers[2].m_fiber_no = 3, headers[2].m_wire_no = 17;
+  headers[3].m_crate_no = 5, headers[3].m_slot_no = 2, headers[3].m_fiber_no = 4, headers[3].m_wire_no = 17;
+  for (auto& h : headers)
+    h.m_flags = 0x1FFF;
+
+  std::vector<WIBChannelMap::channel_t> out(headers.size());
+  map.lookup(headers.data(), headers.size(), sizeof(wib::TpHeader), out.data());
+  BOOST_REQUIRE_EQUAL(out[0], 1);
+  BOOST_REQUIRE_EQUAL(out[1], 2);
+  BOOST_REQUIRE_EQUAL(out[2], 3);
+  BOOST_REQUIRE_EQUAL(out[3], WIBChannelMap::s_invalid_channel);
+
+  std::vector<const wib::TpHeader*> pointers = { &headers[2], &headers[0] };
+  map.lookup(pointers.data(), pointers.size(), out.data());
+  BOOST_REQUIRE_EQUAL(out[0], 3);
+  BOOST_REQUIRE_EQUAL(out[1], 1);
+}
+
+BOOST_AUTO_TEST_CASE(Load)
+{
+  std::istringstream iss("# crate slot fiber wire channel\n"
+                         "1 2 3 4 100\n"
+                         "\n"
+                         "1 2 3 5 101 # trailing comment\n");
+  auto map = FwtpChannelMap::load(iss);
+  BOOST_REQUIRE_EQUAL(map.size(), 2);
+  BOOST_REQUIRE_EQUAL(map.lookup(1, 2, 3, 4), 100);
+  BOOST_REQUIRE_EQUAL(map.lookup(1, 2, 3, 5), 101);
+
+  std::istringstream bad("1 2 3\n");
+  BOOST_CHECK_THROW(FwtpChannelMap::load(bad), std::runtime_error);
+  std::istringstream wide("0 0 8 0 1\n");
+  BOOST_CHECK_THROW(WIBChannelMap::load(wide), std::runtime_error);
+  BOOST_CHECK_THROW(FwtpChannelMap::load_from_file("/nonexistent/channel.map"), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,163 @@
+/**
+ * @file CompactTp_test.cxx CompactTp class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/CompactTp.hpp"
+
+#define BOOST_TEST_MODULE CompactTp_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+template<class Header, class Data>
+void
+append_frame(std::vector<unsigned char>& stream,
+             unsigned fiber,
+             unsigned wire,
+             uint64_t timestamp,
+             const std::vector<Data>& hits)
+{
+  Header header;
+  header.m_crate_no = 1;
+  header.m_slot_no = 2;
+  header.m_fiber_no = fiber;
+  header.m_wire_no = wire;
+  header.m_flags = 0;
+  header.m_median = 900;
+  header.m_accumulator = 0;
+  header.set_timestamp(timestamp);
+  header.set_nhits(hits.size());
+  auto p = reinterpret_cast<const unsigned char*>(&header);
+  stream.insert(stream.end(), p, p + sizeof(header));
+  auto d = reinterpret_cast<const unsigned char*>(hits.data());
+  stream.insert(stream.end(), d, d + hits.size() * sizeof(Data));
+}
+
+template<class Data>
+Data
+make_hit(unsigned start, unsigned end, unsigned peak_adc, unsigned sum_adc)
+{
+  Data d;
+  std::memset(static_cast<void*>(&d), 0, sizeof(d));
+  d.m_start_time = start;
+  d.m_end_time = end;
+  d.m_peak_time = (start + end) / 2;
+  d.m_peak_adc = peak_adc;
+  d.m_sum_adc = sum_adc;
+  return d;
+}
+
+template<class Map>
+Map
+make_map()
+{
+  Map map;
+  for (unsigned fiber = 0; fiber < 2; ++fiber)
+    for (unsigned wire = 0; wire < 256; ++wire)
+      map.add(1, 2, fiber, wire, 1000 + fiber * 256 + wire);
+  map.compile();
+  return map;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(CompactTp_test)
+
+BOOST_AUTO_TEST_CASE(PackFwtp)
+{
+  using data_t = fwtp::TpData;
+  auto map = make_map<FwtpChannelMap>();
+  FwtpCompactTpCodec codec(map);
+
+  std::vector<unsigned char> stream;
+  append_frame<fwtp::TpHeader>(stream, 0, 5, 1000000, std::vector<data_t>{ make_hit<data_t>(10, 30, 50, 400) });
+  append_frame<fwtp::TpHeader>(stream,
+                               1,
+                               7,
+                               2000000,
+                               std::vector<data_t>{ make_hit<data_t>(0, 5000, 60, 500), make_hit<data_t>(100, 90, 1, 2) });
+  append_frame<fwtp::TpHeader>(stream, 3, 0, 3000000, std::vector<data_t>{ make_hit<data_t>(1, 2, 3, 4) }); // unmapped
+  const std::size_t complete = stream.size();
+  append_frame<fwtp::TpHeader>(stream, 0, 1, 4000000, std::vector<data_t>{ make_hit<data_t>(1, 2, 3, 4) });
+
+  std::vector<CompactTp> tps;
+  BOOST_REQUIRE_EQUAL(codec.pack(stream.data(), stream.size() - 4, tps), complete);
+  BOOST_REQUIRE_EQUAL(tps.size(), 3);
+  BOOST_REQUIRE_EQUAL(tps[0].timestamp, 1000010);
+  BOOST_REQUIRE_EQUAL(tps[0].channel, 1005);
+  BOOST_REQUIRE_EQUAL(tps[0].time_over_threshold, 20);
+  BOOST_REQUIRE_EQUAL(tps[0].end_time(), 1000030);
+  BOOST_REQUIRE_EQUAL(tps[0].peak_adc, 50);
+  BOOST_REQUIRE_EQUAL(tps[0].sum_adc, 400);
+  BOOST_REQUIRE_EQUAL(tps[1].channel, 1000 + 256 + 7);
+  BOOST_REQUIRE_EQUAL(tps[1].time_over_threshold, CompactTp::s_max_time_over_threshold);
+  BOOST_REQUIRE_EQUAL(tps[2].time_over_threshold, 0);
+
+  auto const& c = codec.counters();
+  BOOST_REQUIRE_EQUAL(c.n_frames, 3);
+  BOOST_REQUIRE_EQUAL(c.n_hits, 3);
+  BOOST_REQUIRE_EQUAL(c.n_unmapped, 1);
+  BOOST_REQUIRE_EQUAL(c.n_saturated, 1);
+}
+
+BOOST_AUTO_TEST_CASE(RoundTripWIB)
+{
+  using data_t = wib::TpData;
+  auto map = make_map<WIBChannelMap>();
+  WIBCompactTpCodec codec(map);
+
+  std::vector<unsigned char> stream;
+  for (unsigned i = 0; i < 50; ++i)
+    append_frame<wib::TpHeader>(
+      stream, i % 2, i * 5 % 256, 1ull << 40 | i * 1000, std::vector<data_t>{ make_hit<data_t>(i, i + 3 * i, i, 7 * i) });
+  std::vector<CompactTp> tps;
+  BOOST_REQUIRE_EQUAL(codec.pack(stream.data(), stream.size(), tps), stream.size());
+
+  // Single-hit frames with start_time 0 come back identical, apart from what CompactTp drops
+  std::vector<unsigned char> unpacked(tps.size() * WIBCompactTpCodec::s_unpacked_size);
+  BOOST_REQUIRE_EQUAL(codec.unpack(tps.data(), tps.size(), unpacked.data(), unpacked.size() - 1), tps.size() - 1);
+  BOOST_REQUIRE_EQUAL(codec.unpack(tps.data(), tps.size(), unpacked.data(), unpacked.size()), tps.size());
+  std::vector<CompactTp> again;
+  WIBCompactTpCodec other(map);
+  BOOST_REQUIRE_EQUAL(other.pack(unpacked.data(), unpacked.size(), again), unpacked.size());
+  BOOST_REQUIRE_EQUAL(again.size(), tps.size());
+  for (std::size_t i = 0; i < tps.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(again[i].timestamp, tps[i].timestamp);
+    BOOST_REQUIRE_EQUAL(again[i].channel, tps[i].channel);
+    BOOST_REQUIRE_EQUAL(again[i].time_over_threshold, tps[i].time_over_threshold);
+    BOOST_REQUIRE_EQUAL(again[i].peak_adc, tps[i].peak_adc);
+    BOOST_REQUIRE_EQUAL(again[i].sum_adc, tps[i].sum_adc);
+  }
+  auto frame = reinterpret_cast<const wib::TpHeader*>(unpacked.data() + WIBCompactTpCodec::s_unpacked_size);
+  BOOST_REQUIRE_EQUAL(frame->m_crate_no, 1);
+  BOOST_REQUIRE_EQUAL(frame->m_slot_no, 2);
+  BOOST_REQUIRE_EQUAL(frame->m_fiber_no, 1);
+  BOOST_REQUIRE_EQUAL(frame->m_wire_no, 5);
+
+  CompactTp unknown = tps[0];
+  unknown.channel = 5;
+  BOOST_REQUIRE_THROW(codec.unpack(&unknown, 1, unpacked.data(), unpacked.size()), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_CASE(ChannelRange)
+{
+  FwtpChannelMap map;
+  map.add(1, 2, 3, 4, CompactTp::s_max_channel + 1);
+  map.compile();
+  BOOST_REQUIRE_THROW(FwtpCompactTpCodec codec(map), std::invalid_argument);
+  FwtpChannelMap uncompiled;
+  BOOST_REQUIRE_THROW(FwtpCompactTpCodec codec(uncompiled), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,140 @@
+/**
+ * @file DetIdDemux_test.cxx DetIdDemux class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/DetIdDemux.hpp"
+
+#define BOOST_TEST_MODULE DetIdDemux_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+// Appends a DAQEthHeader block with @p words payload words, whose first word is @p tag
+void
+append_eth_block(std::vector<unsigned char>& buffer, unsigned det_id, unsigned words, uint64_t tag)
+{
+  DAQEthHeader h;
+  std::memset(static_cast<void*>(&h), 0, sizeof(h));
+  h.version = 1;
+  h.det_id = det_id;
+  h.block_length = words;
+  const std::size_t offset = buffer.size();
+  buffer.resize(offset + sizeof(h) + 8 * words);
+  std::memcpy(buffer.data() + offset, &h, sizeof(h));
+  if (words > 0)
+    std::memcpy(buffer.data() + offset + sizeof(h), &tag, sizeof(tag));
+}
+
+uint64_t
+tag_of(const std::vector<unsigned char>& buffer, const BlockRef& block)
+{
+  uint64_t tag;
+  std::memcpy(&tag, buffer.data() + block.offset + sizeof(DAQEthHeader), sizeof(tag));
+  return tag;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(DetIdDemux_test)
+
+BOOST_AUTO_TEST_CASE(FixedSizeBlocks)
+{
+  const std::size_t block_size = 64;
+  const std::size_t n = 10000;
+  std::vector<unsigned char> buffer(n * block_size + 20);
+  std::vector<std::size_t> expected_tpc, expected_pds, expected_quarantine;
+  for (std::size_t i = 0; i < n; ++i) {
+    DAQHeader h{};
+    h.det_id = i % 3 == 0 ? 3 : (i % 3 == 1 ? 2 : (i % 2 == 0 ? 0 : 63)); // HD_TPC, HD_PDS, unknown
+    std::memcpy(buffer.data() + i * block_size, &h, sizeof(h));
+    (h.det_id == 3 ? expected_tpc : h.det_id == 2 ? expected_pds : expected_quarantine).push_back(i * block_size);
+  }
+
+  DetIdDemux<DAQHeader>::Config config;
+  config.block_size = block_size;
+  config.min_blocks_per_thread = 100;
+  DAQHeaderDemux demux(config);
+  for (unsigned n_threads : { 1u, 3u, 8u, 2u }) { // the workers started for 8 stay up for 2
+    BOOST_REQUIRE_EQUAL(demux.demux(buffer.data(), buffer.size(), n_threads), n * block_size);
+    BOOST_REQUIRE_EQUAL(demux.n_threads_used(), n_threads);
+    BOOST_REQUIRE_EQUAL(demux.n_blocks(), n);
+
+    auto check = [&](BlockRange range, const std::vector<std::size_t>& expected) {
+      BOOST_REQUIRE_EQUAL(range.size(), expected.size());
+      std::size_t k = 0;
+      for (const auto& block : range) {
+        BOOST_REQUIRE_EQUAL(block.offset, expected[k++]);
+        BOOST_REQUIRE_EQUAL(block.size, block_size);
+      }
+    };
+    check(demux.output(DetID::Subdetector::kHD_TPC), expected_tpc);
+    check(demux.output(DetID::Subdetector::kHD_PDS), expected_pds);
+    check(demux.quarantine(), expected_quarantine);
+    BOOST_REQUIRE(demux.output(DetID::Subdetector::kHD_CRT).empty());
+    BOOST_REQUIRE(demux.output(DetID::Subdetector::kUnknown).empty());
+  }
+
+  BOOST_REQUIRE(demux.is_known(3));
+  BOOST_REQUIRE(!demux.is_known(0));
+  BOOST_REQUIRE(!demux.is_known(5));
+}
+
+BOOST_AUTO_TEST_CASE(EthBlocksFramedByLength)
+{
+  std::vector<unsigned char> buffer;
+  std::vector<uint64_t> tpc_tags, crt_tags;
+  for (unsigned i = 0; i < 500; ++i) {
+    const unsigned det_id = i % 4 == 0 ? 4 : 3; // HD_CRT, HD_TPC
+    append_eth_block(buffer, det_id, 1 + i % 7, i);
+    (det_id == 4 ? crt_tags : tpc_tags).push_back(i);
+  }
+  const std::size_t complete = buffer.size();
+  append_eth_block(buffer, 3, 50, 1000);
+  buffer.resize(buffer.size() - 8);
+
+  DetIdDemux<DAQEthHeader>::Config config;
+  config.min_blocks_per_thread = 16;
+  DAQEthHeaderDemux demux(config);
+  BOOST_REQUIRE_EQUAL(demux.demux(buffer.data(), buffer.size(), 4), complete);
+  BOOST_REQUIRE_EQUAL(demux.n_blocks(), 500u);
+  BOOST_REQUIRE(demux.quarantine().empty());
+
+  std::vector<uint64_t> tags;
+  for (const auto& block : demux.output(DetID::Subdetector::kHD_CRT)) {
+    DAQEthHeader h;
+    std::memcpy(&h, buffer.data() + block.offset, sizeof(h));
+    BOOST_REQUIRE_EQUAL(block.size, sizeof(h) + 8 * h.block_length);
+    tags.push_back(tag_of(buffer, block));
+  }
+  BOOST_REQUIRE(tags == crt_tags);
+  tags.clear();
+  for (const auto& block : demux.output(DetID::Subdetector::kHD_TPC))
+    tags.push_back(tag_of(buffer, block));
+  BOOST_REQUIRE(tags == tpc_tags);
+
+  // Too small for several threads
+  BOOST_REQUIRE_EQUAL(demux.demux(buffer.data(), 100, 4), 0u + sizeof(DAQEthHeader) + 8 + sizeof(DAQEthHeader) + 16 +
+                                                            sizeof(DAQEthHeader) + 24);
+  BOOST_REQUIRE_EQUAL(demux.n_threads_used(), 1u);
+}
+
+BOOST_AUTO_TEST_CASE(BadConfig)
+{
+  DetIdDemux<DAQHeader>::Config config;
+  BOOST_REQUIRE_THROW(DAQHeaderDemux{ config }, std::invalid_argument);
+  config.block_size = 8;
+  BOOST_REQUIRE_THROW(DAQHeaderDemux{ config }, std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
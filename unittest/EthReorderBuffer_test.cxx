@@ -0,0 +1,104 @@
+/**
+ * @file EthReorderBuffer_test.cxx EthReorderBuffer class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/EthReorderBuffer.hpp"
+
+#define BOOST_TEST_MODULE EthReorderBuffer_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+std::vector<DAQEthHeader>
+make_packets(unsigned n, unsigned first_seq_id, unsigned stream_id = 0)
+{
+  std::vector<DAQEthHeader> packets(n);
+  for (unsigned i = 0; i < n; ++i) {
+    packets[i] = DAQEthHeader{};
+    packets[i].crate_id = 7;
+    packets[i].slot_id = 3;
+    packets[i].stream_id = stream_id;
+    packets[i].seq_id = (first_seq_id + i) % 4096;
+    packets[i].timestamp = 1000 + i;
+  }
+  return packets;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(EthReorderBuffer_test)
+
+BOOST_AUTO_TEST_CASE(ReorderAcrossWrap)
+{
+  EthReorderBuffer buffer({ 8, 0 });
+  auto packets = make_packets(10, 4093); // seq_ids 4093..4095, 0..6
+
+  std::vector<unsigned> released;
+  auto emit = [&released](const DAQEthHeader* p) { released.push_back(p->seq_id); };
+
+  for (unsigned i : { 0, 2, 1, 4, 3, 5, 9, 8, 7, 6 })
+    buffer.push(&packets[i], i, emit);
+
+  BOOST_REQUIRE_EQUAL(released.size(), 10);
+  for (unsigned i = 0; i < released.size(); ++i)
+    BOOST_REQUIRE_EQUAL(released[i], packets[i].seq_id);
+  BOOST_REQUIRE_EQUAL(buffer.counters().n_reordered, 5);
+  BOOST_REQUIRE_EQUAL(buffer.counters().n_lost, 0);
+  BOOST_REQUIRE_EQUAL(buffer.n_buffered(), 0);
+
+  // A packet from the past is late
+  buffer.push(&packets[3], 20, emit);
+  BOOST_REQUIRE_EQUAL(buffer.counters().n_late, 1);
+}
+
+BOOST_AUTO_TEST_CASE(TimeoutAndOverflow)
+{
+  EthReorderBuffer buffer({ 4, 100 });
+  auto packets = make_packets(20, 0);
+  auto other = make_packets(2, 50, 1);
+
+  std::vector<unsigned> released;
+  auto emit = [&released](const DAQEthHeader* p) { released.push_back(p->seq_id); };
+
+  buffer.push(&packets[0], 0, emit);
+  buffer.push(&packets[2], 10, emit); // seq_id 1 is missing
+  buffer.push(&packets[2], 11, emit);
+  BOOST_REQUIRE_EQUAL(buffer.counters().n_duplicates, 1);
+  buffer.push(&other[0], 20, emit);
+  BOOST_REQUIRE_EQUAL(buffer.n_streams(), 2);
+  BOOST_REQUIRE_EQUAL(released.size(), 2);
+
+  buffer.expire(110, emit);
+  BOOST_REQUIRE_EQUAL(released.size(), 2);
+  buffer.expire(111, emit);
+  BOOST_REQUIRE_EQUAL(released.size(), 3);
+  BOOST_REQUIRE_EQUAL(released.back(), 2);
+  BOOST_REQUIRE_EQUAL(buffer.counters().n_lost, 1);
+
+  // seq_id 3 missing, 10 does not fit in a 4-slot window starting at 3: the window slides to 7,
+  // losing 3, 5 and 6 on the way
+  buffer.push(&packets[4], 200, emit);
+  buffer.push(&packets[10], 201, emit);
+  BOOST_REQUIRE_EQUAL(buffer.counters().n_lost, 1 + 3);
+  BOOST_REQUIRE_EQUAL(released.back(), 4);
+  BOOST_REQUIRE_EQUAL(buffer.n_buffered(), 1);
+
+  buffer.flush(emit);
+  BOOST_REQUIRE_EQUAL(released.back(), 10);
+  BOOST_REQUIRE_EQUAL(buffer.n_buffered(), 0);
+
+  BOOST_CHECK_THROW(EthReorderBuffer({ 6, 0 }), std::invalid_argument);
+  BOOST_CHECK_THROW(EthReorderBuffer({ 4096, 0 }), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
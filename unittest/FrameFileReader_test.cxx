@@ -0,0 +1,125 @@
+/**
+ * @file FrameFileReader_test.cxx FrameFileReader class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/FrameFileReader.hpp"
+#include "detdataformats/HSIFrame.hpp"
+#include "detdataformats/TpFrame.hpp"
+
+#define BOOST_TEST_MODULE FrameFileReader_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+std::string
+write_file(const std::string& name, const std::vector<unsigned char>& bytes)
+{
+  std::string path = "/tmp/" + name + "_" + std::to_string(::getpid());
+  std::ofstream ofs(path, std::ios::binary);
+  ofs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  return path;
+}
+
+void
+append_tp_frame(std::vector<unsigned char>& bytes, uint64_t timestamp, int nhits) // NOLINT(build/unsigned)
+{
+  fwtp::TpHeader header;
+  header.set_timestamp(timestamp);
+  header.set_nhits(nhits);
+  auto p = reinterpret_cast<const unsigned char*>(&header);
+  bytes.insert(bytes.end(), p, p + sizeof(header));
+  for (int i = 0; i < nhits; ++i) {
+    fwtp::TpData hit{};
+    hit.m_sum_adc = i + 1;
+    auto q = reinterpret_cast<const unsigned char*>(&hit);
+    bytes.insert(bytes.end(), q, q + sizeof(hit));
+  }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(FrameFileReader_test)
+
+BOOST_AUTO_TEST_CASE(FixedSizeFrames)
+{
+  std::vector<unsigned char> bytes;
+  for (unsigned i = 0; i < 10; ++i) {
+    HSIFrame frame{};
+    frame.set_timestamp(1000 + i);
+    auto p = reinterpret_cast<const unsigned char*>(&frame);
+    bytes.insert(bytes.end(), p, p + sizeof(frame));
+  }
+  bytes.push_back(0xFF); // trailing partial frame
+  auto path = write_file("FrameFileReader_fixed", bytes);
+
+  FrameFileReader reader(path, FrameFileReader::FrameKind::kFixedSize, 3 * sizeof(HSIFrame) + 5, sizeof(HSIFrame));
+  BOOST_REQUIRE_EQUAL(reader.chunk_bytes(), 3 * sizeof(HSIFrame));
+
+  std::vector<uint64_t> timestamps; // NOLINT(build/unsigned)
+  std::vector<std::size_t> chunk_sizes;
+  while (auto chunk = reader.next()) {
+    chunk_sizes.push_back(chunk->n_frames);
+    for (std::size_t i = 0; i < chunk->n_frames; ++i)
+      timestamps.push_back(reinterpret_cast<const HSIFrame*>(chunk->data.get() + i * sizeof(HSIFrame))->get_timestamp());
+  }
+  BOOST_REQUIRE_EQUAL(timestamps.size(), 10);
+  for (unsigned i = 0; i < timestamps.size(); ++i)
+    BOOST_REQUIRE_EQUAL(timestamps[i], 1000 + i);
+  BOOST_REQUIRE_EQUAL(chunk_sizes.size(), 4);
+  BOOST_REQUIRE(!reader.next());
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(RawTpFrames)
+{
+  std::vector<unsigned char> bytes;
+  int total_hits = 0;
+  for (int i = 0; i < 50; ++i) {
+    append_tp_frame(bytes, 5000 + i, i % 7);
+    total_hits += i % 7;
+  }
+  append_tp_frame(bytes, 9999, 200); // larger than a chunk
+  total_hits += 200;
+  auto path = write_file("FrameFileReader_rawtp", bytes);
+
+  FrameFileReader reader(path, FrameFileReader::FrameKind::kRawTp, 256, 0, 3);
+  std::size_t n_frames = 0;
+  int n_hits = 0;
+  uint64_t last_timestamp = 0; // NOLINT(build/unsigned)
+  while (auto chunk = reader.next()) {
+    BOOST_REQUIRE_EQUAL(chunk->frame_offsets.size(), chunk->n_frames);
+    for (auto const& frame : FwtpFrameRange(chunk->data.get(), chunk->size)) {
+      BOOST_REQUIRE_GT(frame.get_timestamp(), last_timestamp);
+      last_timestamp = frame.get_timestamp();
+      n_hits += frame.nhits;
+      ++n_frames;
+    }
+  }
+  BOOST_REQUIRE_EQUAL(n_frames, 51);
+  BOOST_REQUIRE_EQUAL(n_hits, total_hits);
+  BOOST_REQUIRE_EQUAL(last_timestamp, 9999);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(Errors)
+{
+  BOOST_CHECK_THROW(FrameFileReader("/nonexistent/file", FrameFileReader::FrameKind::kRawTp, 1024),
+                    std::runtime_error);
+  BOOST_CHECK_THROW(FrameFileReader("/nonexistent/file", FrameFileReader::FrameKind::kFixedSize, 1024, 0),
+                    std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,167 @@
+/**
+ * @file FrameRecorder_test.cxx FrameRecorder class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/FrameRecorder.hpp"
+
+#define BOOST_TEST_MODULE FrameRecorder_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+std::string
+temp_path(const std::string& name)
+{
+  return "/tmp/FrameRecorder_test_" + std::to_string(::getpid()) + "_" + name;
+}
+
+std::vector<unsigned char>
+read_file(const std::string& path)
+{
+  std::ifstream in(path, std::ios::binary);
+  return std::vector<unsigned char>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
+
+std::vector<unsigned char>
+make_span(std::size_t size, unsigned seed)
+{
+  std::vector<unsigned char> span(size);
+  for (std::size_t i = 0; i < size; ++i)
+    span[i] = static_cast<unsigned char>(i * 131 + seed * 7 + 1);
+  return span;
+}
+
+FrameRecorder::Config
+small_config()
+{
+  FrameRecorder::Config config;
+  config.buffer_bytes = 16384;
+  config.n_buffers = 3;
+  return config;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(FrameRecorder_test)
+
+BOOST_AUTO_TEST_CASE(RoundTrip)
+{
+  const std::string path = temp_path("round_trip");
+  std::vector<unsigned char> expected;
+  {
+    FrameRecorder recorder(path, small_config());
+    // Spans of odd sizes straddle buffer boundaries; one is larger than a whole buffer
+    for (unsigned i = 0; i < 40; ++i) {
+      auto span = make_span(i == 17 ? 40000 : 1000 + 77 * i, i);
+      BOOST_REQUIRE(recorder.record(span.data(), span.size()));
+      expected.insert(expected.end(), span.begin(), span.end());
+    }
+    BOOST_REQUIRE_EQUAL(recorder.size(), expected.size());
+    recorder.close();
+
+    const auto stats = recorder.stats();
+    BOOST_REQUIRE_EQUAL(stats.spans, 40);
+    BOOST_REQUIRE_EQUAL(stats.dropped_spans, 0);
+    BOOST_REQUIRE_GE(stats.bytes_written, expected.size());
+    BOOST_REQUIRE_EQUAL(stats.batches, (expected.size() + 16383) / 16384);
+    uint64_t histogram_total = 0; // NOLINT(build/unsigned)
+    for (auto n : stats.latency_histogram)
+      histogram_total += n;
+    BOOST_REQUIRE_EQUAL(histogram_total, stats.batches);
+    BOOST_REQUIRE_GE(stats.max_latency, stats.mean_latency());
+  }
+  BOOST_REQUIRE(read_file(path) == expected);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(FlushMidStream)
+{
+  const std::string path = temp_path("flush");
+  std::vector<unsigned char> expected;
+  FrameRecorder recorder(path, small_config());
+  for (unsigned i = 0; i < 10; ++i) {
+    auto span = make_span(333 * (i + 1), i);
+    recorder.record(span.data(), span.size());
+    expected.insert(expected.end(), span.begin(), span.end());
+    recorder.flush();
+    // After a flush everything recorded is readable, although the last block may be padded
+    auto contents = read_file(path);
+    BOOST_REQUIRE_GE(contents.size(), expected.size());
+    contents.resize(expected.size());
+    BOOST_REQUIRE(contents == expected);
+  }
+  recorder.close();
+  BOOST_REQUIRE(read_file(path) == expected);
+  recorder.close(); // idempotent
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(DropWhenFull)
+{
+  const std::string path = temp_path("drop");
+  auto config = small_config();
+  config.n_buffers = 1;
+  config.block_when_full = false;
+  FrameRecorder recorder(path, config);
+
+  auto too_big = make_span(config.buffer_bytes + 1, 1);
+  BOOST_REQUIRE(!recorder.record(too_big.data(), too_big.size()));
+  auto span = make_span(1000, 2);
+  BOOST_REQUIRE(recorder.record(span.data(), span.size()));
+  recorder.close();
+
+  const auto stats = recorder.stats();
+  BOOST_REQUIRE_EQUAL(stats.spans, 1);
+  BOOST_REQUIRE_EQUAL(stats.dropped_spans, 1);
+  BOOST_REQUIRE_EQUAL(stats.dropped_bytes, too_big.size());
+  BOOST_REQUIRE(read_file(path) == span);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BufferedFallback)
+{
+  const std::string path = temp_path("buffered");
+  auto config = small_config();
+  config.direct_io = false;
+  FrameRecorder recorder(path, config);
+  BOOST_REQUIRE(!recorder.direct_io());
+  auto span = make_span(50000, 3);
+  recorder.record(span.data(), span.size());
+  recorder.close();
+  BOOST_REQUIRE(read_file(path) == span);
+  BOOST_REQUIRE_EQUAL(recorder.stats().bytes_written, span.size());
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BadConfiguration)
+{
+  const std::string path = temp_path("bad");
+  auto config = small_config();
+  config.buffer_bytes = 10000;
+  BOOST_REQUIRE_THROW(FrameRecorder(path, config), std::invalid_argument);
+  config = small_config();
+  config.alignment = 3000;
+  BOOST_REQUIRE_THROW(FrameRecorder(path, config), std::invalid_argument);
+  config = small_config();
+  config.n_buffers = 0;
+  BOOST_REQUIRE_THROW(FrameRecorder(path, config), std::invalid_argument);
+  BOOST_REQUIRE_THROW(FrameRecorder("/nonexistent_directory/frames.bin", small_config()), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,129 @@
+/**
+ * @file HeaderArrayView_test.cxx HeaderArrayView class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/HeaderArrayView.hpp"
+
+#define BOOST_TEST_MODULE HeaderArrayView_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+DAQEthHeader
+make_eth_header(unsigned crate, unsigned slot, unsigned stream, unsigned seq, uint64_t timestamp)
+{
+  DAQEthHeader h{};
+  h.version = 1;
+  h.det_id = 3;
+  h.crate_id = crate;
+  h.slot_id = slot;
+  h.stream_id = stream;
+  h.seq_id = seq;
+  h.block_length = 0x382;
+  h.timestamp = timestamp;
+  return h;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(HeaderArrayView_test)
+
+BOOST_AUTO_TEST_CASE(EthColumns)
+{
+  // Headers at the start of 20-byte records, one byte into the buffer so none is aligned
+  const std::size_t stride = 20;
+  const std::size_t n = 100;
+  std::vector<unsigned char> buffer(1 + n * stride, 0xee);
+  for (std::size_t i = 0; i < n; ++i) {
+    const auto h = make_eth_header(i % 7, i % 3, i % 64, i % 4096, 1000 + 32 * i);
+    std::memcpy(buffer.data() + 1 + i * stride, &h, sizeof(h));
+  }
+
+  DAQEthHeaderArrayView view(buffer.data() + 1, n, stride);
+  BOOST_REQUIRE_EQUAL(view.size(), n);
+  BOOST_REQUIRE_EQUAL(view.at(5).crate_id, 5u);
+  BOOST_REQUIRE_THROW(view.at(n), std::out_of_range);
+
+  std::vector<uint64_t> timestamps(n);
+  std::vector<uint16_t> crates(n), links(n), seqs(n), lengths(n);
+  view.column(HeaderField::kTimestamp, timestamps.data());
+  view.column(HeaderField::kCrateId, crates.data());
+  view.column(HeaderField::kLinkId, links.data());
+  view.column(HeaderField::kSeqId, seqs.data());
+  view.column(HeaderField::kBlockLength, lengths.data());
+  for (std::size_t i = 0; i < n; ++i) {
+    BOOST_REQUIRE_EQUAL(timestamps[i], 1000 + 32 * i);
+    BOOST_REQUIRE_EQUAL(crates[i], i % 7);
+    BOOST_REQUIRE_EQUAL(links[i], i % 64);
+    BOOST_REQUIRE_EQUAL(seqs[i], i % 4096);
+    BOOST_REQUIRE_EQUAL(lengths[i], 0x382);
+  }
+
+  BOOST_REQUIRE_THROW(DAQEthHeaderArrayView(buffer.data(), n, 8), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(DAQHeaderColumns)
+{
+  std::vector<DAQHeader> headers(10);
+  for (std::size_t i = 0; i < headers.size(); ++i) {
+    headers[i] = DAQHeader{};
+    headers[i].slot_id = i % 4;
+    headers[i].link_id = i;
+    headers[i].timestamp_1 = 0xfffffff0u + i;
+    headers[i].timestamp_2 = 1;
+  }
+  DAQHeaderArrayView view(headers.data(), headers.size());
+  BOOST_REQUIRE_EQUAL(view.stride(), sizeof(DAQHeader));
+
+  std::vector<uint64_t> timestamps(headers.size());
+  std::vector<uint8_t> links(headers.size());
+  view.column(HeaderField::kTimestamp, timestamps.data());
+  view.column(HeaderField::kLinkId, links.data());
+  for (std::size_t i = 0; i < headers.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(timestamps[i], headers[i].get_timestamp());
+    BOOST_REQUIRE_EQUAL(links[i], i);
+  }
+
+  BOOST_REQUIRE(!DAQHeaderArrayView::has_field(HeaderField::kSeqId));
+  BOOST_REQUIRE_THROW(view.column(HeaderField::kSeqId, links.data()), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(Selection)
+{
+  std::vector<DAQEthHeader> headers;
+  for (unsigned i = 0; i < 1000; ++i)
+    headers.push_back(make_eth_header(i % 5, i % 2, i % 4, i % 4096, 100 * i));
+  DAQEthHeaderArrayView view(headers.data(), headers.size());
+
+  BOOST_REQUIRE_EQUAL(view.select(HeaderSelection()).size(), headers.size());
+
+  HeaderSelection selection;
+  selection.crate_id = 2;
+  selection.link_id = 3;
+  selection.t0 = 10000;
+  selection.t1 = 50000;
+  std::vector<uint64_t> expected;
+  for (unsigned i = 0; i < headers.size(); ++i)
+    if (i % 5 == 2 && i % 4 == 3 && 100 * i >= 10000 && 100 * i < 50000)
+      expected.push_back(i);
+  const auto selected = view.select(selection);
+  BOOST_REQUIRE(!expected.empty());
+  BOOST_REQUIRE(selected == expected);
+
+  selection = HeaderSelection();
+  selection.det_id = 4;
+  BOOST_REQUIRE(view.select(selection).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
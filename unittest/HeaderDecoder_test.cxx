@@ -0,0 +1,101 @@
+/**
+ * @file HeaderDecoder_test.cxx HeaderDecoder Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/HeaderDecoder.hpp"
+
+#define BOOST_TEST_MODULE HeaderDecoder_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+BOOST_AUTO_TEST_SUITE(HeaderDecoder_test)
+
+BOOST_AUTO_TEST_CASE(DAQEthHeaderDecode)
+{
+  std::vector<DAQEthHeader> headers(3);
+  for (unsigned i = 0; i < headers.size(); ++i) {
+    auto& h = headers[i];
+    h.version = 1;
+    h.det_id = 3;
+    h.crate_id = 1000 + i;
+    h.slot_id = 15;
+    h.stream_id = 200;
+    h.reserved = 0x3F;
+    h.seq_id = 4095 - i;
+    h.block_length = 2049;
+    h.timestamp = 0x0123456789ABCDEFULL + i;
+  }
+
+  std::vector<DecodedHeader> out(headers.size());
+  auto result = decode_headers<DAQEthHeader>(headers.data(), headers.size(), out.data());
+  BOOST_REQUIRE(result.status == DecodeStatus::kOk);
+  BOOST_REQUIRE_EQUAL(result.n_decoded, headers.size());
+  for (unsigned i = 0; i < headers.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(out[i].version, headers[i].version);
+    BOOST_REQUIRE_EQUAL(out[i].det_id, headers[i].det_id);
+    BOOST_REQUIRE_EQUAL(out[i].crate_id, headers[i].crate_id);
+    BOOST_REQUIRE_EQUAL(out[i].slot_id, headers[i].slot_id);
+    BOOST_REQUIRE_EQUAL(out[i].link_id, headers[i].stream_id);
+    BOOST_REQUIRE_EQUAL(out[i].seq_id, headers[i].seq_id);
+    BOOST_REQUIRE_EQUAL(out[i].block_length, headers[i].block_length);
+    BOOST_REQUIRE_EQUAL(out[i].timestamp, headers[i].get_timestamp());
+  }
+
+  headers[2].version = 2;
+  result = decode_headers<DAQEthHeader>(headers.data(), headers.size(), out.data());
+  BOOST_REQUIRE(result.status == DecodeStatus::kMixedVersions);
+
+  headers[0].version = 2;
+  result = decode_headers<DAQEthHeader>(headers.data(), headers.size(), out.data());
+  BOOST_REQUIRE(result.status == DecodeStatus::kUnsupportedVersion);
+  BOOST_REQUIRE_EQUAL(result.n_decoded, 0);
+}
+
+BOOST_AUTO_TEST_CASE(StridedDAQHeaderAndHSIFrame)
+{
+  // DAQHeaders prefixing 20-byte payloads
+  constexpr std::size_t stride = sizeof(DAQHeader) + 20;
+  std::vector<unsigned char> buffer(2 * stride);
+  for (unsigned i = 0; i < 2; ++i) {
+    auto h = reinterpret_cast<DAQHeader*>(buffer.data() + i * stride);
+    h->version = 1;
+    h->det_id = 10;
+    h->crate_id = 513;
+    h->slot_id = 9;
+    h->link_id = 63 - i;
+    h->timestamp_1 = 0xDEADBEEF;
+    h->timestamp_2 = 0x1234 + i;
+  }
+  std::vector<DecodedHeader> out(2);
+  auto result = decode_headers<DAQHeader>(buffer.data(), 2, out.data(), stride);
+  BOOST_REQUIRE(result.status == DecodeStatus::kOk);
+  BOOST_REQUIRE_EQUAL(out[1].link_id, 62);
+  BOOST_REQUIRE_EQUAL(out[1].crate_id, 513);
+  BOOST_REQUIRE_EQUAL(out[1].timestamp, 0x00001235DEADBEEFULL);
+
+  HSIFrame frame;
+  frame.version = 1;
+  frame.detector_id = 1;
+  frame.crate = 7;
+  frame.slot = 2;
+  frame.link = 5;
+  frame.set_timestamp(0xFEDCBA9876543210ULL);
+  frame.sequence = 424242;
+  result = decode_headers<HSIFrame>(&frame, 1, out.data());
+  BOOST_REQUIRE(result.status == DecodeStatus::kOk);
+  BOOST_REQUIRE_EQUAL(out[0].timestamp, frame.get_timestamp());
+  BOOST_REQUIRE_EQUAL(out[0].seq_id, 424242);
+  BOOST_REQUIRE_EQUAL(out[0].link_id, 5);
+
+  BOOST_REQUIRE(decode_headers<HSIFrame>(&frame, 0, out.data()).status == DecodeStatus::kEmpty);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,343 @@
+/**
+ * @file PcapReader_test.cxx PcapReader class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/PcapReader.hpp"
+#include "detdataformats/EthReorderBuffer.hpp"
+#include "detdataformats/HeaderDecoder.hpp"
+
+#define BOOST_TEST_MODULE PcapReader_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+using bytes_t = std::vector<unsigned char>;
+
+void
+put16(bytes_t& out, unsigned v, bool swap = false)
+{
+  uint16_t x = swap ? __builtin_bswap16(v) : v; // NOLINT(build/unsigned)
+  out.insert(out.end(), reinterpret_cast<unsigned char*>(&x), reinterpret_cast<unsigned char*>(&x) + 2);
+}
+
+void
+put32(bytes_t& out, uint32_t v, bool swap = false) // NOLINT(build/unsigned)
+{
+  uint32_t x = swap ? __builtin_bswap32(v) : v; // NOLINT(build/unsigned)
+  out.insert(out.end(), reinterpret_cast<unsigned char*>(&x), reinterpret_cast<unsigned char*>(&x) + 4);
+}
+
+void
+put_be16(bytes_t& out, unsigned v)
+{
+  out.push_back(v >> 8);
+  out.push_back(v & 0xFF);
+}
+
+DAQEthHeader
+make_header(unsigned stream_id, unsigned seq_id)
+{
+  DAQEthHeader h{};
+  h.version = 1;
+  h.det_id = 3;
+  h.crate_id = 5;
+  h.slot_id = 2;
+  h.stream_id = stream_id;
+  h.seq_id = seq_id;
+  h.block_length = 4;
+  h.timestamp = 1000 * seq_id + stream_id;
+  return h;
+}
+
+struct FrameOptions
+{
+  unsigned port{ 1234 };
+  unsigned protocol{ 17 };
+  bool vlan{ false };
+  bool fragment{ false };
+  std::size_t extra{ 16 }; ///< Payload bytes after the DAQEthHeader
+};
+
+// Ethernet / IPv4 / UDP frame carrying a DAQEthHeader
+bytes_t
+make_frame(const DAQEthHeader& h, const FrameOptions& o = FrameOptions())
+{
+  bytes_t f(12, 0);
+  if (o.vlan) {
+    put_be16(f, 0x8100);
+    put_be16(f, 42);
+  }
+  put_be16(f, 0x0800);
+  const std::size_t udp_length = 8 + sizeof(h) + o.extra;
+  f.push_back(0x45);
+  f.push_back(0);
+  put_be16(f, 20 + udp_length);
+  put_be16(f, 0);
+  put_be16(f, o.fragment ? 0x2000 : 0x4000);
+  f.push_back(64);
+  f.push_back(o.protocol);
+  put_be16(f, 0);
+  f.insert(f.end(), 8, 10);
+  put_be16(f, 5000);
+  put_be16(f, o.port);
+  put_be16(f, udp_length);
+  put_be16(f, 0);
+  auto p = reinterpret_cast<const unsigned char*>(&h);
+  f.insert(f.end(), p, p + sizeof(h));
+  for (std::size_t i = 0; i < o.extra; ++i)
+    f.push_back(i);
+  return f;
+}
+
+bytes_t
+pcap_file(const std::vector<bytes_t>& frames, bool swap = false, std::size_t snap = 65535)
+{
+  bytes_t out;
+  put32(out, 0xA1B2C3D4, swap);
+  put16(out, 2, swap);
+  put16(out, 4, swap);
+  put32(out, 0, swap);
+  put32(out, 0, swap);
+  put32(out, snap, swap);
+  put32(out, 1, swap);
+  for (std::size_t i = 0; i < frames.size(); ++i) {
+    const std::size_t captured = std::min(snap, frames[i].size());
+    put32(out, 100 + i, swap);
+    put32(out, 250, swap);
+    put32(out, captured, swap);
+    put32(out, frames[i].size(), swap);
+    out.insert(out.end(), frames[i].begin(), frames[i].begin() + captured);
+  }
+  return out;
+}
+
+bytes_t
+pcapng_file(const std::vector<bytes_t>& frames)
+{
+  bytes_t out;
+  // Section header
+  put32(out, 0x0A0D0D0A);
+  put32(out, 28);
+  put32(out, 0x1A2B3C4D);
+  put16(out, 1);
+  put16(out, 0);
+  put32(out, 0xFFFFFFFF);
+  put32(out, 0xFFFFFFFF);
+  put32(out, 28);
+  // Interface description with nanosecond timestamps
+  put32(out, 1);
+  put32(out, 32);
+  put16(out, 1);
+  put16(out, 0);
+  put32(out, 0);
+  put16(out, 9);
+  put16(out, 1);
+  out.insert(out.end(), { 9, 0, 0, 0 });
+  put32(out, 0);
+  put32(out, 32);
+  // A block this reader doesn't know, to be skipped
+  put32(out, 0x80000001);
+  put32(out, 16);
+  put32(out, 0xDEADBEEF);
+  put32(out, 16);
+  for (std::size_t i = 0; i < frames.size(); ++i) {
+    const std::size_t padded = (frames[i].size() + 3) & ~std::size_t(3);
+    put32(out, 6);
+    put32(out, 32 + padded);
+    put32(out, 0);
+    const uint64_t ts = 5000000000ull + i; // NOLINT(build/unsigned)
+    put32(out, ts >> 32);
+    put32(out, ts & 0xFFFFFFFF);
+    put32(out, frames[i].size());
+    put32(out, frames[i].size());
+    out.insert(out.end(), frames[i].begin(), frames[i].end());
+    out.insert(out.end(), padded - frames[i].size(), 0);
+    put32(out, 32 + padded);
+  }
+  return out;
+}
+
+std::string
+write_temp(const std::string& name, const bytes_t& contents)
+{
+  const std::string path = "/tmp/PcapReader_test_" + std::to_string(::getpid()) + "_" + name;
+  std::ofstream(path, std::ios::binary).write(reinterpret_cast<const char*>(contents.data()), contents.size());
+  return path;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(PcapReader_test)
+
+BOOST_AUTO_TEST_CASE(ClassicPcap)
+{
+  std::vector<bytes_t> frames;
+  for (unsigned i = 0; i < 5; ++i)
+    frames.push_back(make_frame(make_header(1, i)));
+  FrameOptions vlan;
+  vlan.vlan = true;
+  frames.push_back(make_frame(make_header(1, 5), vlan));
+
+  for (bool swap : { false, true }) {
+    const std::string path = write_temp("classic", pcap_file(frames, swap));
+    PcapReader reader(path, PcapReader::Config());
+    BOOST_REQUIRE(reader.format() == PcapReader::Format::kPcap);
+
+    std::vector<PcapPacket> packets;
+    reader.for_each([&](const PcapPacket& p) { packets.push_back(p); });
+    BOOST_REQUIRE_EQUAL(packets.size(), 6);
+    for (unsigned i = 0; i < packets.size(); ++i) {
+      BOOST_REQUIRE_EQUAL(packets[i].size, sizeof(DAQEthHeader) + 16);
+      BOOST_REQUIRE_EQUAL(packets[i].header().seq_id, i);
+      BOOST_REQUIRE_EQUAL(packets[i].header().get_timestamp(), 1000 * i + 1);
+      BOOST_REQUIRE_EQUAL(packets[i].capture_time, (100 + i) * 1000000000ull + 250000);
+      BOOST_REQUIRE_EQUAL(packets[i].stream_key, EthReorderBuffer::stream_key(make_header(1, 0)));
+      BOOST_REQUIRE_EQUAL(packets[i].data[sizeof(DAQEthHeader) + 3], 3);
+    }
+    BOOST_REQUIRE_EQUAL(reader.counters().n_records, 6);
+    BOOST_REQUIRE_EQUAL(reader.counters().n_packets, 6);
+
+    // The payloads go straight into the header decoder
+    std::vector<DecodedHeader> decoded(1);
+    auto result = decode_headers<DAQEthHeader>(packets[3].data, 1, decoded.data());
+    BOOST_REQUIRE(result.status == DecodeStatus::kOk);
+    BOOST_REQUIRE_EQUAL(decoded[0].seq_id, 3);
+    BOOST_REQUIRE_EQUAL(decoded[0].crate_id, 5);
+    std::remove(path.c_str());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(PcapNg)
+{
+  std::vector<bytes_t> frames;
+  for (unsigned i = 0; i < 4; ++i)
+    frames.push_back(make_frame(make_header(i, 7)));
+  const std::string path = write_temp("ng", pcapng_file(frames));
+  PcapReader reader(path, PcapReader::Config());
+  BOOST_REQUIRE(reader.format() == PcapReader::Format::kPcapNg);
+
+  std::vector<PcapPacket> packets;
+  reader.for_each([&](const PcapPacket& p) { packets.push_back(p); });
+  BOOST_REQUIRE_EQUAL(packets.size(), 4);
+  for (unsigned i = 0; i < packets.size(); ++i) {
+    BOOST_REQUIRE_EQUAL(packets[i].header().stream_id, i);
+    BOOST_REQUIRE_EQUAL(packets[i].capture_time, 5000000000ull + i);
+  }
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(SkippedPackets)
+{
+  std::vector<bytes_t> frames;
+  frames.push_back(make_frame(make_header(0, 0)));
+  FrameOptions tcp;
+  tcp.protocol = 6;
+  frames.push_back(make_frame(make_header(0, 1), tcp));
+  FrameOptions fragment;
+  fragment.fragment = true;
+  frames.push_back(make_frame(make_header(0, 2), fragment));
+  FrameOptions other_port;
+  other_port.port = 999;
+  frames.push_back(make_frame(make_header(0, 3), other_port));
+  FrameOptions tiny;
+  tiny.extra = 0;
+  frames.push_back(make_frame(make_header(0, 4)));
+  auto short_frame = make_frame(make_header(0, 5), tiny);
+  short_frame.resize(short_frame.size() - 8);
+  short_frame[17] -= 8; // IP total length
+  short_frame[39] -= 8; // UDP length
+  frames.push_back(short_frame);
+
+  auto contents = pcap_file(frames);
+  // A capture cut by the snap length, and a final record cut by an interrupted capture
+  auto snapped = pcap_file({ make_frame(make_header(0, 6)) }, false, 50);
+  contents.insert(contents.end(), snapped.begin() + 24, snapped.end());
+  auto last = pcap_file({ make_frame(make_header(0, 7)) });
+  contents.insert(contents.end(), last.begin() + 24, last.end() - 10);
+
+  const std::string path = write_temp("skipped", contents);
+  PcapReader::Config config;
+  config.udp_port = 1234;
+  PcapReader reader(path, config);
+  std::vector<unsigned> seq_ids;
+  reader.for_each([&](const PcapPacket& p) { seq_ids.push_back(p.header().seq_id); });
+  BOOST_REQUIRE(seq_ids == std::vector<unsigned>({ 0, 4 }));
+
+  auto const& c = reader.counters();
+  BOOST_REQUIRE_EQUAL(c.n_records, 7);
+  BOOST_REQUIRE_EQUAL(c.n_packets, 2);
+  BOOST_REQUIRE_EQUAL(c.n_not_udp, 1);
+  BOOST_REQUIRE_EQUAL(c.n_fragments, 1);
+  BOOST_REQUIRE_EQUAL(c.n_other_port, 1);
+  BOOST_REQUIRE_EQUAL(c.n_too_short, 1);
+  BOOST_REQUIRE_EQUAL(c.n_truncated, 2);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(ParallelByStream)
+{
+  const unsigned n_streams = 13;
+  const unsigned n_per_stream = 300;
+  std::vector<bytes_t> frames;
+  for (unsigned i = 0; i < n_per_stream; ++i)
+    for (unsigned s = 0; s < n_streams; ++s)
+      frames.push_back(make_frame(make_header(s, i)));
+  const std::string path = write_temp("parallel", pcap_file(frames));
+
+  PcapReader::Config config;
+  config.batch_packets = 100;
+  PcapReader reader(path, config);
+  const unsigned n_threads = 4;
+  // Per-thread state only: streams never move between threads
+  std::vector<std::map<unsigned, std::vector<unsigned>>> seen(n_threads);
+  std::vector<unsigned> misrouted(n_threads, 0);
+  reader.for_each_parallel(
+    [&](unsigned thread, const PcapPacket& p) {
+      misrouted[thread] += thread != PcapReader::thread_of(p.stream_key, n_threads);
+      seen[thread][p.header().stream_id].push_back(p.header().seq_id);
+    },
+    n_threads);
+  BOOST_REQUIRE(misrouted == std::vector<unsigned>(n_threads, 0));
+
+  std::size_t total = 0;
+  for (auto const& per_thread : seen)
+    for (auto const& [stream, seq_ids] : per_thread) {
+      BOOST_REQUIRE_EQUAL(seq_ids.size(), n_per_stream);
+      for (unsigned i = 0; i < n_per_stream; ++i)
+        BOOST_REQUIRE_EQUAL(seq_ids[i], i);
+      total += seq_ids.size();
+    }
+  BOOST_REQUIRE_EQUAL(total, frames.size());
+  BOOST_REQUIRE_EQUAL(reader.counters().n_packets, frames.size());
+
+  // Exceptions from the callback reach the caller
+  BOOST_REQUIRE_THROW(reader.for_each_parallel([](unsigned, const PcapPacket&) { throw std::logic_error("x"); }, 2),
+                      std::logic_error);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BadFiles)
+{
+  BOOST_REQUIRE_THROW(PcapReader("/nonexistent_directory/capture.pcap", PcapReader::Config()), std::runtime_error);
+  const std::string path = write_temp("bad", bytes_t(100, 0x55));
+  BOOST_REQUIRE_THROW(PcapReader(path, PcapReader::Config()), std::runtime_error);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,222 @@
+/**
+ * @file PedestalTracker_test.cxx PedestalTracker class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/PedestalTracker.hpp"
+
+#define BOOST_TEST_MODULE PedestalTracker_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+fwtp::TpHeader
+make_header(unsigned wire, unsigned median, unsigned accumulator = 0)
+{
+  fwtp::TpHeader header;
+  header.m_crate_no = 1;
+  header.m_slot_no = 2;
+  header.m_fiber_no = 3;
+  header.m_wire_no = wire;
+  header.m_flags = 0;
+  header.m_median = median;
+  header.m_accumulator = accumulator;
+  header.set_timestamp(1000);
+  header.set_nhits(0);
+  return header;
+}
+
+FwtpChannelMap
+make_map()
+{
+  FwtpChannelMap map;
+  for (unsigned wire = 0; wire < 64; ++wire)
+    map.add(1, 2, 3, wire, wire);
+  map.compile();
+  return map;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(PedestalTracker_test)
+
+BOOST_AUTO_TEST_CASE(MeanAndRmsMatchTwoPass)
+{
+  auto map = make_map();
+  FwtpPedestalTracker tracker(map);
+
+  // Several batches of different sizes, with a large offset to exercise the shifted sums
+  std::vector<double> values;
+  unsigned seed = 12345;
+  for (int batch = 0; batch < 20; ++batch) {
+    std::vector<fwtp::TpHeader> headers;
+    for (int i = 0; i < 3 + batch * 7; ++i) {
+      seed = seed * 1103515245 + 12345;
+      const unsigned median = 9000 + (seed >> 16) % 41;
+      headers.push_back(make_header(5, median));
+      values.push_back(median);
+    }
+    tracker.process_headers(headers.data(), headers.size());
+  }
+
+  double mean = 0;
+  for (auto v : values)
+    mean += v;
+  mean /= values.size();
+  double var = 0;
+  for (auto v : values)
+    var += (v - mean) * (v - mean);
+  var /= values.size();
+
+  const ChannelPedestal p = tracker.stats(5);
+  BOOST_REQUIRE_EQUAL(p.n_samples, values.size());
+  BOOST_REQUIRE_SMALL(p.mean - mean, 1e-3);
+  BOOST_REQUIRE_SMALL(p.rms - std::sqrt(var), 1e-3);
+  BOOST_REQUIRE_EQUAL(p.last_median, values.back());
+  BOOST_REQUIRE_EQUAL(tracker.n_samples(), values.size());
+  BOOST_REQUIRE_EQUAL(tracker.n_batches(), 20);
+  BOOST_REQUIRE(std::isnan(tracker.stats(6).mean));
+}
+
+BOOST_AUTO_TEST_CASE(DenseBatchUpdatesEveryChannel)
+{
+  auto map = make_map();
+  FwtpPedestalTracker tracker(map);
+
+  std::vector<fwtp::TpHeader> headers;
+  for (unsigned rep = 0; rep < 2; ++rep)
+    for (unsigned wire = 0; wire < 64; ++wire)
+      headers.push_back(make_header(wire, 100 * wire + 2 * rep, 7));
+  headers.push_back(make_header(200, 1)); // not in the map
+  tracker.process_headers(headers.data(), headers.size());
+
+  BOOST_REQUIRE_EQUAL(tracker.n_unmapped(), 1);
+  for (unsigned wire = 0; wire < 64; ++wire) {
+    const ChannelPedestal p = tracker.stats(wire);
+    BOOST_REQUIRE_EQUAL(p.n_samples, 2);
+    BOOST_REQUIRE_CLOSE(p.mean, 100. * wire + 1, 1e-4);
+    BOOST_REQUIRE_CLOSE(p.rms, 1., 1e-4);
+    BOOST_REQUIRE_EQUAL(p.last_accumulator, 7);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(RawFramesAreParsed)
+{
+  auto map = make_map();
+  FwtpPedestalTracker tracker(map);
+
+  std::vector<unsigned char> bytes;
+  for (unsigned i = 0; i < 10; ++i) {
+    auto header = make_header(i % 2, 500 + i);
+    header.set_nhits(1);
+    auto p = reinterpret_cast<const unsigned char*>(&header);
+    bytes.insert(bytes.end(), p, p + sizeof(header));
+    fwtp::TpData d{};
+    auto q = reinterpret_cast<const unsigned char*>(&d);
+    bytes.insert(bytes.end(), q, q + sizeof(d));
+  }
+  const std::size_t full = bytes.size();
+  bytes.resize(full + 10); // truncated trailing frame
+
+  BOOST_REQUIRE_EQUAL(tracker.process(bytes.data(), bytes.size()), full);
+  BOOST_REQUIRE_EQUAL(tracker.stats(0).n_samples, 5);
+  BOOST_REQUIRE_CLOSE(tracker.stats(0).mean, 504., 1e-4);
+  BOOST_REQUIRE_CLOSE(tracker.stats(1).mean, 505., 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(DriftRaisesAndClearsAlarm)
+{
+  auto map = make_map();
+  FwtpPedestalTracker::Config config;
+  config.warmup_samples = 100;
+  config.recent_weight = 0.5;
+  config.drift_threshold = 3;
+  FwtpPedestalTracker tracker(map, config);
+
+  auto feed = [&tracker](unsigned median, int n) {
+    std::vector<fwtp::TpHeader> headers(n, make_header(9, median));
+    tracker.process_headers(headers.data(), headers.size());
+  };
+
+  feed(800, 50);
+  BOOST_REQUIRE(std::isnan(tracker.stats(9).reference));
+  feed(800, 50);
+  BOOST_REQUIRE_CLOSE(tracker.stats(9).reference, 800., 1e-4);
+  BOOST_REQUIRE_EQUAL(tracker.n_alarms(), 0);
+
+  feed(810, 10);
+  feed(810, 10);
+  BOOST_REQUIRE(tracker.stats(9).alarm);
+  BOOST_REQUIRE_EQUAL(tracker.n_alarms(), 1);
+  // The long-run mean barely moves, which is why the alarm uses recent_mean
+  BOOST_REQUIRE_LT(tracker.stats(9).mean, 802);
+
+  for (int i = 0; i < 10; ++i)
+    feed(800, 10);
+  BOOST_REQUIRE(!tracker.stats(9).alarm);
+  BOOST_REQUIRE_EQUAL(tracker.n_alarms(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(SnapshotIsConsistent)
+{
+  auto map = make_map();
+  FwtpPedestalTracker tracker(map);
+
+  PedestalSnapshot snap;
+  tracker.snapshot(snap);
+  BOOST_REQUIRE_EQUAL(snap.generation, 0);
+  BOOST_REQUIRE_EQUAL(snap.channels.size(), 64);
+  BOOST_REQUIRE_EQUAL(snap.channels[0].n_samples, 0);
+
+  // Every batch gives all channels the same sample count, so a torn copy would show mixed counts
+  std::atomic<bool> done{ false };
+  std::atomic<int> n_bad{ 0 };
+  std::thread reader([&]() {
+    PedestalSnapshot s;
+    while (!done.load()) {
+      tracker.snapshot(s);
+      for (auto const& c : s.channels)
+        if (c.n_samples != s.channels[0].n_samples || c.n_samples != s.generation)
+          ++n_bad;
+    }
+  });
+
+  std::vector<fwtp::TpHeader> headers;
+  for (unsigned wire = 0; wire < 64; ++wire)
+    headers.push_back(make_header(wire, 1000));
+  for (int i = 0; i < 2000; ++i) {
+    tracker.process_headers(headers.data(), headers.size());
+    tracker.publish();
+  }
+  done = true;
+  reader.join();
+
+  BOOST_REQUIRE_EQUAL(n_bad.load(), 0);
+  tracker.snapshot(snap);
+  BOOST_REQUIRE_EQUAL(snap.generation, 2000);
+  BOOST_REQUIRE_EQUAL(snap.channels[63].n_samples, 2000);
+}
+
+BOOST_AUTO_TEST_CASE(RejectsBadConfig)
+{
+  auto map = make_map();
+  FwtpPedestalTracker::Config config;
+  config.recent_weight = 0;
+  BOOST_REQUIRE_THROW(FwtpPedestalTracker(map, config), std::invalid_argument);
+  FwtpChannelMap uncompiled;
+  BOOST_REQUIRE_THROW(FwtpPedestalTracker{ uncompiled }, std::invalid_argument);
+  BOOST_REQUIRE_THROW(FwtpPedestalTracker(map).stats(64), std::out_of_range);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
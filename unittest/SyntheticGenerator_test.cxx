@@ -0,0 +1,306 @@
+/**
+ * @file SyntheticGenerator_test.cxx SyntheticGenerator class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/SyntheticGenerator.hpp"
+#include "detdataformats/TpFrame.hpp"
+
+#define BOOST_TEST_MODULE SyntheticGenerator_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+std::vector<unsigned char>
+generate_in_chunks(const SyntheticConfig& config, std::size_t total, std::size_t chunk)
+{
+  SyntheticGenerator gen(config);
+  std::vector<unsigned char> out(total);
+  std::size_t used = 0;
+  while (true) {
+    const std::size_t n = gen.generate(out.data() + used, std::min(chunk, total - used));
+    if (n == 0)
+      break;
+    used += n;
+  }
+  out.resize(used);
+  return out;
+}
+
+std::vector<DAQEthHeader>
+eth_headers(const std::vector<unsigned char>& bytes, std::size_t frame_size)
+{
+  std::vector<DAQEthHeader> headers(bytes.size() / frame_size);
+  for (std::size_t i = 0; i < headers.size(); ++i)
+    std::memcpy(&headers[i], bytes.data() + i * frame_size, sizeof(DAQEthHeader));
+  return headers;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(SyntheticGenerator_test)
+
+BOOST_AUTO_TEST_CASE(StreamDoesNotDependOnChunking)
+{
+  SyntheticConfig config;
+  config.nhits = SyntheticDistribution::poisson(2, 1);
+  config.faults.reorder = 0.05;
+  config.faults.gap = 0.01;
+
+  const auto whole = generate_in_chunks(config, 1 << 20, 1 << 20);
+  const auto chunked = generate_in_chunks(config, 1 << 20, 1000);
+  BOOST_REQUIRE_GT(whole.size(), (1 << 20) - config.max_nhits * sizeof(fwtp::TpData) * 2 - sizeof(fwtp::TpHeader) * 2);
+  BOOST_REQUIRE(chunked.size() <= whole.size());
+  BOOST_REQUIRE(std::equal(chunked.begin(), chunked.end(), whole.begin()));
+
+  config.seed = 2;
+  const auto other = generate_in_chunks(config, 1 << 16, 1 << 16);
+  BOOST_REQUIRE(!std::equal(other.begin(), other.end(), whole.begin()));
+}
+
+BOOST_AUTO_TEST_CASE(TpFramesAreWellFormed)
+{
+  for (auto format : { SyntheticFormat::kFwtp, SyntheticFormat::kWIBTp }) {
+    SyntheticConfig config;
+    config.format = format;
+    config.crate = 3;
+    config.slot = 2;
+    config.link = 5;
+    config.n_channels = 16;
+    config.start_timestamp = 1000000;
+    config.nhits = SyntheticDistribution::uniform(1, 4);
+    SyntheticGenerator gen(config);
+    std::vector<unsigned char> bytes(1 << 16);
+    bytes.resize(gen.generate(bytes.data(), bytes.size()));
+
+    std::size_t n_frames = 0, n_hits = 0;
+    uint64_t last_ts = 0; // NOLINT(build/unsigned)
+    auto check = [&](const auto& frame) {
+      BOOST_REQUIRE_EQUAL(frame.header->m_crate_no, 3);
+      BOOST_REQUIRE_EQUAL(frame.header->m_slot_no, 2);
+      BOOST_REQUIRE_EQUAL(frame.header->m_fiber_no, 5);
+      BOOST_REQUIRE_LT(frame.header->m_wire_no, 16);
+      BOOST_REQUIRE_GE(frame.get_timestamp(), std::max<uint64_t>(last_ts, 1000000)); // NOLINT(build/unsigned)
+      BOOST_REQUIRE(frame.nhits >= 1 && frame.nhits <= 4);
+      for (std::size_t i = 0; i < frame.nhits; ++i)
+        BOOST_REQUIRE_LT(frame.hits[i].m_start_time, frame.hits[i].m_end_time);
+      last_ts = frame.get_timestamp();
+      ++n_frames;
+      n_hits += frame.nhits;
+    };
+    std::size_t consumed = 0;
+    if (format == SyntheticFormat::kFwtp) {
+      FwtpFrameRange frames(bytes.data(), bytes.size());
+      for (auto it = frames.begin(); it != frames.end(); ++it) {
+        check(*it);
+        consumed = it.position() + it->size() - bytes.data();
+      }
+    } else {
+      WIBFrameRange frames(bytes.data(), bytes.size());
+      for (auto it = frames.begin(); it != frames.end(); ++it) {
+        check(*it);
+        consumed = it.position() + it->size() - bytes.data();
+      }
+    }
+    BOOST_REQUIRE_EQUAL(consumed, bytes.size());
+    BOOST_REQUIRE_EQUAL(n_frames, gen.counters().frames);
+    BOOST_REQUIRE_EQUAL(n_hits, gen.counters().hits);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(HitRateSetsTimestampSpacing)
+{
+  SyntheticConfig config;
+  config.n_channels = 100;
+  config.hit_rate_hz = 625; // 62.5 kHz per link, so 1000 ticks between frames
+  config.poisson_arrivals = false;
+  SyntheticGenerator gen(config);
+  std::vector<unsigned char> bytes(100 * sizeof(fwtp::TpHeader) + 100 * sizeof(fwtp::TpData));
+  bytes.resize(gen.generate(bytes.data(), bytes.size()));
+  FwtpFrameRange frames(bytes.data(), bytes.size());
+  uint64_t expected = 0; // NOLINT(build/unsigned)
+  for (auto const& frame : frames) {
+    BOOST_REQUIRE_EQUAL(frame.get_timestamp(), expected);
+    expected += 1000;
+  }
+  BOOST_REQUIRE_EQUAL(expected, 100 * 1000);
+
+  config.poisson_arrivals = true;
+  SyntheticGenerator poisson(config);
+  std::vector<unsigned char> many(100000 * (sizeof(fwtp::TpHeader) + sizeof(fwtp::TpData)));
+  many.resize(poisson.generate(many.data(), many.size()));
+  BOOST_REQUIRE_CLOSE(double(poisson.next_timestamp()) / poisson.counters().frames, 1000., 2.);
+}
+
+BOOST_AUTO_TEST_CASE(EthSequenceGapsAndReordering)
+{
+  SyntheticConfig config;
+  config.format = SyntheticFormat::kDAQEthHeader;
+  config.crate = 7;
+  config.link = 200;
+  config.payload_bytes = 64;
+  config.faults.gap = 0.01;
+  SyntheticGenerator gen(config);
+  const std::size_t frame_size = sizeof(DAQEthHeader) + 64;
+  std::vector<unsigned char> bytes(20000 * frame_size);
+  BOOST_REQUIRE_EQUAL(gen.generate(bytes.data(), bytes.size()), bytes.size());
+
+  auto headers = eth_headers(bytes, frame_size);
+  std::size_t missing = 0;
+  for (std::size_t i = 1; i < headers.size(); ++i) {
+    const unsigned step = (headers[i].seq_id - headers[i - 1].seq_id) & 0xFFF;
+    BOOST_REQUIRE_EQUAL(headers[i].timestamp - headers[i - 1].timestamp, step * config.frame_period);
+    missing += step - 1;
+  }
+  BOOST_REQUIRE_EQUAL(headers[0].crate_id, 7);
+  BOOST_REQUIRE_EQUAL(headers[0].stream_id, 200);
+  BOOST_REQUIRE_EQUAL(headers[0].block_length, 8);
+  BOOST_REQUIRE_EQUAL(headers[0].version, 1);
+  BOOST_REQUIRE_EQUAL(missing + (headers[0].seq_id), gen.counters().gaps);
+  BOOST_REQUIRE_GT(gen.counters().gaps, 100);
+
+  config.faults.gap = 0;
+  config.faults.reorder = 0.1;
+  SyntheticGenerator reordering(config);
+  BOOST_REQUIRE_EQUAL(reordering.generate(bytes.data(), bytes.size()), bytes.size());
+  headers = eth_headers(bytes, frame_size);
+  std::size_t swapped = 0;
+  for (std::size_t i = 0; i < headers.size(); ++i) {
+    const unsigned seq = headers[i].seq_id;
+    if (seq == (i & 0xFFF))
+      continue;
+    // A reordered pair shows up as (n + 1, n)
+    BOOST_REQUIRE_EQUAL(seq, (i + 1) & 0xFFF);
+    BOOST_REQUIRE_EQUAL(headers[i + 1].seq_id, i & 0xFFF);
+    ++swapped;
+    ++i;
+  }
+  BOOST_REQUIRE_EQUAL(swapped, reordering.counters().reordered);
+  BOOST_REQUIRE_GT(swapped, 500);
+}
+
+BOOST_AUTO_TEST_CASE(CorruptionFlipsOneBit)
+{
+  SyntheticConfig config;
+  config.format = SyntheticFormat::kHSI;
+  config.link = 9;
+  SyntheticGenerator clean(config);
+  config.faults.corruption = 1;
+  SyntheticGenerator corrupt(config);
+
+  // Corruption draws extra random numbers, so compare frame by frame from a fresh pair each time
+  std::vector<unsigned char> a(sizeof(HSIFrame)), b(sizeof(HSIFrame));
+  BOOST_REQUIRE_EQUAL(clean.generate(a.data(), a.size()), sizeof(HSIFrame));
+  BOOST_REQUIRE_EQUAL(corrupt.generate(b.data(), b.size()), sizeof(HSIFrame));
+  int flipped = 0;
+  for (std::size_t i = 0; i < a.size(); ++i)
+    flipped += __builtin_popcount(a[i] ^ b[i]);
+  BOOST_REQUIRE_EQUAL(flipped, 1);
+  BOOST_REQUIRE_EQUAL(corrupt.counters().corrupted, 1);
+
+  HSIFrame frame;
+  std::memcpy(&frame, a.data(), sizeof(frame));
+  BOOST_REQUIRE_EQUAL(frame.link, 9);
+  BOOST_REQUIRE_EQUAL(frame.sequence, 0);
+  BOOST_REQUIRE_EQUAL(frame.trigger, frame.input_low);
+}
+
+BOOST_AUTO_TEST_CASE(ParallelMatchesSerial)
+{
+  std::vector<SyntheticGenerator> serial, parallel;
+  for (unsigned link = 0; link < 6; ++link) {
+    SyntheticConfig config;
+    config.format = SyntheticFormat::kDAQHeader;
+    config.link = link;
+    config.payload_bytes = 456;
+    serial.emplace_back(config);
+    parallel.emplace_back(config);
+  }
+  std::vector<std::vector<unsigned char>> a(6, std::vector<unsigned char>(1 << 16)), b = a;
+  std::vector<std::pair<void*, std::size_t>> buffers;
+  for (unsigned i = 0; i < 6; ++i) {
+    BOOST_REQUIRE_EQUAL(serial[i].generate(a[i].data(), a[i].size()), (1 << 16) / 468 * 468);
+    buffers.emplace_back(b[i].data(), b[i].size());
+  }
+  const auto written = generate_parallel(parallel, buffers, 3);
+  for (unsigned i = 0; i < 6; ++i) {
+    BOOST_REQUIRE_EQUAL(written[i], (1 << 16) / 468 * 468);
+    BOOST_REQUIRE(a[i] == b[i]);
+    DAQHeader header;
+    std::memcpy(&header, b[i].data() + 468, sizeof(header));
+    BOOST_REQUIRE_EQUAL(header.link_id, i);
+    BOOST_REQUIRE_EQUAL(header.get_timestamp(), 2048);
+  }
+  BOOST_REQUIRE(a[0] != a[1]);
+}
+
+BOOST_AUTO_TEST_CASE(WriteFile)
+{
+  SyntheticConfig config;
+  config.format = SyntheticFormat::kHSI;
+  SyntheticGenerator gen(config);
+  const std::string path = "/tmp/SyntheticGenerator_test_" + std::to_string(::getpid()) + ".bin";
+  const uint64_t n = gen.write_file(path, 1000 * sizeof(HSIFrame) + 5, 4096); // NOLINT(build/unsigned)
+  BOOST_REQUIRE_EQUAL(n, 1000 * sizeof(HSIFrame));
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  BOOST_REQUIRE_EQUAL(static_cast<uint64_t>(ifs.tellg()), n); // NOLINT(build/unsigned)
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(WriteFilesParallel)
+{
+  std::vector<SyntheticGenerator> generators;
+  std::vector<std::string> paths;
+  for (unsigned link = 0; link < 4; ++link) {
+    SyntheticConfig config;
+    config.format = SyntheticFormat::kHSI;
+    config.link = link;
+    generators.emplace_back(config);
+    paths.push_back("/tmp/SyntheticGenerator_test_" + std::to_string(::getpid()) + "_" + std::to_string(link) + ".bin");
+  }
+  const auto written = write_files_parallel(generators, paths, 100 * sizeof(HSIFrame), 4096, 3);
+  for (unsigned link = 0; link < 4; ++link) {
+    BOOST_REQUIRE_EQUAL(written[link], 100 * sizeof(HSIFrame));
+    std::ifstream ifs(paths[link], std::ios::binary);
+    HSIFrame frame;
+    ifs.read(reinterpret_cast<char*>(&frame), sizeof(frame));
+    BOOST_REQUIRE_EQUAL(frame.link, link);
+    std::remove(paths[link].c_str());
+  }
+
+  // An I/O error in a worker thread reaches the caller
+  paths[2] = "/nonexistent_directory/SyntheticGenerator_test.bin";
+  BOOST_REQUIRE_THROW(write_files_parallel(generators, paths, 100 * sizeof(HSIFrame), 4096, 3), std::runtime_error);
+  for (auto const& path : paths)
+    std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(RejectsBadConfig)
+{
+  SyntheticConfig config;
+  config.format = SyntheticFormat::kWIBTp;
+  config.crate = 32;
+  BOOST_REQUIRE_THROW(SyntheticGenerator{ config }, std::invalid_argument);
+  config = SyntheticConfig();
+  config.format = SyntheticFormat::kDAQEthHeader;
+  config.payload_bytes = 100;
+  BOOST_REQUIRE_THROW(SyntheticGenerator{ config }, std::invalid_argument);
+  config = SyntheticConfig();
+  config.faults.gap = 1;
+  BOOST_REQUIRE_THROW(SyntheticGenerator{ config }, std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
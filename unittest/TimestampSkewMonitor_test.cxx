@@ -0,0 +1,156 @@
+/**
+ * @file TimestampSkewMonitor_test.cxx TimestampSkewMonitor class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/TimestampSkewMonitor.hpp"
+
+#define BOOST_TEST_MODULE TimestampSkewMonitor_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+const uint64_t s_start = 1ull << 56; // NOLINT(build/unsigned)
+
+DAQEthHeader
+eth_header(unsigned stream, uint64_t timestamp)
+{
+  DAQEthHeader h{};
+  h.crate_id = 1;
+  h.stream_id = stream;
+  h.timestamp = timestamp;
+  return h;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TimestampSkewMonitor_test)
+
+BOOST_AUTO_TEST_CASE(FitsOffsetAndDrift)
+{
+  TimestampSkewMonitor::Config config;
+  TimestampSkewMonitor monitor(config);
+
+  // Offset of 1000 ticks growing by 20 ppm, with +-50 ticks of latency noise
+  std::mt19937_64 rng(1);
+  std::uniform_int_distribution<int> noise(-50, 50);
+  uint64_t reference = s_start;
+  for (unsigned i = 0; i < 20000; ++i) {
+    reference += 62500;
+    const double offset = 1000 + 20e-6 * (reference - s_start);
+    monitor.sample(eth_header(0, reference + std::llround(offset) + noise(rng)), reference);
+  }
+
+  LinkClockFit fit;
+  BOOST_REQUIRE(monitor.fit(TimestampSkewMonitor::link_of(eth_header(0, 0)), fit));
+  BOOST_REQUIRE(!monitor.fit(TimestampSkewMonitor::link_of(eth_header(1, 0)), fit));
+  BOOST_REQUIRE_EQUAL(fit.n_samples, 20000u);
+  const double expected = 1000 + 20e-6 * (reference - s_start);
+  BOOST_REQUIRE_SMALL(fit.offset - expected, 5.);
+  BOOST_REQUIRE_SMALL(fit.drift * 1e6 - 20, 0.2);
+  BOOST_REQUIRE(fit.jitter > 20 && fit.jitter < 40); // Uniform noise of +-50 has an RMS of 29
+}
+
+BOOST_AUTO_TEST_CASE(FlagsMisalignedLinks)
+{
+  TimestampSkewMonitor::Config config;
+  config.offset_tolerance = 100;
+  config.drift_tolerance_ppm = 5;
+  TimestampSkewMonitor monitor(config);
+
+  // Eight aligned streams, one 500 ticks late, one drifting by 50 ppm, and a DAQHeader link
+  // with the same geometry as stream 0
+  uint64_t reference = s_start;
+  for (unsigned i = 0; i < 2000; ++i) {
+    reference += 62500;
+    const uint64_t elapsed = reference - s_start;
+    for (unsigned stream = 0; stream < 10; ++stream) {
+      uint64_t timestamp = reference + 300 + (i * 7 + stream * 13) % 40;
+      if (stream == 8)
+        timestamp -= 500;
+      if (stream == 9)
+        timestamp += elapsed / 20000;
+      monitor.sample(eth_header(stream, timestamp), reference);
+    }
+    DAQHeader h{};
+    h.crate_id = 1;
+    h.timestamp_1 = (reference + 310) & 0xFFFFFFFF;
+    h.timestamp_2 = (reference + 310) >> 32;
+    monitor.sample(h, reference);
+  }
+  BOOST_REQUIRE_EQUAL(monitor.n_links(), 11u);
+
+  const auto report = monitor.report();
+  BOOST_REQUIRE(report.has_reference);
+  BOOST_REQUIRE_SMALL(report.reference_offset - 320, 20.);
+  BOOST_REQUIRE_EQUAL(report.n_flagged, 2u);
+  for (const auto& status : report.links) {
+    if (status.link == TimestampSkewMonitor::link_of(eth_header(8, 0))) {
+      BOOST_REQUIRE(status.offset_out && !status.drift_out);
+      BOOST_REQUIRE_SMALL(status.skew + 500, 20.);
+    } else if (status.link == TimestampSkewMonitor::link_of(eth_header(9, 0))) {
+      BOOST_REQUIRE(status.drift_out);
+      BOOST_REQUIRE_SMALL(status.drift_ppm - 50, 1.);
+    } else {
+      BOOST_REQUIRE(!status.flagged());
+    }
+  }
+
+  // Against stream 8, everything but stream 8 is late
+  config.reference_link = TimestampSkewMonitor::link_of(eth_header(8, 0));
+  TimestampSkewMonitor against_8(config);
+  for (unsigned i = 0; i < 100; ++i) {
+    reference += 62500;
+    against_8.sample(eth_header(8, reference - 200), reference);
+    against_8.sample(eth_header(0, reference + 300), reference);
+  }
+  const auto report_8 = against_8.report();
+  BOOST_REQUIRE(report_8.has_reference);
+  BOOST_REQUIRE_EQUAL(report_8.n_flagged, 1u);
+  BOOST_REQUIRE_SMALL(report_8.links[0].skew - 500, 1.);
+}
+
+BOOST_AUTO_TEST_CASE(BoundedLinks)
+{
+  TimestampSkewMonitor::Config config;
+  config.max_links = 4;
+  config.min_samples = 1000;
+  TimestampSkewMonitor monitor(config);
+  for (unsigned stream = 0; stream < 10; ++stream)
+    monitor.sample(eth_header(stream, s_start), s_start);
+  BOOST_REQUIRE_EQUAL(monitor.n_links(), 4u);
+  BOOST_REQUIRE_EQUAL(monitor.counters().n_samples, 10u);
+  BOOST_REQUIRE_EQUAL(monitor.counters().n_dropped, 6u);
+
+  // Not enough samples for a reference
+  const auto report = monitor.report();
+  BOOST_REQUIRE(!report.has_reference);
+  BOOST_REQUIRE_EQUAL(report.links.size(), 4u);
+  BOOST_REQUIRE_EQUAL(report.n_flagged, 0u);
+
+  monitor.clear();
+  BOOST_REQUIRE_EQUAL(monitor.n_links(), 0u);
+
+  // Any id is a valid link, including the one that marks "no reference link"
+  monitor.sample(TimestampSkewMonitor::s_no_link, s_start, s_start);
+  monitor.sample(TimestampSkewMonitor::s_no_link, s_start + 10, s_start + 5);
+  LinkClockFit fit;
+  BOOST_REQUIRE(monitor.fit(TimestampSkewMonitor::s_no_link, fit));
+  BOOST_REQUIRE_EQUAL(fit.n_samples, 2u);
+  BOOST_REQUIRE_EQUAL(monitor.n_links(), 1u);
+
+  config.memory_samples = 1;
+  BOOST_REQUIRE_THROW(TimestampSkewMonitor{ config }, std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,164 @@
+/**
+ * @file TpArchive_test.cxx TpArchiveWriter/TpArchiveReader Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/TpArchive.hpp"
+
+#define BOOST_TEST_MODULE TpArchive_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+std::string
+temp_path(const std::string& name)
+{
+  return "/tmp/" + name + "_" + std::to_string(::getpid());
+}
+
+std::vector<unsigned char>
+make_frames(unsigned n_frames)
+{
+  std::vector<unsigned char> bytes;
+  for (unsigned f = 0; f < n_frames; ++f) {
+    wib::TpHeader header;
+    header.m_flags = 0;
+    header.m_crate_no = f % 4;
+    header.m_slot_no = 1;
+    header.m_fiber_no = 2;
+    header.m_wire_no = f % 256;
+    header.m_median = 900;
+    header.m_accumulator = f;
+    header.set_timestamp(0x100000000ULL + 32 * f);
+    header.set_nhits(2);
+    auto p = reinterpret_cast<const unsigned char*>(&header);
+    bytes.insert(bytes.end(), p, p + sizeof(header));
+    for (unsigned h = 0; h < 2; ++h) {
+      wib::TpData d{};
+      d.m_start_time = h * 10;
+      d.m_end_time = h * 10 + 5;
+      d.m_peak_time = h * 10 + 2;
+      d.m_peak_adc = 100 + f % 50;
+      d.m_sum_adc = 1000 + f;
+      d.m_hit_continue = h;
+      auto q = reinterpret_cast<const unsigned char*>(&d);
+      bytes.insert(bytes.end(), q, q + sizeof(d));
+    }
+  }
+  return bytes;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TpArchive_test)
+
+BOOST_AUTO_TEST_CASE(RoundTripAndPruning)
+{
+  const auto path = temp_path("TpArchive_roundtrip");
+  const unsigned n_frames = 1000;
+  auto bytes = make_frames(n_frames);
+  {
+    TpArchiveWriter writer(path, 100);
+    BOOST_REQUIRE_EQUAL((writer.append_frames<wib::TpHeader, wib::TpData>(bytes.data(), bytes.size())), bytes.size());
+    writer.close();
+    BOOST_REQUIRE_EQUAL(writer.n_rows(), 2 * n_frames);
+  }
+
+  TpArchiveReader reader(path);
+  BOOST_REQUIRE_EQUAL(reader.n_rows(), 2 * n_frames);
+  BOOST_REQUIRE_EQUAL(reader.n_row_groups(), 20);
+  // Constant columns take no space, narrow ones one byte
+  BOOST_REQUIRE_EQUAL(reader.row_group(0).columns[tparchive::kMedian].width, 0);
+  BOOST_REQUIRE_EQUAL(reader.row_group(0).columns[tparchive::kCrate].width, 1);
+  BOOST_REQUIRE_EQUAL(reader.row_group(0).columns[tparchive::kTimestamp].width, 2);
+
+  std::vector<TpRow> rows;
+  BOOST_REQUIRE_EQUAL(reader.query(TpQuery{}, rows), 20);
+  BOOST_REQUIRE_EQUAL(rows.size(), 2 * n_frames);
+  for (unsigned i = 0; i < rows.size(); ++i) {
+    const unsigned f = i / 2;
+    BOOST_REQUIRE_EQUAL(rows[i].timestamp, 0x100000000ULL + 32 * f);
+    BOOST_REQUIRE_EQUAL(rows[i].crate, f % 4);
+    BOOST_REQUIRE_EQUAL(rows[i].wire, f % 256);
+    BOOST_REQUIRE_EQUAL(rows[i].accumulator, f);
+    BOOST_REQUIRE_EQUAL(rows[i].median, 900);
+    BOOST_REQUIRE_EQUAL(rows[i].sum_adc, 1000 + f);
+    BOOST_REQUIRE_EQUAL(rows[i].hit_continue, i % 2);
+    BOOST_REQUIRE_EQUAL(rows[i].start_time, (i % 2) * 10);
+  }
+
+  // Frames 140..159 live in row groups 2 and 3 only (50 frames per group)
+  TpQuery q;
+  q.timestamp_begin = 0x100000000ULL + 32 * 140;
+  q.timestamp_end = 0x100000000ULL + 32 * 160;
+  q.crate_min = q.crate_max = 3;
+  rows.clear();
+  BOOST_REQUIRE_EQUAL(reader.query(q, rows), 2);
+  BOOST_REQUIRE_EQUAL(rows.size(), 2 * 5);
+  for (auto const& r : rows)
+    BOOST_REQUIRE_EQUAL(r.crate, 3);
+
+  q = TpQuery{};
+  q.fiber_min = 3;
+  rows.clear();
+  BOOST_REQUIRE_EQUAL(reader.query(q, rows), 0);
+  BOOST_REQUIRE(rows.empty());
+
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(BadFiles)
+{
+  const auto path = temp_path("TpArchive_bad");
+  {
+    std::ofstream ofs(path, std::ios::binary);
+    ofs << std::string(100, 'x');
+  }
+  BOOST_CHECK_THROW(TpArchiveReader{ path }, std::runtime_error);
+  BOOST_CHECK_THROW(TpArchiveReader{ "/nonexistent/archive.tpa" }, std::runtime_error);
+  std::remove(path.c_str());
+
+  {
+    TpArchiveWriter writer(path);
+  }
+  TpArchiveReader empty(path);
+  BOOST_REQUIRE_EQUAL(empty.n_rows(), 0);
+  std::vector<TpRow> rows;
+  BOOST_REQUIRE_EQUAL(empty.query(TpQuery{}, rows), 0);
+
+  // A width the decoders don't know would be read as 8 bytes per row, past the checked bounds
+  {
+    auto bytes = make_frames(10);
+    TpArchiveWriter writer(path);
+    writer.append_frames<wib::TpHeader, wib::TpData>(bytes.data(), bytes.size());
+  }
+  {
+    std::fstream fs(path, std::ios::in | std::ios::out | std::ios::binary);
+    tparchive::Trailer trailer;
+    fs.seekg(-static_cast<std::streamoff>(sizeof(trailer)), std::ios::end);
+    fs.read(reinterpret_cast<char*>(&trailer), sizeof(trailer));
+    const uint32_t width = 3; // NOLINT(build/unsigned)
+    fs.seekp(trailer.meta_offset + offsetof(tparchive::RowGroupMeta, columns) +
+             tparchive::kCrate * sizeof(tparchive::ColumnMeta) + offsetof(tparchive::ColumnMeta, width));
+    fs.write(reinterpret_cast<const char*>(&width), sizeof(width));
+  }
+  BOOST_CHECK_THROW(TpArchiveReader{ path }, std::runtime_error);
+  std::remove(path.c_str());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
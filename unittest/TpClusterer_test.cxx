@@ -0,0 +1,127 @@
+/**
+ * @file TpClusterer_test.cxx TpClusterer class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/TpClusterer.hpp"
+
+#define BOOST_TEST_MODULE TpClusterer_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <algorithm>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+BOOST_AUTO_TEST_SUITE(TpClusterer_test)
+
+BOOST_AUTO_TEST_CASE(TrackAndIsolatedHit)
+{
+  TpClusterer::Config config;
+  config.max_channel_gap = 1;
+  config.max_time_gap = 5;
+  TpClusterer clusterer(200, config);
+
+  std::vector<TpCluster> out;
+  auto emit = [&out](const TpCluster& c) { out.push_back(c); };
+
+  // A diagonal track over channels 10..19, one hit every 3 ticks
+  for (uint32_t i = 0; i < 10; ++i) // NOLINT(build/unsigned)
+    clusterer.add(10 + i, 100 + 3 * i, 104 + 3 * i, 102 + 3 * i, 20 + i, 100, 0, emit);
+  // An isolated hit far in channel
+  clusterer.add(150, 110, 115, 112, 500, 900, 1, emit);
+  BOOST_REQUIRE(out.empty());
+  BOOST_REQUIRE_EQUAL(clusterer.n_open(), 2);
+
+  // Moving time forward closes both
+  clusterer.add(0, 1000, 1001, 1000, 1, 1, 0, emit);
+  BOOST_REQUIRE_EQUAL(out.size(), 2);
+  std::sort(out.begin(), out.end(), [](auto& a, auto& b) { return a.channel_min < b.channel_min; });
+
+  BOOST_REQUIRE_EQUAL(out[0].n_hits, 10);
+  BOOST_REQUIRE_EQUAL(out[0].channel_min, 10);
+  BOOST_REQUIRE_EQUAL(out[0].channel_max, 19);
+  BOOST_REQUIRE_EQUAL(out[0].start_time, 100);
+  BOOST_REQUIRE_EQUAL(out[0].end_time, 131);
+  BOOST_REQUIRE_EQUAL(out[0].sum_adc, 1000);
+  BOOST_REQUIRE_EQUAL(out[0].peak_adc, 29);
+  BOOST_REQUIRE_EQUAL(out[0].peak_channel, 19);
+
+  BOOST_REQUIRE_EQUAL(out[1].n_hits, 1);
+  BOOST_REQUIRE_EQUAL(out[1].tp_flags, 1);
+
+  out.clear();
+  clusterer.flush(emit);
+  BOOST_REQUIRE_EQUAL(out.size(), 1);
+  BOOST_REQUIRE_EQUAL(clusterer.n_open(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(BridgingHitMergesClusters)
+{
+  TpClusterer::Config config;
+  config.max_channel_gap = 2;
+  config.max_time_gap = 0;
+  config.min_hits = 3;
+  TpClusterer clusterer(128, config);
+
+  std::vector<TpCluster> out;
+  auto emit = [&out](const TpCluster& c) { out.push_back(c); };
+
+  clusterer.add(60, 10, 20, 15, 5, 5, 0, emit);
+  clusterer.add(66, 10, 20, 15, 5, 5, 0, emit);
+  BOOST_REQUIRE_EQUAL(clusterer.n_open(), 2);
+  clusterer.add(63, 12, 18, 15, 9, 5, 0, emit); // more than 2 channels from both
+  BOOST_REQUIRE_EQUAL(clusterer.n_open(), 3);
+  clusterer.add(64, 13, 18, 15, 9, 5, 0, emit); // bridges 63 and 66
+  clusterer.add(62, 14, 18, 15, 9, 5, 0, emit); // bridges 60 and the rest
+  BOOST_REQUIRE_EQUAL(clusterer.n_open(), 1);
+
+  clusterer.add(127, 100, 101, 100, 1, 1, 0, emit); // closes, the new single hit stays open
+  BOOST_REQUIRE_EQUAL(out.size(), 1);
+  BOOST_REQUIRE_EQUAL(out[0].n_hits, 5);
+  BOOST_REQUIRE_EQUAL(out[0].channel_min, 60);
+  BOOST_REQUIRE_EQUAL(out[0].channel_max, 66);
+
+  out.clear();
+  clusterer.flush(emit); // below min_hits
+  BOOST_REQUIRE(out.empty());
+
+  clusterer.add(500, 200, 201, 200, 1, 1, 0, emit);
+  clusterer.add(1, 150, 151, 150, 1, 1, 0, emit);
+  BOOST_REQUIRE_EQUAL(clusterer.n_dropped_hits(), 1);
+  BOOST_REQUIRE_EQUAL(clusterer.n_out_of_order_hits(), 0);
+  clusterer.add(2, 140, 151, 150, 1, 1, 0, emit);
+  BOOST_REQUIRE_EQUAL(clusterer.n_out_of_order_hits(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(HitAfterFlushStartsNewCluster)
+{
+  TpClusterer::Config config;
+  config.max_channel_gap = 1;
+  config.max_time_gap = 5;
+  TpClusterer clusterer(64, config);
+
+  std::vector<TpCluster> out;
+  auto emit = [&out](const TpCluster& c) { out.push_back(c); };
+
+  clusterer.add(10, 100, 102, 101, 7, 7, 0, emit);
+  clusterer.flush(emit);
+  BOOST_REQUIRE_EQUAL(out.size(), 1);
+
+  // Neighbour of the flushed hit and within max_time_gap of it
+  clusterer.add(11, 101, 103, 102, 8, 8, 0, emit);
+  clusterer.add(12, 101, 103, 102, 9, 9, 0, emit);
+  BOOST_REQUIRE_EQUAL(clusterer.n_open(), 1);
+  clusterer.flush(emit);
+  BOOST_REQUIRE_EQUAL(out.size(), 2);
+  BOOST_REQUIRE_EQUAL(out[1].n_hits, 2);
+  BOOST_REQUIRE_EQUAL(out[1].channel_min, 11);
+  BOOST_REQUIRE_EQUAL(out[1].channel_max, 12);
+  BOOST_REQUIRE_EQUAL(out[1].sum_adc, 17);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
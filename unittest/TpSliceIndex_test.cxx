@@ -0,0 +1,210 @@
+/**
+ * @file TpSliceIndex_test.cxx TpSliceIndex class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/TpSliceIndex.hpp"
+
+#define BOOST_TEST_MODULE TpSliceIndex_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <cstring>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+void
+append_frame(std::vector<unsigned char>& stream, unsigned fiber, unsigned wire, uint64_t timestamp, unsigned nhits)
+{
+  fwtp::TpHeader header;
+  header.m_crate_no = 1;
+  header.m_slot_no = 2;
+  header.m_fiber_no = fiber;
+  header.m_wire_no = wire;
+  header.m_flags = 0;
+  header.m_median = 900;
+  header.m_accumulator = 0;
+  header.set_timestamp(timestamp);
+  header.set_nhits(nhits);
+  auto p = reinterpret_cast<const unsigned char*>(&header);
+  stream.insert(stream.end(), p, p + sizeof(header));
+  stream.insert(stream.end(), nhits * sizeof(fwtp::TpData), 0);
+}
+
+// channel = fiber * 256 + wire for fibers 0..3; fiber 7 is unmapped
+FwtpChannelMap
+make_map()
+{
+  FwtpChannelMap map;
+  for (unsigned fiber = 0; fiber < 4; ++fiber)
+    for (unsigned wire = 0; wire < 256; ++wire)
+      map.add(1, 2, fiber, wire, fiber * 256 + wire);
+  map.compile();
+  return map;
+}
+
+struct Expected
+{
+  uint64_t timestamp;
+  unsigned channel;
+  std::size_t offset;
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TpSliceIndex_test)
+
+BOOST_AUTO_TEST_CASE(BitmapOperations)
+{
+  std::mt19937 rng(7);
+  for (int round = 0; round < 20; ++round) {
+    std::set<uint32_t> a, b; // NOLINT(build/unsigned)
+    std::vector<uint32_t> va, vb; // NOLINT(build/unsigned)
+    for (int i = 0; i < 300; ++i) {
+      va.push_back(rng() % 5000);
+      vb.push_back(rng() % (round % 2 ? 5000 : 2000));
+    }
+    a.insert(va.begin(), va.end());
+    b.insert(vb.begin(), vb.end());
+    auto ba = ChannelBitmap::from_channels(va);
+    auto bb = ChannelBitmap::from_channels(vb);
+    BOOST_REQUIRE_EQUAL(ba.count(), a.size());
+    BOOST_REQUIRE(ba.channels() == std::vector<uint32_t>(a.begin(), a.end())); // NOLINT(build/unsigned)
+
+    std::vector<uint32_t> both, either; // NOLINT(build/unsigned)
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(both));
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(either));
+    BOOST_REQUIRE((ba & bb).channels() == both);
+    BOOST_REQUIRE((ba | bb).channels() == either);
+    BOOST_REQUIRE_EQUAL(ba.intersects(bb), !both.empty());
+    BOOST_REQUIRE(ba == ChannelBitmap::from_channels(std::vector<uint32_t>(a.rbegin(), a.rend()))); // NOLINT
+    for (uint32_t c = 0; c < 5100; c += 17) // NOLINT(build/unsigned)
+      BOOST_REQUIRE_EQUAL(ba.test(c), a.count(c) == 1);
+  }
+
+  auto r = ChannelBitmap::range(500, 1100);
+  BOOST_REQUIRE_EQUAL(r.count(), 600);
+  BOOST_REQUIRE(r.test(500) && r.test(1099) && !r.test(499) && !r.test(1100));
+  BOOST_REQUIRE(ChannelBitmap::range(10, 10).empty());
+  // Disjoint blocks intersect to nothing, and empty blocks are dropped
+  auto low = ChannelBitmap::from_channels({ 1, 2 });
+  auto high = ChannelBitmap::from_channels({ 3, 4000 });
+  BOOST_REQUIRE((low & high).empty());
+  BOOST_REQUIRE_EQUAL((low & high).n_blocks(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(RegionQueriesMatchScan)
+{
+  auto map = make_map();
+  FwtpSliceIndex::Config config;
+  config.slice_ticks = 1000;
+  FwtpSliceIndex index(map, config);
+
+  // Roughly time-ordered frames with jitter spanning slice boundaries, and some unmapped ones
+  std::mt19937_64 rng(11);
+  std::vector<unsigned char> stream;
+  std::vector<Expected> expected;
+  for (int i = 0; i < 5000; ++i) {
+    const unsigned fiber = rng() % 10 == 0 ? 7 : rng() % 4;
+    const unsigned wire = rng() % 256;
+    const uint64_t timestamp = 100000 + i * 20 + rng() % 1500;
+    if (fiber != 7)
+      expected.push_back({ timestamp, fiber * 256 + wire, stream.size() });
+    append_frame(stream, fiber, wire, timestamp, rng() % 4);
+  }
+
+  // Add in uneven pieces, each ending in a truncated frame
+  std::size_t done = 0;
+  while (done < stream.size()) {
+    const std::size_t piece = std::min<std::size_t>(stream.size() - done, 1000 + rng() % 5000);
+    done += index.add(stream.data() + done, piece);
+  }
+  BOOST_REQUIRE_EQUAL(index.bytes_indexed(), stream.size());
+  BOOST_REQUIRE_EQUAL(index.n_frames(), expected.size());
+  BOOST_REQUIRE_EQUAL(index.n_unmapped(), 5000 - expected.size());
+
+  for (int q = 0; q < 50; ++q) {
+    const uint64_t t0 = 100000 + rng() % 100000;
+    const uint64_t t1 = t0 + rng() % 5000;
+    const unsigned c0 = rng() % 1024;
+    const unsigned c1 = c0 + rng() % 200;
+
+    std::vector<std::size_t> want, got;
+    std::set<uint32_t> any; // NOLINT(build/unsigned)
+    for (auto const& e : expected) {
+      if (e.timestamp >= t0 && e.timestamp < t1 && e.channel >= c0 && e.channel < c1)
+        want.push_back(e.offset);
+      if (t1 > t0 && e.timestamp / 1000 >= t0 / 1000 && e.timestamp / 1000 <= (t1 - 1) / 1000)
+        any.insert(e.channel);
+    }
+    index.for_each_frame(stream.data(), t0, t1, c0, c1, [&](const FwtpSliceIndex::frame_t& f) {
+      got.push_back(reinterpret_cast<const unsigned char*>(f.header) - stream.data());
+    });
+    std::sort(got.begin(), got.end());
+    BOOST_REQUIRE(got == want);
+    BOOST_REQUIRE(index.active_in_any(t0, t1).channels() == std::vector<uint32_t>(any.begin(), any.end())); // NOLINT
+  }
+
+  // A channel active in every slice of a window shows up in active_in_all
+  const uint64_t s = index.slice_of(150000);
+  auto all = index.active_in_all(s * 1000, (s + 3) * 1000);
+  for (uint64_t k = s; k < s + 3; ++k) { // NOLINT(build/unsigned)
+    BOOST_REQUIRE(index.slice(k) != nullptr);
+    auto in_slice = index.slice(k)->channels;
+    BOOST_REQUIRE((in_slice & all) == all);
+  }
+  BOOST_REQUIRE(index.active_in_all(0, 5000).empty());
+}
+
+BOOST_AUTO_TEST_CASE(RunsAndErase)
+{
+  auto map = make_map();
+  FwtpSliceIndex::Config config;
+  config.slice_ticks = 100;
+  FwtpSliceIndex index(map, config);
+
+  std::vector<unsigned char> stream;
+  for (unsigned i = 0; i < 10; ++i)
+    append_frame(stream, 0, i, 1000 + i, 1); // slice 10
+  for (unsigned i = 0; i < 5; ++i)
+    append_frame(stream, 1, i, 1150, 2); // slice 11
+  append_frame(stream, 0, 200, 1020, 0); // slice 10 again, after a gap
+  BOOST_REQUIRE_EQUAL(index.add(stream.data(), stream.size()), stream.size());
+
+  BOOST_REQUIRE_EQUAL(index.n_slices(), 2);
+  auto s10 = index.slice(10);
+  BOOST_REQUIRE(s10 != nullptr);
+  BOOST_REQUIRE_EQUAL(s10->n_frames, 11);
+  BOOST_REQUIRE_EQUAL(s10->n_hits, 10);
+  BOOST_REQUIRE_EQUAL(s10->runs.size(), 2);
+  BOOST_REQUIRE_EQUAL(s10->runs[0].offset, 0);
+  BOOST_REQUIRE_EQUAL(s10->runs[0].size, 10 * (sizeof(fwtp::TpHeader) + sizeof(fwtp::TpData)));
+  BOOST_REQUIRE_EQUAL(s10->channels.count(), 11);
+  BOOST_REQUIRE(index.slice(12) == nullptr);
+
+  std::vector<TpFrameRun> runs;
+  BOOST_REQUIRE_EQUAL(index.find(1000, 1200, 256, 300, runs), 1);
+  BOOST_REQUIRE_EQUAL(runs.size(), 1);
+  BOOST_REQUIRE_EQUAL(runs[0].size, 5 * (sizeof(fwtp::TpHeader) + 2 * sizeof(fwtp::TpData)));
+  runs.clear();
+  BOOST_REQUIRE_EQUAL(index.find(1000, 1200, 600, 700, runs), 0);
+  BOOST_REQUIRE(runs.empty());
+
+  index.erase_before(1100);
+  BOOST_REQUIRE_EQUAL(index.n_slices(), 1);
+  BOOST_REQUIRE(index.slice(10) == nullptr);
+  BOOST_REQUIRE_GT(index.memory_bytes(), 0);
+
+  BOOST_REQUIRE_THROW(FwtpSliceIndex(map, { 0 }), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,128 @@
+/**
+ * @file TpStitcher_test.cxx TpStitcher class Unit Tests
+ *
+ * This is part of the DUNE DAQ Application Framework, copyright 2022.
+ * Licensing/copyright details are in the COPYING file that you should have
+ * received with this code.
+ */
+
+#include "detdataformats/TpStitcher.hpp"
+
+#define BOOST_TEST_MODULE TpStitcher_test
+
+#include "boost/test/unit_test.hpp"
+
+#include <vector>
+
+using namespace dunedaq::detdataformats;
+
+namespace {
+
+struct Hit
+{
+  unsigned start, end, peak_time, peak_adc, sum_adc;
+  bool cont;
+};
+
+void
+append_frame(std::vector<unsigned char>& bytes, unsigned wire, uint64_t timestamp, const std::vector<Hit>& hits) // NOLINT
+{
+  fwtp::TpHeader header;
+  header.m_crate_no = 1;
+  header.m_slot_no = 2;
+  header.m_fiber_no = 3;
+  header.m_wire_no = wire;
+  header.m_flags = 0;
+  header.set_timestamp(timestamp);
+  header.set_nhits(hits.size());
+  auto p = reinterpret_cast<const unsigned char*>(&header);
+  bytes.insert(bytes.end(), p, p + sizeof(header));
+  for (auto const& h : hits) {
+    fwtp::TpData d{};
+    d.m_start_time = h.start;
+    d.m_end_time = h.end;
+    d.m_peak_time = h.peak_time;
+    d.m_peak_adc = h.peak_adc;
+    d.m_sum_adc = h.sum_adc;
+    d.m_hit_continue = h.cont;
+    auto q = reinterpret_cast<const unsigned char*>(&d);
+    bytes.insert(bytes.end(), q, q + sizeof(d));
+  }
+}
+
+FwtpChannelMap
+make_map()
+{
+  FwtpChannelMap map;
+  for (unsigned wire = 0; wire < 4; ++wire)
+    map.add(1, 2, 3, wire, 100 + wire);
+  map.compile();
+  return map;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(TpStitcher_test)
+
+BOOST_AUTO_TEST_CASE(MergeAcrossFrames)
+{
+  auto map = make_map();
+  FwtpStitcher stitcher(map);
+
+  std::vector<unsigned char> bytes;
+  append_frame(bytes, 0, 1000, { { 10, 20, 15, 50, 40000, false }, { 30, 63, 40, 70, 30000, true } });
+  append_frame(bytes, 1, 1000, { { 50, 63, 55, 10, 100, true } });
+  append_frame(bytes, 0, 1064, { { 0, 12, 3, 90, 20000, false } });
+  append_frame(bytes, 9, 1064, { { 0, 12, 3, 90, 1, false } }); // unmapped wire
+
+  std::vector<StitchedHit> out;
+  auto consumed = stitcher.process(bytes.data(), bytes.size(), out);
+  BOOST_REQUIRE_EQUAL(consumed, bytes.size());
+  BOOST_REQUIRE_EQUAL(out.size(), 2);
+  BOOST_REQUIRE_EQUAL(stitcher.n_unmapped_frames(), 1);
+  BOOST_REQUIRE_EQUAL(stitcher.n_pending(), 1);
+
+  BOOST_REQUIRE_EQUAL(out[0].channel, 100);
+  BOOST_REQUIRE_EQUAL(out[0].n_fragments, 1);
+  BOOST_REQUIRE_EQUAL(out[0].start_time, 1010);
+
+  BOOST_REQUIRE_EQUAL(out[1].channel, 100);
+  BOOST_REQUIRE_EQUAL(out[1].n_fragments, 2);
+  BOOST_REQUIRE_EQUAL(out[1].start_time, 1030);
+  BOOST_REQUIRE_EQUAL(out[1].end_time, 1076);
+  BOOST_REQUIRE_EQUAL(out[1].sum_adc, 50000); // would overflow 16 bits
+  BOOST_REQUIRE_EQUAL(out[1].peak_adc, 90);
+  BOOST_REQUIRE_EQUAL(out[1].peak_time, 1067);
+  BOOST_REQUIRE(out[1].complete);
+
+  out.clear();
+  BOOST_REQUIRE_EQUAL(stitcher.flush_stale(1063, [&out](const StitchedHit& h) { out.push_back(h); }), 0);
+  BOOST_REQUIRE_EQUAL(stitcher.flush_stale(1064, [&out](const StitchedHit& h) { out.push_back(h); }), 1);
+  BOOST_REQUIRE_EQUAL(out.size(), 1);
+  BOOST_REQUIRE_EQUAL(out[0].channel, 101);
+  BOOST_REQUIRE(!out[0].complete);
+  BOOST_REQUIRE_EQUAL(stitcher.n_pending(), 0);
+  BOOST_REQUIRE_EQUAL(stitcher.n_stale_flushed(), 1);
+}
+
+BOOST_AUTO_TEST_CASE(FlushAll)
+{
+  auto map = make_map();
+  FwtpStitcher stitcher(map);
+
+  std::vector<unsigned char> bytes;
+  for (unsigned wire = 0; wire < 4; ++wire)
+    append_frame(bytes, wire, 2000, { { 1, 2, 1, 5, 5, true } });
+  bytes.resize(bytes.size() - 1); // truncate the last frame
+
+  std::vector<StitchedHit> out;
+  auto consumed = stitcher.process(bytes.data(), bytes.size(), out);
+  BOOST_REQUIRE_EQUAL(consumed, 3 * (sizeof(fwtp::TpHeader) + sizeof(fwtp::TpData)));
+  BOOST_REQUIRE(out.empty());
+  BOOST_REQUIRE_EQUAL(stitcher.n_pending(), 3);
+  BOOST_REQUIRE_EQUAL(stitcher.flush_all([&out](const StitchedHit& h) { out.push_back(h); }), 3);
+  BOOST_REQUIRE_EQUAL(out.size(), 3);
+  BOOST_REQUIRE_EQUAL(stitcher.n_pending(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()